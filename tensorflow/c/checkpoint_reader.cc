@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
@@ -36,6 +37,13 @@ CheckpointReader::CheckpointReader(const string& filename, TF_Status* status)
       v2_reader_(nullptr),
       var_to_shape_map_(nullptr),
       var_to_data_type_map_(nullptr) {
+  // The checkpoint may still be being written by an asynchronous save, in
+  // which case it looks like a V1 checkpoint until it has been written.
+  Status wait_status = AsyncCheckpointWriter::Global()->Wait(filename);
+  if (!wait_status.ok()) {
+    tsl::Set_TF_Status_from_Status(status, wait_status);
+    return;
+  }
   // Depending on whether this is a V2 ckpt, initializes "reader_" or
   // "v2_reader_".
   std::vector<string> v2_path;
@@ -15,9 +15,15 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/cc/saved_model/constants.h"
@@ -31,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph_debug_info.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
@@ -41,11 +48,13 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 
 namespace tensorflow {
 namespace {
@@ -225,6 +234,22 @@ Status RunInitOp(const RunOptions& run_options, const string& export_dir,
   return OkStatus();
 }
 
+// Returns the content fingerprint under which the variables of the SavedModel
+// at `export_dir` are shared through the SharedTensorStore, or the empty
+// string if they are not shared.
+string GetSharedCheckpointFingerprint(const RunOptions& run_options,
+                                      const string& export_dir) {
+  if (!run_options.experimental().share_restored_tensors()) return "";
+  auto fingerprint =
+      saved_model::fingerprinting::ReadSavedModelFingerprint(export_dir);
+  if (!fingerprint.ok() || fingerprint->checkpoint_hash() == 0) {
+    VLOG(1) << "Not sharing restored tensors of " << export_dir
+            << ": no checkpoint fingerprint.";
+    return "";
+  }
+  return std::to_string(fingerprint->checkpoint_hash());
+}
+
 Status RunRestore(const RunOptions& run_options, const string& export_dir,
                   const StringPiece restore_op_name,
                   const StringPiece variable_filename_const_op_name,
@@ -251,6 +276,16 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
   const string variables_path =
       io::JoinPath(variables_directory, kSavedModelVariablesFilename);
 
+  // Let the restore share tensors with other sessions that restored a
+  // checkpoint with the same content.
+  std::unique_ptr<SharedTensorStore::Registration> shared_checkpoint;
+  const string shared_fingerprint =
+      GetSharedCheckpointFingerprint(run_options, export_dir);
+  if (!shared_fingerprint.empty()) {
+    shared_checkpoint = SharedTensorStore::Global()->RegisterCheckpoint(
+        variables_path, shared_fingerprint);
+  }
+
   // Add variables to the graph.
   Tensor variables_path_tensor(DT_STRING, TensorShape({}));
   variables_path_tensor.scalar<tstring>()() = variables_path;
@@ -265,6 +300,136 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
                  nullptr /* outputs */, &run_metadata, session);
 }
 
+// Checks that the SharedTensorStore holds every tensor read by the RestoreV2
+// ops among `nodes`, a graph or a function body, from a checkpoint with content
+// `fingerprint`. Returns false if it does not, or if the tensors cannot be
+// determined, and sets `*has_restore` if there are RestoreV2 ops.
+bool SharedTensorStoreHasRestoredTensors(
+    const protobuf::RepeatedPtrField<NodeDef>& nodes, const string& fingerprint,
+    bool* has_restore) {
+  absl::flat_hash_map<StringPiece, const NodeDef*> constants;
+  for (const NodeDef& node : nodes) {
+    if (node.op() == "Const") constants[node.name()] = &node;
+  }
+  // Sets `*value` to the value of the string constant feeding `input`, e.g.
+  // "name:0" in a graph or "name:output:0" in a function.
+  auto get_constant = [&constants](StringPiece input, Tensor* value) {
+    const auto it = constants.find(input.substr(0, input.find(':')));
+    if (it == constants.end()) return false;
+    const auto attr = it->second->attr().find("value");
+    return attr != it->second->attr().end() &&
+           value->FromProto(attr->second.tensor()) &&
+           value->dtype() == DT_STRING;
+  };
+
+  for (const NodeDef& node : nodes) {
+    if (node.op() != "RestoreV2") continue;
+    Tensor tensor_names;
+    Tensor shape_and_slices;
+    if (node.input_size() < 3 || !get_constant(node.input(1), &tensor_names) ||
+        !get_constant(node.input(2), &shape_and_slices) ||
+        tensor_names.NumElements() != shape_and_slices.NumElements()) {
+      return false;
+    }
+    for (int i = 0; i < tensor_names.NumElements(); ++i) {
+      if (!SharedTensorStore::Global()->Contains(SharedTensorStore::MakeKey(
+              fingerprint, tensor_names.flat<tstring>()(i),
+              shape_and_slices.flat<tstring>()(i)))) {
+        return false;
+      }
+    }
+    *has_restore = true;
+  }
+  return true;
+}
+
+// Returns whether the SharedTensorStore holds every tensor restored by
+// `graph`, including its functions, from a checkpoint with content
+// `fingerprint`, in which case the restore reads nothing from the data files
+// of the checkpoint.
+bool SharedTensorStoreHasRestoredTensors(const GraphDef& graph,
+                                         const string& fingerprint) {
+  bool has_restore = false;
+  if (!SharedTensorStoreHasRestoredTensors(graph.node(), fingerprint,
+                                           &has_restore)) {
+    return false;
+  }
+  for (const FunctionDef& function : graph.library().function()) {
+    if (!SharedTensorStoreHasRestoredTensors(function.node_def(), fingerprint,
+                                             &has_restore)) {
+      return false;
+    }
+  }
+  return has_restore;
+}
+
+// Reads the data files of a checkpoint on a thread pool and discards the
+// data, so that a concurrent restore of the checkpoint reads it from the file
+// system's cache. The files are read in chunks, alternating between the files,
+// so that all data files are read in parallel. Stops reading when destroyed.
+class CheckpointPrefetcher {
+ public:
+  CheckpointPrefetcher(const string& variables_path, int num_threads)
+      : pool_(std::make_unique<thread::ThreadPool>(
+            Env::Default(), "restore_prefetch", num_threads)) {
+    Env* env = Env::Default();
+    std::vector<string> data_files;
+    const Status status = env->GetMatchingPaths(
+        strings::StrCat(variables_path, ".data-*"), &data_files);
+    if (!status.ok()) {
+      VLOG(1) << "Not prefetching " << variables_path << ": " << status;
+      return;
+    }
+
+    struct DataFile {
+      std::shared_ptr<RandomAccessFile> file;
+      uint64 size;
+    };
+    std::vector<DataFile> files;
+    uint64 max_file_size = 0;
+    for (const string& data_file : data_files) {
+      std::unique_ptr<RandomAccessFile> file;
+      uint64 file_size;
+      if (!env->GetFileSize(data_file, &file_size).ok() ||
+          !env->NewRandomAccessFile(data_file, &file).ok()) {
+        continue;
+      }
+      files.push_back({std::move(file), file_size});
+      max_file_size = std::max(max_file_size, file_size);
+    }
+
+    for (uint64 offset = 0; offset < max_file_size; offset += kChunkBytes) {
+      for (const DataFile& file : files) {
+        if (offset >= file.size) continue;
+        const size_t n = std::min<uint64>(kChunkBytes, file.size - offset);
+        pool_->Schedule([this, file = file.file, offset, n]() {
+          if (cancelled_.load(std::memory_order_relaxed)) return;
+          std::unique_ptr<char[]> scratch(new char[n]);
+          StringPiece result;
+          file->Read(offset, n, &result, scratch.get()).IgnoreError();
+          bytes_read_.fetch_add(result.size(), std::memory_order_relaxed);
+        });
+      }
+    }
+    if (max_file_size > 0) {
+      metrics::SavedModelRestorePrefetch("prefetched").IncrementBy(1);
+    }
+  }
+
+  ~CheckpointPrefetcher() {
+    cancelled_.store(true, std::memory_order_relaxed);
+    pool_.reset();
+    VLOG(1) << "Prefetched " << bytes_read_.load() << " checkpoint bytes";
+  }
+
+ private:
+  static constexpr size_t kChunkBytes = 8 << 20;
+
+  std::atomic<bool> cancelled_{false};
+  std::atomic<uint64> bytes_read_{0};
+  std::unique_ptr<thread::ThreadPool> pool_;
+};
+
 }  // namespace
 
 SavedModelBundleInterface::~SavedModelBundleInterface() {}
@@ -288,6 +453,28 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
+  // Reads the variables while the session is created and restores them.
+  std::unique_ptr<CheckpointPrefetcher> prefetcher;
+  const int prefetch_threads =
+      run_options.experimental().restore_prefetch_threads();
+  if (prefetch_threads > 0 && bundle->meta_graph_def.has_saver_def()) {
+    // Another session may already have restored the same variables, in which
+    // case the restore shares them rather than reading the data files.
+    const string shared_fingerprint =
+        GetSharedCheckpointFingerprint(run_options, export_dir);
+    if (!shared_fingerprint.empty() &&
+        SharedTensorStoreHasRestoredTensors(
+            bundle->meta_graph_def.graph_def(), shared_fingerprint)) {
+      VLOG(1) << "Not prefetching the variables of " << export_dir
+              << ": they are all shared.";
+      metrics::SavedModelRestorePrefetch("shared").IncrementBy(1);
+    } else {
+      prefetcher = std::make_unique<CheckpointPrefetcher>(
+          io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                       kSavedModelVariablesFilename),
+          prefetch_threads);
+    }
+  }
   TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
       session_options, bundle->meta_graph_def, &bundle->session));
   TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
@@ -100,6 +100,14 @@ auto* saved_model_read_path_and_singleprint = monitoring::Gauge<string, 0>::New(
     "graph_def_program_hash, signature_def_hash, saved_object_graph_hash, "
     "and checkpoint_hash) of the loaded SavedModel.");
 
+// Counter that tracks whether the variables of loaded SavedModels were read
+// ahead of their restore.
+auto* saved_model_restore_prefetch = monitoring::Counter<1>::New(
+    "/tensorflow/core/saved_model/read/restore_prefetch",
+    "The number of SavedModel loads whose variables were prefetched, or whose "
+    "prefetch was skipped because their tensors were shared.",
+    "outcome");
+
 // Distribution of checkpoint write durations.
 auto* checkpoint_write_durations = monitoring::Sampler<1>::New(
     {
@@ -170,6 +178,10 @@ monitoring::CounterCell& SavedModelReadApi(absl::string_view api_label) {
   return *saved_model_read_api->GetCell(std::string(api_label));
 }
 
+monitoring::CounterCell& SavedModelRestorePrefetch(absl::string_view outcome) {
+  return *saved_model_restore_prefetch->GetCell(std::string(outcome));
+}
+
 monitoring::GaugeCell<string>& SavedModelReadFingerprint() {
   return *saved_model_read_fingerprint->GetCell();
 }
@@ -93,6 +93,13 @@ monitoring::CounterCell& SavedModelWriteApi(absl::string_view api_label);
 // `foo` should be incremented when the read API `foo` is called.
 monitoring::CounterCell& SavedModelReadApi(absl::string_view api_label);
 
+// Returns "/tensorflow/core/saved_model/read/restore_prefetch" cell. This
+// metric has 1 field "outcome": the cell for "prefetched" is incremented when
+// the variables of a SavedModel were read ahead of their restore, and the cell
+// for "shared" when the read ahead was skipped because the restored tensors
+// were all shared with another session.
+monitoring::CounterCell& SavedModelRestorePrefetch(absl::string_view outcome);
+
 // Returns "/tensorflow/core/checkpoint/read/read_durations" cell belonging to
 // field `api_label`.
 monitoring::SamplerCell& CheckpointReadDuration(absl::string_view api_label);
@@ -141,6 +141,50 @@ TEST_F(LoaderTest, TagMatch) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, RestorePrefetch) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_restore_prefetch_threads(4);
+  const int64_t prefetched =
+      metrics::SavedModelRestorePrefetch("prefetched").value();
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+  EXPECT_EQ(metrics::SavedModelRestorePrefetch("prefetched").value(),
+            prefetched + 1);
+}
+
+TEST_F(LoaderTest, RestorePrefetchSkippedForSharedTensors) {
+  SessionOptions session_options;
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_restore_prefetch_threads(4);
+  run_options.mutable_experimental()->set_share_restored_tensors(true);
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kVarsAndArithmeticObjectGraph);
+  const int64_t prefetched =
+      metrics::SavedModelRestorePrefetch("prefetched").value();
+  const int64_t shared = metrics::SavedModelRestorePrefetch("shared").value();
+
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &bundle));
+  EXPECT_EQ(metrics::SavedModelRestorePrefetch("prefetched").value(),
+            prefetched + 1);
+  EXPECT_EQ(metrics::SavedModelRestorePrefetch("shared").value(), shared);
+
+  // The second load restores the tensors shared by the first one.
+  SavedModelBundle other_bundle;
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, &other_bundle));
+  EXPECT_EQ(metrics::SavedModelRestorePrefetch("prefetched").value(),
+            prefetched + 1);
+  EXPECT_EQ(metrics::SavedModelRestorePrefetch("shared").value(), shared + 1);
+}
+
 TEST_F(LoaderTest, ReadMetaGraphFromSavedModel) {
   SavedModelBundle bundle;
   SessionOptions session_options;
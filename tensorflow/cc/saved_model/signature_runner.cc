@@ -0,0 +1,208 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/signature_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the keys of `map` in increasing order.
+template <typename Map>
+std::vector<std::string> SortedKeys(const Map& map) {
+  std::vector<std::string> keys;
+  keys.reserve(map.size());
+  for (const auto& entry : map) keys.push_back(entry.first);
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+// Returns the name of the dense tensor of `tensor_info`.
+Status GetTensorName(const std::string& signature_name, const std::string& key,
+                     const TensorInfo& tensor_info, std::string* name) {
+  if (tensor_info.encoding_case() != TensorInfo::kName) {
+    return errors::Unimplemented("Tensor '", key, "' of signature '",
+                                 signature_name,
+                                 "' is not a dense tensor, which is not "
+                                 "supported by SignatureRunner");
+  }
+  *name = tensor_info.name();
+  return OkStatus();
+}
+
+}  // namespace
+
+SignatureRunner::SignatureRunner(const SavedModelBundleInterface* bundle,
+                                 const RunOptions& run_options)
+    : bundle_(bundle), run_options_(run_options) {}
+
+SignatureRunner::~SignatureRunner() {
+  std::unique_ptr<thread::ThreadPool> warmup_pool;
+  {
+    mutex_lock l(warmup_mu_);
+    warmup_pool = std::move(warmup_pool_);
+  }
+  // Waits for the pending warmups.
+  warmup_pool.reset();
+
+  mutex_lock l(mu_);
+  for (const auto& entry : entries_) {
+    if (entry.second.prepared != nullptr) {
+      bundle_->GetSession()
+          ->ReleaseCallable(entry.second.prepared->handle)
+          .IgnoreError();
+    }
+  }
+}
+
+void SignatureRunner::Warmup(const std::vector<std::string>& signature_names,
+                             int num_threads) {
+  mutex_lock l(warmup_mu_);
+  if (warmup_pool_ == nullptr) {
+    warmup_pool_ = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "signature_warmup", std::max(num_threads, 1));
+  }
+  num_pending_warmups_ += signature_names.size();
+  for (const std::string& signature_name : signature_names) {
+    warmup_pool_->Schedule([this, signature_name]() {
+      const uint64 start_micros = Env::Default()->NowMicros();
+      const Status status = Prepare(signature_name);
+      VLOG(1) << "Warmed up signature " << signature_name << " in "
+              << Env::Default()->NowMicros() - start_micros
+              << " microseconds: " << status;
+      mutex_lock l(warmup_mu_);
+      warmup_status_.Update(status);
+      if (--num_pending_warmups_ == 0) warmup_cv_.notify_all();
+    });
+  }
+}
+
+Status SignatureRunner::WaitForWarmup() {
+  mutex_lock l(warmup_mu_);
+  while (num_pending_warmups_ > 0) warmup_cv_.wait(l);
+  return warmup_status_;
+}
+
+Status SignatureRunner::Prepare(const std::string& signature_name) {
+  const PreparedSignature* prepared;
+  return GetPrepared(signature_name, &prepared);
+}
+
+Status SignatureRunner::Run(const std::string& signature_name,
+                            const std::map<std::string, Tensor>& inputs,
+                            std::map<std::string, Tensor>* outputs) {
+  const PreparedSignature* prepared;
+  TF_RETURN_IF_ERROR(GetPrepared(signature_name, &prepared));
+
+  std::vector<Tensor> feed_tensors;
+  feed_tensors.reserve(prepared->input_keys.size());
+  for (const std::string& key : prepared->input_keys) {
+    auto it = inputs.find(key);
+    if (it == inputs.end()) {
+      return errors::InvalidArgument("Missing input '", key,
+                                     "' of signature '", signature_name, "'");
+    }
+    feed_tensors.push_back(it->second);
+  }
+  if (inputs.size() != feed_tensors.size()) {
+    return errors::InvalidArgument("Signature '", signature_name, "' has ",
+                                   feed_tensors.size(), " inputs but ",
+                                   inputs.size(), " were given");
+  }
+
+  std::vector<Tensor> fetch_tensors;
+  RunMetadata run_metadata;
+  TF_RETURN_IF_ERROR(bundle_->GetSession()->RunCallable(
+      prepared->handle, feed_tensors, &fetch_tensors, &run_metadata));
+  outputs->clear();
+  for (int i = 0; i < fetch_tensors.size(); ++i) {
+    outputs->emplace(prepared->output_keys[i], std::move(fetch_tensors[i]));
+  }
+  return OkStatus();
+}
+
+Status SignatureRunner::GetPrepared(const std::string& signature_name,
+                                    const PreparedSignature** prepared) {
+  const auto& signatures = bundle_->GetSignatures();
+  auto signature_it = signatures.find(signature_name);
+  if (signature_it == signatures.end()) {
+    return errors::NotFound("Signature '", signature_name,
+                            "' does not exist in the SavedModel");
+  }
+
+  {
+    mutex_lock l(mu_);
+    Entry* entry = &entries_[signature_name];
+    // Only one thread prepares a signature; the others wait for it.
+    while (entry->prepared == nullptr && entry->preparing) {
+      prepared_cv_.wait(l);
+      entry = &entries_[signature_name];
+    }
+    if (entry->prepared != nullptr) {
+      *prepared = entry->prepared.get();
+      return OkStatus();
+    }
+    entry->preparing = true;
+  }
+
+  std::unique_ptr<PreparedSignature> new_prepared;
+  const Status status = MakePrepared(signature_name, signature_it->second,
+                                     &new_prepared);
+
+  mutex_lock l(mu_);
+  Entry& entry = entries_[signature_name];
+  entry.preparing = false;
+  if (status.ok()) {
+    entry.prepared = std::move(new_prepared);
+    *prepared = entry.prepared.get();
+  }
+  // On failure, the next call of the signature tries to prepare it again.
+  prepared_cv_.notify_all();
+  return status;
+}
+
+Status SignatureRunner::MakePrepared(
+    const std::string& signature_name, const SignatureDef& signature,
+    std::unique_ptr<PreparedSignature>* prepared) const {
+  auto new_prepared = std::make_unique<PreparedSignature>();
+  new_prepared->input_keys = SortedKeys(signature.inputs());
+  new_prepared->output_keys = SortedKeys(signature.outputs());
+
+  CallableOptions callable_options;
+  *callable_options.mutable_run_options() = run_options_;
+  for (const std::string& key : new_prepared->input_keys) {
+    TF_RETURN_IF_ERROR(GetTensorName(signature_name, key,
+                                     signature.inputs().at(key),
+                                     callable_options.add_feed()));
+  }
+  for (const std::string& key : new_prepared->output_keys) {
+    TF_RETURN_IF_ERROR(GetTensorName(signature_name, key,
+                                     signature.outputs().at(key),
+                                     callable_options.add_fetch()));
+  }
+  TF_RETURN_IF_ERROR(bundle_->GetSession()->MakeCallable(
+      callable_options, &new_prepared->handle));
+  *prepared = std::move(new_prepared);
+  return OkStatus();
+}
+
+}  // namespace tensorflow
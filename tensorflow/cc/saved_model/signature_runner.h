@@ -0,0 +1,119 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_SIGNATURE_RUNNER_H_
+#define TENSORFLOW_CC_SAVED_MODEL_SIGNATURE_RUNNER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+
+/// Runs the signatures of a loaded SavedModel by name.
+///
+/// The session of a loaded SavedModel only prunes, optimizes and instantiates
+/// the subgraph of a signature when it is first run, so loading a model with
+/// many signatures does not pay for the ones that are never used. The first
+/// call of every signature does, however. SignatureRunner prepares each
+/// signature on first use and keeps it prepared, and can prepare a list of
+/// signatures that are known to be used in the background, while the model is
+/// otherwise ready to serve.
+///
+/// This object is thread-safe.
+class SignatureRunner {
+ public:
+  /// `bundle` must outlive the SignatureRunner. The signatures are run with
+  /// `run_options`.
+  explicit SignatureRunner(const SavedModelBundleInterface* bundle,
+                           const RunOptions& run_options = RunOptions());
+
+  /// Waits for the warmup to finish and releases the prepared signatures.
+  ~SignatureRunner();
+
+  /// Starts preparing `signature_names` in the background, on up to
+  /// `num_threads` threads (only the first call creates the threads). Calls of
+  /// a signature that is being prepared wait for it to be prepared.
+  void Warmup(const std::vector<std::string>& signature_names,
+              int num_threads = 1);
+
+  /// Waits until all signatures passed to Warmup() are prepared, and returns
+  /// the first error encountered while preparing them.
+  Status WaitForWarmup();
+
+  /// Prepares `signature_name` now if it is not prepared yet.
+  Status Prepare(const std::string& signature_name);
+
+  /// Runs `signature_name`, feeding `inputs` keyed by the input keys of the
+  /// signature and storing its outputs keyed by the output keys of the
+  /// signature in `*outputs`. `inputs` must contain all inputs of the
+  /// signature.
+  Status Run(const std::string& signature_name,
+             const std::map<std::string, Tensor>& inputs,
+             std::map<std::string, Tensor>* outputs);
+
+ private:
+  struct PreparedSignature {
+    // The callable feeds and fetches the inputs and outputs in the order of
+    // their keys.
+    Session::CallableHandle handle;
+    std::vector<std::string> input_keys;
+    std::vector<std::string> output_keys;
+  };
+
+  // Preparation state of a signature.
+  struct Entry {
+    bool preparing = false;
+    std::unique_ptr<PreparedSignature> prepared;
+  };
+
+  // Returns the prepared `signature_name`, preparing it if needed.
+  Status GetPrepared(const std::string& signature_name,
+                     const PreparedSignature** prepared);
+
+  // Creates the callable of `signature`.
+  Status MakePrepared(const std::string& signature_name,
+                      const SignatureDef& signature,
+                      std::unique_ptr<PreparedSignature>* prepared) const;
+
+  const SavedModelBundleInterface* const bundle_;
+  const RunOptions run_options_;
+
+  mutex mu_;
+  condition_variable prepared_cv_;
+  absl::flat_hash_map<std::string, Entry> entries_ TF_GUARDED_BY(mu_);
+
+  mutex warmup_mu_;
+  condition_variable warmup_cv_;
+  std::unique_ptr<thread::ThreadPool> warmup_pool_ TF_GUARDED_BY(warmup_mu_);
+  int num_pending_warmups_ TF_GUARDED_BY(warmup_mu_) = 0;
+  Status warmup_status_ TF_GUARDED_BY(warmup_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SignatureRunner);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_SIGNATURE_RUNNER_H_
@@ -0,0 +1,113 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/signature_runner.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kTestData[] = "cc/saved_model/testdata/half_plus_two/00000123";
+
+class SignatureRunnerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string export_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestData);
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir,
+                                {kSavedModelTagServe}, &bundle_));
+  }
+
+  Tensor MakeExamples(const std::vector<float>& xs) {
+    std::vector<tstring> serialized_examples;
+    for (float x : xs) {
+      Example example;
+      (*example.mutable_features()->mutable_feature())["x"]
+          .mutable_float_list()
+          ->add_value(x);
+      serialized_examples.push_back(example.SerializeAsString());
+    }
+    return test::AsTensor<tstring>(serialized_examples,
+                                   TensorShape({static_cast<int64_t>(
+                                       serialized_examples.size())}));
+  }
+
+  void CheckRegressXToY(SignatureRunner* runner) {
+    std::map<string, Tensor> outputs;
+    TF_ASSERT_OK(runner->Run("regress_x_to_y",
+                             {{kRegressInputs, MakeExamples({0, 1, 2, 3})}},
+                             &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    test::ExpectTensorEqual<float>(
+        outputs.at(kRegressOutputs),
+        test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
+  }
+
+  SavedModelBundleLite bundle_;
+};
+
+TEST_F(SignatureRunnerTest, PreparesOnFirstUse) {
+  SignatureRunner runner(&bundle_);
+  CheckRegressXToY(&runner);
+  // Runs the prepared signature.
+  CheckRegressXToY(&runner);
+}
+
+TEST_F(SignatureRunnerTest, Warmup) {
+  SignatureRunner runner(&bundle_);
+  runner.Warmup({"regress_x_to_y", "regress_x_to_y2", "classify_x_to_y"},
+                /*num_threads=*/2);
+  CheckRegressXToY(&runner);
+  TF_EXPECT_OK(runner.WaitForWarmup());
+  CheckRegressXToY(&runner);
+}
+
+TEST_F(SignatureRunnerTest, WarmupReportsErrors) {
+  SignatureRunner runner(&bundle_);
+  runner.Warmup({"regress_x_to_y", "missing"});
+  EXPECT_TRUE(errors::IsNotFound(runner.WaitForWarmup()));
+  CheckRegressXToY(&runner);
+}
+
+TEST_F(SignatureRunnerTest, InvalidInputs) {
+  SignatureRunner runner(&bundle_);
+  std::map<string, Tensor> outputs;
+  EXPECT_TRUE(
+      errors::IsNotFound(runner.Run("missing", {{kRegressInputs, Tensor()}},
+                                    &outputs)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      runner.Run("regress_x_to_y", {}, &outputs)));
+  EXPECT_TRUE(errors::IsInvalidArgument(runner.Run(
+      "regress_x_to_y",
+      {{kRegressInputs, MakeExamples({0})}, {"extra", MakeExamples({0})}},
+      &outputs)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,131 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/adaptive_parallelism_controller.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+int InitialValue(int initial, int max_value) {
+  return initial > 0 ? std::min(initial, max_value) : max_value;
+}
+
+}  // namespace
+
+AdaptiveParallelismController::AdaptiveParallelismController(
+    const Options& options, Env* env)
+    : options_(options),
+      env_(env),
+      intra_op_parallelism_(
+          InitialValue(options.initial_intra_op_parallelism,
+                       std::max(1, options.max_intra_op_parallelism))) {
+  metrics::RecordAdaptiveParallelism(options_.name, intra_op_parallelism());
+}
+
+Executor::Args::Runner AdaptiveParallelismController::WrapRunner(
+    Executor::Args::Runner runner) {
+  return [self = shared_from_this(),
+          runner = std::move(runner)](Executor::Args::Closure closure) {
+    runner([self, closure = std::move(closure),
+            enqueue_usecs = self->env_->NowMicros()]() {
+      self->RecordQueueDelay(self->env_->NowMicros() - enqueue_usecs);
+      ScopedPerThreadMaxParallelism max_parallelism(
+          self->intra_op_parallelism());
+      ScopedPerThreadShardStatsRecorder recorder(self.get());
+      closure();
+    });
+  };
+}
+
+void AdaptiveParallelismController::RecordQueueDelay(int64_t usecs) {
+  mutex_lock l(stats_mu_);
+  queue_delay_usecs_ += std::max<int64_t>(usecs, 0);
+  ++num_closures_;
+}
+
+void AdaptiveParallelismController::RecordShard(int num_shards,
+                                                int64_t wall_nanos,
+                                                int64_t busy_nanos) {
+  mutex_lock l(stats_mu_);
+  shard_busy_nanos_ += busy_nanos;
+  shard_capacity_nanos_ += wall_nanos * num_shards;
+}
+
+void AdaptiveParallelismController::StepDone() {
+  const int64_t interval = std::max(1, options_.adjust_interval_steps);
+  if ((num_steps_.fetch_add(1, std::memory_order_relaxed) + 1) % interval ==
+      0) {
+    Adjust();
+  }
+}
+
+void AdaptiveParallelismController::Adjust() {
+  int64_t mean_queue_delay_usecs = 0;
+  bool have_shards = false;
+  double efficiency = 1.0;
+  {
+    mutex_lock l(stats_mu_);
+    if (num_closures_ > 0) {
+      mean_queue_delay_usecs = queue_delay_usecs_ / num_closures_;
+    }
+    if (shard_capacity_nanos_ > 0) {
+      have_shards = true;
+      efficiency = std::min(1.0, static_cast<double>(shard_busy_nanos_) /
+                                     shard_capacity_nanos_);
+    }
+    queue_delay_usecs_ = 0;
+    num_closures_ = 0;
+    shard_busy_nanos_ = 0;
+    shard_capacity_nanos_ = 0;
+  }
+
+  const int max_intra = std::max(1, options_.max_intra_op_parallelism);
+  const int old_intra = intra_op_parallelism();
+  int intra = old_intra;
+
+  if (mean_queue_delay_usecs > options_.target_queue_delay_usecs) {
+    // Closures are waiting for an inter-op thread: give each kernel fewer
+    // threads so that the cores go to the waiting closures.
+    intra = std::max(1, intra / 2);
+  } else if (have_shards && efficiency < options_.low_intra_op_efficiency) {
+    // Shards mostly wait on each other or on the pool.
+    intra = std::max(1, std::min(intra - 1, intra * 3 / 4));
+  } else if (have_shards && efficiency >= options_.high_intra_op_efficiency &&
+             mean_queue_delay_usecs <= options_.target_queue_delay_usecs / 2 &&
+             intra < max_intra) {
+    intra = std::min(max_intra, intra + std::max(1, intra / 4));
+  }
+
+  if (intra != old_intra) {
+    VLOG(1) << "Adaptive parallelism for " << options_.name << ": intra_op "
+            << old_intra << " -> " << intra << " (queue delay "
+            << mean_queue_delay_usecs << "us, intra-op efficiency "
+            << efficiency << ")";
+  }
+  intra_op_parallelism_.store(intra, std::memory_order_relaxed);
+
+  metrics::RecordAdaptiveParallelism(options_.name, intra);
+  metrics::RecordAdaptiveParallelismSignals(
+      options_.name, mean_queue_delay_usecs,
+      have_shards ? static_cast<int64_t>(efficiency * 100) : 100);
+}
+
+}  // namespace tensorflow
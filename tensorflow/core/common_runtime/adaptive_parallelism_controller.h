@@ -0,0 +1,125 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ADAPTIVE_PARALLELISM_CONTROLLER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ADAPTIVE_PARALLELISM_CONTROLLER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Adjusts the effective intra-op parallelism of a session at runtime, based on
+// the measured queueing delay of its inter-op closures and the parallel
+// efficiency of the Shard() calls made by its kernels.
+//
+// Thread pools cannot be resized once created, so the controller enforces its
+// decisions on top of them: the intra-op parallelism is installed as the
+// per-thread max parallelism (see `ScopedPerThreadMaxParallelism`) of every
+// closure scheduled through a runner returned by `WrapRunner()`, which caps
+// Shard() and the Eigen thread pool device used by CPU kernels.
+//
+// Inter-op closures are never held back. They may block on each other (Recv,
+// queues, collectives, nested function calls), so running fewer of them than
+// the pool has threads can deadlock. Their queueing delay in the pool is used
+// as a signal instead: while closures wait for a thread, kernels get fewer
+// intra-op threads, leaving more cores to the inter-op pool.
+//
+// Every `adjust_interval_steps` calls to `StepDone()`, the controller shrinks
+// intra-op parallelism while closures are queueing or shards are mostly idle,
+// and grows it back when shards are efficient and nothing is waiting. The
+// decisions and the signals they are based on are exported through
+// `metrics::RecordAdaptiveParallelism*`.
+//
+// Must be owned by a std::shared_ptr, since runners returned by
+// `WrapRunner()` keep the controller alive until their closures finish.
+class AdaptiveParallelismController
+    : public ShardStatsRecorder,
+      public std::enable_shared_from_this<AdaptiveParallelismController> {
+ public:
+  struct Options {
+    // Label of the exported metrics.
+    string name;
+
+    // Upper bound, normally the size of the intra-op pool.
+    int max_intra_op_parallelism = 1;
+
+    // Starting point. Values <= 0 mean `max_intra_op_parallelism`.
+    int initial_intra_op_parallelism = 0;
+
+    // Number of steps between two adjustments.
+    int adjust_interval_steps = 16;
+
+    // Mean inter-op queueing delay above which intra-op parallelism shrinks.
+    int64_t target_queue_delay_usecs = 500;
+
+    // Intra-op efficiency below which intra-op parallelism shrinks, and above
+    // which it may grow.
+    double low_intra_op_efficiency = 0.5;
+    double high_intra_op_efficiency = 0.8;
+  };
+
+  explicit AdaptiveParallelismController(const Options& options,
+                                         Env* env = Env::Default());
+
+  int intra_op_parallelism() const {
+    return intra_op_parallelism_.load(std::memory_order_relaxed);
+  }
+
+  // Returns a runner that schedules closures on `runner`, subject to the
+  // current intra-op parallelism.
+  Executor::Args::Runner WrapRunner(Executor::Args::Runner runner);
+
+  // Signals that one step of the session has finished.
+  void StepDone();
+
+  // Records that one inter-op closure waited `usecs` before it started.
+  // Called by runners returned from `WrapRunner()`.
+  void RecordQueueDelay(int64_t usecs);
+
+  // ShardStatsRecorder implementation.
+  void RecordShard(int num_shards, int64_t wall_nanos,
+                   int64_t busy_nanos) override;
+
+ private:
+  void Adjust();
+
+  const Options options_;
+  Env* const env_;
+
+  std::atomic<int> intra_op_parallelism_;
+  std::atomic<int64_t> num_steps_{0};
+
+  // Signals accumulated since the last adjustment.
+  mutex stats_mu_;
+  int64_t queue_delay_usecs_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t num_closures_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t shard_busy_nanos_ TF_GUARDED_BY(stats_mu_) = 0;
+  int64_t shard_capacity_nanos_ TF_GUARDED_BY(stats_mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveParallelismController);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ADAPTIVE_PARALLELISM_CONTROLLER_H_
@@ -0,0 +1,114 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/adaptive_parallelism_controller.h"
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+std::shared_ptr<AdaptiveParallelismController> NewController(
+    int max_intra, int initial_intra = 0) {
+  AdaptiveParallelismController::Options options;
+  options.name = "test";
+  options.max_intra_op_parallelism = max_intra;
+  options.initial_intra_op_parallelism = initial_intra;
+  options.adjust_interval_steps = 1;
+  options.target_queue_delay_usecs = 100;
+  options.low_intra_op_efficiency = 0.5;
+  options.high_intra_op_efficiency = 0.8;
+  return std::make_shared<AdaptiveParallelismController>(options);
+}
+
+TEST(AdaptiveParallelismControllerTest, StartsAtMaximum) {
+  auto controller = NewController(8);
+  EXPECT_EQ(controller->intra_op_parallelism(), 8);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 8);
+}
+
+TEST(AdaptiveParallelismControllerTest, QueueingShrinksIntraOp) {
+  auto controller = NewController(8);
+  controller->RecordQueueDelay(1000);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 4);
+
+  controller->RecordQueueDelay(1000);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 2);
+}
+
+TEST(AdaptiveParallelismControllerTest, LowEfficiencyShrinksIntraOp) {
+  auto controller = NewController(8);
+  controller->RecordShard(8, /*wall_nanos=*/1000, /*busy_nanos=*/2000);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 6);
+
+  controller->RecordShard(6, 1000, 1000);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 4);
+}
+
+TEST(AdaptiveParallelismControllerTest, HighEfficiencyGrowsIntraOp) {
+  auto controller = NewController(8, /*initial_intra=*/2);
+  controller->RecordShard(2, 1000, 1900);
+  controller->StepDone();
+  EXPECT_EQ(controller->intra_op_parallelism(), 3);
+
+  for (int i = 0; i < 10; ++i) {
+    controller->RecordShard(2, 1000, 2000);
+    controller->StepDone();
+  }
+  EXPECT_EQ(controller->intra_op_parallelism(), 8);
+}
+
+TEST(AdaptiveParallelismControllerTest, WrappedRunnerRunsBlockingClosures) {
+  auto controller = NewController(3, /*initial_intra=*/1);
+  // Queueing, as reported by the closures below, shrinks the intra-op
+  // parallelism but must never hold closures back.
+  controller->RecordQueueDelay(1000);
+  controller->StepDone();
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  Executor::Args::Runner runner = controller->WrapRunner(
+      [&pool](Executor::Args::Closure c) { pool.Schedule(std::move(c)); });
+
+  // Every closure waits for all the others, like kernels blocked on a Recv.
+  constexpr int kNumClosures = 4;
+  BlockingCounter started(kNumClosures);
+  BlockingCounter done(kNumClosures);
+  std::atomic<int> max_intra_op(0);
+  for (int i = 0; i < kNumClosures; ++i) {
+    runner([&]() {
+      started.DecrementCount();
+      started.Wait();
+      max_intra_op.store(GetPerThreadMaxParallelism());
+      EXPECT_EQ(GetPerThreadShardStatsRecorder(), controller.get());
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_EQ(max_intra_op.load(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
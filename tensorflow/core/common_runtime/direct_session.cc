@@ -367,6 +367,21 @@ DirectSession::DirectSession(const SessionOptions& options,
   }
   session_handle_ =
       strings::StrCat("direct", strings::FpToString(random::New64()));
+  if (options_.config.experimental().use_adaptive_thread_parallelism() &&
+      !run_in_caller_thread_ && thread_pools_[0].first != nullptr) {
+    int num_intra_threads = options_.config.intra_op_parallelism_threads();
+    if (num_intra_threads <= 0) {
+      num_intra_threads = NumIntraOpThreadsFromEnvironment();
+    }
+    if (num_intra_threads <= 0) {
+      num_intra_threads = port::MaxParallelism();
+    }
+    AdaptiveParallelismController::Options controller_options;
+    controller_options.name = session_handle_;
+    controller_options.max_intra_op_parallelism = num_intra_threads;
+    adaptive_parallelism_ =
+        std::make_shared<AdaptiveParallelismController>(controller_options);
+  }
   int devices_added = 0;
   if (options.config.log_device_placement()) {
     const string mapping_str = device_mgr_->DeviceMappingString();
@@ -414,6 +429,9 @@ DirectSession::~DirectSession() {
 
   execution_state_.reset(nullptr);
   flib_def_.reset(nullptr);
+  if (adaptive_parallelism_ != nullptr) {
+    metrics::RemoveAdaptiveParallelism(session_handle_);
+  }
 }
 
 Status DirectSession::Create(const GraphDef& graph) {
@@ -716,6 +734,11 @@ Status DirectSession::RunInternal(
 
   Status run_status;
 
+  if (adaptive_parallelism_ != nullptr && pool != nullptr) {
+    default_runner =
+        adaptive_parallelism_->WrapRunner(std::move(default_runner));
+  }
+
   auto set_threadpool_args_for_item =
       [&default_runner, &handler](const PerPartitionExecutorsAndLib& item,
                                   Executor::Args* args) {
@@ -741,7 +764,8 @@ Status DirectSession::RunInternal(
       };
 
   if (can_execute_synchronously) {
-    PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
+    PrivateIntraProcessRendezvous rendezvous(
+        device_mgr_.get(), executors_and_keys->num_rendezvous_slots);
     args.rendezvous = &rendezvous;
 
     const auto& item = executors_and_keys->items[0];
@@ -749,7 +773,8 @@ Status DirectSession::RunInternal(
     run_status = item.executor->Run(args);
   } else {
     core::RefCountPtr<RefCountedIntraProcessRendezvous> rendezvous(
-        new RefCountedIntraProcessRendezvous(device_mgr_.get()));
+        new RefCountedIntraProcessRendezvous(
+            device_mgr_.get(), executors_and_keys->num_rendezvous_slots));
     args.rendezvous = rendezvous.get();
 
     // `barrier` will delete itself after the final executor finishes.
@@ -777,6 +802,10 @@ Status DirectSession::RunInternal(
     }
   }
 
+  if (adaptive_parallelism_ != nullptr && pool != nullptr) {
+    adaptive_parallelism_->StepDone();
+  }
+
   if (step_cancellation_manager.IsCancelled()) {
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
@@ -989,7 +1018,8 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   args.step_id = step_id_counter_.fetch_add(1);
   PartialRunState* run_state =
       new PartialRunState(input_names, output_names, args.step_id, &devices_);
-  run_state->rendez.reset(new IntraProcessRendezvous(device_mgr_.get()));
+  run_state->rendez.reset(new IntraProcessRendezvous(
+      device_mgr_.get(), executors_and_keys->num_rendezvous_slots));
   {
     mutex_lock l(executor_lock_);
     if (!partial_runs_
@@ -1340,7 +1370,8 @@ Status DirectSession::CreateExecutors(
   std::unordered_map<string, std::unique_ptr<Graph>> graphs;
   TF_RETURN_IF_ERROR(CreateGraphs(
       options, &graphs, &func_info->flib_def, run_state_args, &ek->input_types,
-      &ek->output_types, &ek->collective_graph_key));
+      &ek->output_types, &ek->collective_graph_key,
+      &ek->num_rendezvous_slots));
 
   if (run_state_args->is_partial_run) {
     ek->graph = std::move(run_state_args->graph);
@@ -1608,7 +1639,8 @@ Status DirectSession::CreateGraphs(
     std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
     std::unique_ptr<FunctionLibraryDefinition>* flib_def,
     RunStateArgs* run_state_args, DataTypeVector* input_types,
-    DataTypeVector* output_types, int64_t* collective_graph_key) {
+    DataTypeVector* output_types, int64_t* collective_graph_key,
+    int64_t* num_rendezvous_slots) {
   mutex_lock l(graph_state_lock_);
   if (finalized_) {
     return errors::FailedPrecondition("Session has been finalized.");
@@ -1696,9 +1728,16 @@ Status DirectSession::CreateGraphs(
   };
   popts.flib_def = flib_def->get();
   popts.control_flow_added = false;
+  // Every partition runs once per step against a fresh rendezvous, so each
+  // Send/Recv pair can be given its own slot.
+  int64_t next_rendezvous_slot = 0;
+  popts.get_rendezvous_slot = [&next_rendezvous_slot](const Edge*) {
+    return next_rendezvous_slot++;
+  };
 
   std::unordered_map<string, GraphDef> partitions;
   TF_RETURN_IF_ERROR(Partition(popts, &client_graph->graph, &partitions));
+  *num_rendezvous_slots = next_rendezvous_slot;
 
   std::vector<string> device_names;
   device_names.reserve(devices_.size());
@@ -23,6 +23,7 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/adaptive_parallelism_controller.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -176,6 +177,10 @@ class DirectSession : public Session {
     CallableOptions callable_options;
 
     int64_t collective_graph_key = BuildGraphOptions::kNoCollectiveGraphKey;
+
+    // Number of rendezvous slots assigned to Send/Recv pairs when the graph
+    // was partitioned. Each step's rendezvous is created with this many slots.
+    int64_t num_rendezvous_slots = 0;
   };
 
   // A FunctionInfo object is created for every unique set of feeds/fetches.
@@ -261,7 +266,8 @@ class DirectSession : public Session {
       std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
       std::unique_ptr<FunctionLibraryDefinition>* flib_def,
       RunStateArgs* run_state_args, DataTypeVector* input_types,
-      DataTypeVector* output_types, int64_t* collective_graph_key);
+      DataTypeVector* output_types, int64_t* collective_graph_key,
+      int64_t* num_rendezvous_slots);
 
   ::tensorflow::Status RunInternal(
       int64_t step_id, const RunOptions& run_options,
@@ -350,6 +356,10 @@ class DirectSession : public Session {
   // is owned.
   std::vector<std::pair<thread::ThreadPool*, bool>> thread_pools_;
 
+  // Adjusts the effective intra-op parallelism of this session if
+  // ConfigProto.Experimental.use_adaptive_thread_parallelism is set.
+  std::shared_ptr<AdaptiveParallelismController> adaptive_parallelism_;
+
   Status init_error_;  // Set to an error if construction failed.
 
   // If true, blocks until device has finished all queued operations in a step.
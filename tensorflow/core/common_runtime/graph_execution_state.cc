@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <string>
@@ -24,9 +25,11 @@ limitations under the License.
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/optimized_graph_cache.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/placer.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -58,7 +61,9 @@ limitations under the License.
 #ifndef IS_MOBILE_PLATFORM
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
+#include "tensorflow/core/util/xla_config_registry.h"
 #endif  // IS_MOBILE_PLATFORM
 
 namespace tensorflow {
@@ -69,6 +74,55 @@ bool IsCollectiveV2(const string& op) {
          op == "CollectiveBcastRecvV2" || op == "CollectiveBcastSendV2" ||
          op == "ColectiveReduceScatterV2" || op == "ColectiveAllToAllV2";
 }
+
+#ifndef IS_MOBILE_PLATFORM
+// Returns the state of this process that the MetaOptimizer's output for
+// `cluster` depends on, besides `config`.
+GraphOptimizationEnvironment GetGraphOptimizationEnvironment(
+    const grappler::Cluster& cluster, const ConfigProto& config) {
+  GraphOptimizationEnvironment environment;
+  std::set<string> device_types;
+  for (const auto& device : cluster.GetDevices()) {
+    environment.devices.emplace(device.first, device.second);
+    device_types.insert(device.second.type());
+  }
+  environment.mkl_enabled = IsMKLEnabled();
+
+  environment.optimizers =
+      grappler::CustomGraphOptimizerRegistry::GetRegisteredOptimizers();
+  std::sort(environment.optimizers.begin(), environment.optimizers.end());
+  for (const auto& optimizer :
+       grappler::PluginGraphOptimizerRegistry::CreateOptimizers(
+           device_types)) {
+    environment.optimizers.push_back(
+        absl::StrCat("plugin:", optimizer->name()));
+  }
+  const grappler::ConfigList plugin_configs =
+      grappler::PluginGraphOptimizerRegistry::GetPluginConfigs(
+          config.graph_options().rewrite_options().use_plugin_optimizers() !=
+              RewriterConfig::OFF,
+          device_types);
+  environment.optimizers.push_back(
+      absl::StrCat("plugin_disable_model_pruning:",
+                   plugin_configs.disable_model_pruning ? 1 : 0));
+  std::vector<string> plugin_toggles;
+  for (const auto& toggle : plugin_configs.toggle_config) {
+    plugin_toggles.push_back(
+        absl::StrCat("plugin_toggle:", toggle.first, "=",
+                     static_cast<int>(toggle.second)));
+  }
+  std::sort(plugin_toggles.begin(), plugin_toggles.end());
+  environment.optimizers.insert(environment.optimizers.end(),
+                                plugin_toggles.begin(), plugin_toggles.end());
+
+  const xla_config_registry::XlaGlobalJitLevel jit_level =
+      xla_config_registry::GetGlobalJitLevel(
+          config.graph_options().optimizer_options().global_jit_level());
+  environment.xla_jit_level_single_gpu = jit_level.single_gpu;
+  environment.xla_jit_level_general = jit_level.general;
+  return environment;
+}
+#endif  // IS_MOBILE_PLATFORM
 }  // namespace
 
 GraphExecutionState::GraphExecutionState(
@@ -810,11 +864,41 @@ Status GraphExecutionState::OptimizeGraph(
       }
     }
 
-    // Now we can run the MetaOptimizer on the constructed GrapplerItem.
+    // Reuse the optimized graph from the cache, if there is one.
+    const string& cache_dir =
+        session_options_->config.experimental().optimized_graph_cache_dir();
+    std::unique_ptr<OptimizedGraphCache> cache;
+    uint64 cache_key = 0;
     GraphDef new_graph;
-    TF_RETURN_IF_ERROR(
-        grappler::RunMetaOptimizer(std::move(item), session_options_->config,
-                                   cpu_device, &cluster, &new_graph));
+    bool cache_hit = false;
+    if (!cache_dir.empty()) {
+      cache = std::make_unique<OptimizedGraphCache>(Env::Default(), cache_dir);
+      std::vector<string> feeds;
+      for (const auto& feed : item.feed) feeds.push_back(feed.first);
+      std::vector<string> devices(item.devices().begin(),
+                                  item.devices().end());
+      std::sort(devices.begin(), devices.end());
+      cache_key = OptimizedGraphCache::Fingerprint(
+          item.graph, feeds, item.fetch, devices, session_options_->config,
+          GetGraphOptimizationEnvironment(cluster, session_options_->config));
+      cache_hit = cache->Lookup(cache_key, &new_graph);
+      VLOG(1) << "Optimized graph cache " << (cache_hit ? "hit" : "miss")
+              << " for key " << cache_key;
+    }
+
+    if (!cache_hit) {
+      // Now we can run the MetaOptimizer on the constructed GrapplerItem.
+      TF_RETURN_IF_ERROR(
+          grappler::RunMetaOptimizer(std::move(item), session_options_->config,
+                                     cpu_device, &cluster, &new_graph));
+      if (cache != nullptr) {
+        const Status insert_status = cache->Insert(cache_key, new_graph);
+        if (!insert_status.ok()) {
+          LOG(WARNING) << "Failed to cache the optimized graph in "
+                       << cache_dir << ": " << insert_status;
+        }
+      }
+    }
 
     // Merge optimized graph function library with an original library.
     // Optimized graph might have new functions specialized for it's
@@ -0,0 +1,140 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+uint64 FingerprintStrings(const std::vector<std::string>& strings,
+                          uint64 fingerprint) {
+  fingerprint = Hash64Combine(fingerprint, strings.size());
+  for (const std::string& s : strings) {
+    fingerprint = Hash64Combine(fingerprint, Fingerprint64(s));
+  }
+  return fingerprint;
+}
+
+// Fingerprints `graph` independently of the order of its function library,
+// which is not deterministic across processes.
+uint64 FingerprintGraph(const GraphDef& graph, uint64 fingerprint) {
+  fingerprint = Hash64Combine(fingerprint, graph.node_size());
+  for (const NodeDef& node : graph.node()) {
+    fingerprint = Hash64Combine(fingerprint, DeterministicProtoHash64(node));
+  }
+  fingerprint =
+      Hash64Combine(fingerprint, DeterministicProtoHash64(graph.versions()));
+
+  std::vector<std::pair<std::string, uint64>> functions;
+  for (const FunctionDef& function : graph.library().function()) {
+    functions.emplace_back(function.signature().name(),
+                           DeterministicProtoHash64(function));
+  }
+  for (const GradientDef& gradient : graph.library().gradient()) {
+    functions.emplace_back(gradient.function_name(),
+                           DeterministicProtoHash64(gradient));
+  }
+  std::sort(functions.begin(), functions.end());
+  fingerprint = Hash64Combine(fingerprint, functions.size());
+  for (const auto& function : functions) {
+    fingerprint = Hash64Combine(fingerprint, Fingerprint64(function.first));
+    fingerprint = Hash64Combine(fingerprint, function.second);
+  }
+  return fingerprint;
+}
+
+uint64 FingerprintEnvironment(const GraphOptimizationEnvironment& environment,
+                              uint64 fingerprint) {
+  fingerprint = Hash64Combine(fingerprint, environment.devices.size());
+  for (const auto& device : environment.devices) {
+    fingerprint = Hash64Combine(fingerprint, Fingerprint64(device.first));
+    fingerprint =
+        Hash64Combine(fingerprint, DeterministicProtoHash64(device.second));
+  }
+  fingerprint = Hash64Combine(fingerprint, environment.mkl_enabled);
+  fingerprint = FingerprintStrings(environment.optimizers, fingerprint);
+  fingerprint =
+      Hash64Combine(fingerprint, environment.xla_jit_level_single_gpu);
+  return Hash64Combine(fingerprint, environment.xla_jit_level_general);
+}
+
+}  // namespace
+
+uint64 OptimizedGraphCache::Fingerprint(
+    const GraphDef& graph, const std::vector<std::string>& feeds,
+    const std::vector<std::string>& fetches,
+    const std::vector<std::string>& devices, const ConfigProto& config,
+    const GraphOptimizationEnvironment& environment) {
+  // The location of the cache does not affect the optimization.
+  ConfigProto config_without_cache(config);
+  config_without_cache.mutable_experimental()
+      ->clear_optimized_graph_cache_dir();
+
+  // Grappler may optimize differently in another version of TensorFlow.
+  uint64 fingerprint = Fingerprint64(TF_VERSION_STRING);
+  fingerprint = Hash64Combine(fingerprint, TF_GRAPH_DEF_VERSION);
+  fingerprint = FingerprintGraph(graph, fingerprint);
+  fingerprint = FingerprintStrings(feeds, fingerprint);
+  fingerprint = FingerprintStrings(fetches, fingerprint);
+  fingerprint = FingerprintStrings(devices, fingerprint);
+  fingerprint = FingerprintEnvironment(environment, fingerprint);
+  return Hash64Combine(fingerprint,
+                       DeterministicProtoHash64(config_without_cache));
+}
+
+bool OptimizedGraphCache::Lookup(uint64 key, GraphDef* graph) const {
+  const std::string path = FilePath(key);
+  if (!env_->FileExists(path).ok()) return false;
+  const Status status = ReadBinaryProto(env_, path, graph);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read optimized graph from " << path << ": "
+                 << status;
+    return false;
+  }
+  return true;
+}
+
+Status OptimizedGraphCache::Insert(uint64 key, const GraphDef& graph) const {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+  // Writes to a unique temporary file first, so that readers never see a
+  // partially written graph, even if several processes insert it at once.
+  const std::string path = FilePath(key);
+  const std::string temp_path =
+      absl::StrFormat("%s.tmp-%016x", path, random::New64());
+  Status status = WriteBinaryProto(env_, temp_path, graph);
+  if (status.ok()) status = env_->RenameFile(temp_path, path);
+  if (!status.ok()) env_->DeleteFile(temp_path).IgnoreError();
+  return status;
+}
+
+std::string OptimizedGraphCache::FilePath(uint64 key) const {
+  return io::JoinPath(directory_, absl::StrFormat("%016x.pb", key));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+
+// The state of the process that Grappler's output depends on, besides the
+// graph and the ConfigProto.
+struct GraphOptimizationEnvironment {
+  // Properties of the devices of the cluster optimized for, by name.
+  std::map<std::string, DeviceProperties> devices;
+  // Whether oneDNN rewrites are enabled, e.g. by TF_ENABLE_ONEDNN_OPTS.
+  bool mkl_enabled = false;
+  // The registered custom and plugin graph optimizers, and the configs of the
+  // plugins.
+  std::vector<std::string> optimizers;
+  // The XLA auto-jit levels, which TF_XLA_FLAGS may override.
+  OptimizerOptions::GlobalJitLevel xla_jit_level_single_gpu =
+      OptimizerOptions::DEFAULT;
+  OptimizerOptions::GlobalJitLevel xla_jit_level_general =
+      OptimizerOptions::DEFAULT;
+};
+
+// A persistent cache of graphs optimized by Grappler, stored as one binary
+// GraphDef (including its function library) per file in a directory.
+//
+// Entries are keyed by a fingerprint of everything the optimization depends
+// on, including the state of the process, so that processes sharing the
+// directory, e.g. successive restarts of a server loading the same SavedModel,
+// reuse the graphs optimized by the first of them. Entries are written
+// atomically and never invalidated; a stale directory can be deleted at any
+// time.
+class OptimizedGraphCache {
+ public:
+  OptimizedGraphCache(Env* env, std::string directory)
+      : env_(env), directory_(std::move(directory)) {}
+
+  // Returns the key of the optimization of `graph` (placed, with its function
+  // library) for the given feeds, fetches and devices under `config`, in a
+  // process in the given `environment`.
+  static uint64 Fingerprint(const GraphDef& graph,
+                            const std::vector<std::string>& feeds,
+                            const std::vector<std::string>& fetches,
+                            const std::vector<std::string>& devices,
+                            const ConfigProto& config,
+                            const GraphOptimizationEnvironment& environment);
+
+  // Reads the graph cached for `key` into `*graph`. Returns false if there is
+  // none or it cannot be read.
+  bool Lookup(uint64 key, GraphDef* graph) const;
+
+  // Caches `graph` for `key`, replacing any graph cached for it.
+  Status Insert(uint64 key, const GraphDef& graph) const;
+
+ private:
+  std::string FilePath(uint64 key) const;
+
+  Env* const env_;
+  const std::string directory_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_OPTIMIZED_GRAPH_CACHE_H_
@@ -0,0 +1,129 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/optimized_graph_cache.h"
+
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace {
+
+GraphDef MakeGraph(const std::vector<std::string>& function_names) {
+  GraphDef graph;
+  NodeDef* node = graph.add_node();
+  node->set_name("a");
+  node->set_op("Const");
+  node->set_device("/job:localhost/replica:0/task:0/device:CPU:0");
+  for (const std::string& name : function_names) {
+    graph.mutable_library()->add_function()->mutable_signature()->set_name(
+        name);
+  }
+  return graph;
+}
+
+uint64 Fingerprint(const GraphDef& graph, const ConfigProto& config,
+                   const GraphOptimizationEnvironment& environment = {}) {
+  return OptimizedGraphCache::Fingerprint(
+      graph, {"a:0"}, {"b:0"}, {"/job:localhost/replica:0/task:0/device:CPU:0"},
+      config, environment);
+}
+
+TEST(OptimizedGraphCacheTest, Fingerprint) {
+  const GraphDef graph = MakeGraph({"f", "g"});
+  ConfigProto config;
+  const uint64 fingerprint = Fingerprint(graph, config);
+
+  // The order of the function library and the cache directory do not matter.
+  EXPECT_EQ(Fingerprint(MakeGraph({"g", "f"}), config), fingerprint);
+  ConfigProto cached_config;
+  cached_config.mutable_experimental()->set_optimized_graph_cache_dir("/tmp");
+  EXPECT_EQ(Fingerprint(graph, cached_config), fingerprint);
+
+  // Everything else does.
+  EXPECT_NE(Fingerprint(MakeGraph({"f"}), config), fingerprint);
+  GraphDef other_graph = graph;
+  other_graph.mutable_node(0)->set_device("/device:GPU:0");
+  EXPECT_NE(Fingerprint(other_graph, config), fingerprint);
+  ConfigProto other_config;
+  other_config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  EXPECT_NE(Fingerprint(graph, other_config), fingerprint);
+  EXPECT_NE(
+      OptimizedGraphCache::Fingerprint(graph, {}, {"b:0"}, {}, config, {}),
+      OptimizedGraphCache::Fingerprint(graph, {"b:0"}, {}, {}, config, {}));
+}
+
+TEST(OptimizedGraphCacheTest, FingerprintEnvironment) {
+  const GraphDef graph = MakeGraph({"f"});
+  const ConfigProto config;
+  GraphOptimizationEnvironment environment;
+  DeviceProperties cpu;
+  cpu.set_type("CPU");
+  cpu.set_num_cores(8);
+  environment.devices["/job:localhost/replica:0/task:0/device:CPU:0"] = cpu;
+  environment.optimizers = {"CustomOptimizer"};
+  const uint64 fingerprint = Fingerprint(graph, config, environment);
+  EXPECT_EQ(Fingerprint(graph, config, environment), fingerprint);
+
+  // Any change to the environment misses the cache.
+  GraphOptimizationEnvironment other = environment;
+  other.devices.begin()->second.set_num_cores(16);
+  EXPECT_NE(Fingerprint(graph, config, other), fingerprint);
+  other = environment;
+  other.mkl_enabled = true;
+  EXPECT_NE(Fingerprint(graph, config, other), fingerprint);
+  other = environment;
+  other.optimizers.push_back("plugin:PluginOptimizer");
+  EXPECT_NE(Fingerprint(graph, config, other), fingerprint);
+  other = environment;
+  other.xla_jit_level_single_gpu = OptimizerOptions::ON_1;
+  EXPECT_NE(Fingerprint(graph, config, other), fingerprint);
+  other = environment;
+  other.xla_jit_level_general = OptimizerOptions::ON_2;
+  EXPECT_NE(Fingerprint(graph, config, other), fingerprint);
+}
+
+TEST(OptimizedGraphCacheTest, InsertAndLookup) {
+  const std::string directory =
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache_test");
+  OptimizedGraphCache cache(Env::Default(), directory);
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup(1, &graph));
+
+  const GraphDef optimized_graph = MakeGraph({"f"});
+  TF_ASSERT_OK(cache.Insert(1, optimized_graph));
+  ASSERT_TRUE(cache.Lookup(1, &graph));
+  EXPECT_EQ(graph.DebugString(), optimized_graph.DebugString());
+  EXPECT_FALSE(cache.Lookup(2, &graph));
+
+  // Another cache on the same directory, e.g. in a restarted process, sees
+  // the graph, and can replace it.
+  OptimizedGraphCache other_cache(Env::Default(), directory);
+  ASSERT_TRUE(other_cache.Lookup(1, &graph));
+  EXPECT_EQ(graph.DebugString(), optimized_graph.DebugString());
+  const GraphDef new_optimized_graph = MakeGraph({"g"});
+  TF_ASSERT_OK(other_cache.Insert(1, new_optimized_graph));
+  ASSERT_TRUE(cache.Lookup(1, &graph));
+  EXPECT_EQ(graph.DebugString(), new_optimized_graph.DebugString());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -129,6 +129,35 @@ void SameWorkerRecvDone(const DeviceMgr* device_mgr,
       out, 0 /*dev_to_dev_stream_index*/, std::move(done), sync_dst_compute);
 }
 
+// Wraps `done` so that the received tensor is copied to the receiving device
+// before `done` is called.
+RendezvousInterface::DoneCallback MakeSameWorkerRecvCallback(
+    const DeviceMgr* device_mgr, const RendezvousInterface::ParsedKey& parsed,
+    RendezvousInterface::DoneCallback done) {
+  return [device_mgr, parsed, done = std::move(done)](
+             const Status& status, const Rendezvous::Args& send_args,
+             const Rendezvous::Args& recv_args, const Tensor& in,
+             bool is_dead) mutable {
+    // If "in" is an uninitialized tensor, do copy-construction to
+    // preserve the uninitialized state, along with data type and shape
+    // info, which is useful for debugger purposes.
+    Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
+
+    auto final_callback = [send_args, recv_args, out, is_dead,
+                           done = std::move(done)](const Status& s) {
+      done(s, send_args, recv_args, *out, is_dead);
+      delete out;
+    };
+
+    if (status.ok() && in.IsInitialized()) {
+      SameWorkerRecvDone(device_mgr, parsed, send_args, recv_args, in, out,
+                         std::move(final_callback));
+    } else {
+      final_callback(status);
+    }
+  };
+}
+
 void IntraProcessRecvAsyncImpl(const DeviceMgr* device_mgr,
                                LocalRendezvous* local,
                                const RendezvousInterface::ParsedKey& parsed,
@@ -138,38 +167,31 @@ void IntraProcessRecvAsyncImpl(const DeviceMgr* device_mgr,
 
   profiler::ScopedMemoryDebugAnnotation op_annotation("RecvAsync");
   // Recv the tensor from local_.
-  local->RecvAsync(
-      parsed, recv_args,
-      [device_mgr, parsed, done = std::move(done)](
-          const Status& status, const Rendezvous::Args& send_args,
-          const Rendezvous::Args& recv_args, const Tensor& in,
-          bool is_dead) mutable {
-        // If "in" is an uninitialized tensor, do copy-construction to
-        // preserve the uninitialized state, along with data type and shape
-        // info, which is useful for debugger purposes.
-        Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
-
-        auto final_callback = [send_args, recv_args, out, is_dead,
-                               done = std::move(done)](const Status& s) {
-          done(s, send_args, recv_args, *out, is_dead);
-          delete out;
-        };
-
-        if (status.ok() && in.IsInitialized()) {
-          SameWorkerRecvDone(device_mgr, parsed, send_args, recv_args, in, out,
-                             std::move(final_callback));
-        } else {
-          final_callback(status);
-        }
-      });
+  local->RecvAsync(parsed, recv_args,
+                   MakeSameWorkerRecvCallback(device_mgr, parsed,
+                                              std::move(done)));
+}
+
+void IntraProcessRecvFromSlotAsyncImpl(
+    const DeviceMgr* device_mgr, RendezvousSlotTable* slots, int64_t slot,
+    const RendezvousInterface::ParsedKey& parsed,
+    const Rendezvous::Args& recv_args, RendezvousInterface::DoneCallback done) {
+  DVLOG(1) << "IntraProcessRendezvous Recv from slot " << slot << " "
+           << parsed.FullKey();
+
+  profiler::ScopedMemoryDebugAnnotation op_annotation("RecvAsync");
+  slots->RecvAsync(
+      slot, recv_args,
+      MakeSameWorkerRecvCallback(device_mgr, parsed, std::move(done)));
 }
 
 }  // namespace
 
 RefCountedIntraProcessRendezvous::RefCountedIntraProcessRendezvous(
-    const DeviceMgr* device_mgr)
+    const DeviceMgr* device_mgr, int64_t num_slots)
     : device_mgr_(device_mgr),
-      local_(this, /* num_shards= */ device_mgr->NumDevices()) {}
+      local_(this, /* num_shards= */ device_mgr->NumDevices()),
+      slots_(num_slots) {}
 
 RefCountedIntraProcessRendezvous::~RefCountedIntraProcessRendezvous() {
   VLOG(5) << "Destructor of IntraProcessRendezvous: " << this;
@@ -190,9 +212,39 @@ void RefCountedIntraProcessRendezvous::RecvAsync(const ParsedKey& key,
   IntraProcessRecvAsyncImpl(device_mgr_, &local_, key, args, std::move(done));
 }
 
+Status RefCountedIntraProcessRendezvous::SendToSlot(
+    int64_t slot, const ParsedKey& key, const Rendezvous::Args& args,
+    const Tensor& val, const bool is_dead) {
+  if (!slots_.Contains(slot)) return Send(key, args, val, is_dead);
+  DVLOG(1) << "IntraProcessRendezvous Send to slot " << slot << " "
+           << key.FullKey();
+  return slots_.Send(slot, args, val, is_dead);
+}
+
+void RefCountedIntraProcessRendezvous::RecvFromSlotAsync(
+    int64_t slot, const ParsedKey& key, const Rendezvous::Args& args,
+    DoneCallback done) {
+  if (!slots_.Contains(slot)) {
+    RecvAsync(key, args, std::move(done));
+    return;
+  }
+  // Keep this rendezvous alive until the pending receive has completed, as
+  // `LocalRendezvous` does for keyed receives.
+  Ref();
+  IntraProcessRecvFromSlotAsyncImpl(
+      device_mgr_, &slots_, slot, key, args,
+      [this, done = std::move(done)](
+          const Status& s, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val, bool is_dead) {
+        done(s, send_args, recv_args, val, is_dead);
+        Unref();
+      });
+}
+
 void RefCountedIntraProcessRendezvous::StartAbort(const Status& s) {
   VLOG(1) << "IntraProcessRendezvous start Abort " << this;
   local_.StartAbort(s);
+  slots_.StartAbort(s);
 }
 
 Status RefCountedIntraProcessRendezvous::GetLocalRendezvousStatus() {
@@ -200,9 +252,10 @@ Status RefCountedIntraProcessRendezvous::GetLocalRendezvousStatus() {
 }
 
 PrivateIntraProcessRendezvous::PrivateIntraProcessRendezvous(
-    const DeviceMgr* device_mgr)
+    const DeviceMgr* device_mgr, int64_t num_slots)
     : device_mgr_(device_mgr),
-      local_(nullptr, /* num_shards= */ device_mgr->NumDevices()) {}
+      local_(nullptr, /* num_shards= */ device_mgr->NumDevices()),
+      slots_(num_slots) {}
 
 PrivateIntraProcessRendezvous::~PrivateIntraProcessRendezvous() {}
 
@@ -222,8 +275,29 @@ void PrivateIntraProcessRendezvous::RecvAsync(const ParsedKey& key,
   IntraProcessRecvAsyncImpl(device_mgr_, &local_, key, args, std::move(done));
 }
 
+Status PrivateIntraProcessRendezvous::SendToSlot(int64_t slot,
+                                                 const ParsedKey& key,
+                                                 const Rendezvous::Args& args,
+                                                 const Tensor& val,
+                                                 const bool is_dead) {
+  if (!slots_.Contains(slot)) return Send(key, args, val, is_dead);
+  return slots_.Send(slot, args, val, is_dead);
+}
+
+void PrivateIntraProcessRendezvous::RecvFromSlotAsync(
+    int64_t slot, const ParsedKey& key, const Rendezvous::Args& args,
+    DoneCallback done) {
+  if (!slots_.Contains(slot)) {
+    RecvAsync(key, args, std::move(done));
+    return;
+  }
+  IntraProcessRecvFromSlotAsyncImpl(device_mgr_, &slots_, slot, key, args,
+                                    std::move(done));
+}
+
 void PrivateIntraProcessRendezvous::StartAbort(const Status& s) {
   local_.StartAbort(s);
+  slots_.StartAbort(s);
 }
 
 }  // end namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/rendezvous_slot_table.h"
 #include "tensorflow/core/framework/local_rendezvous.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -38,11 +39,17 @@ namespace tensorflow {
 // Buffering of Tensor values is delegated to a `LocalRendezvous`. An
 // IntraProcessRendezvous. just adds functionality to coordinate multiple
 // process-local devices.
+//
+// If constructed with `num_slots > 0`, Send/Recv pairs that were assigned a
+// rendezvous slot at partition time (see `PartitionOptions`) bypass the
+// `LocalRendezvous` and exchange tensors through a lock-free
+// `RendezvousSlotTable` instead.
 
 // Reference-counted implementation that may be shared between multiple threads.
 class RefCountedIntraProcessRendezvous : public Rendezvous {
  public:
-  explicit RefCountedIntraProcessRendezvous(const DeviceMgr* device_mgr);
+  explicit RefCountedIntraProcessRendezvous(const DeviceMgr* device_mgr,
+                                            int64_t num_slots = 0);
 
   // Implementation of RendezvousInterface methods.
   // NOTE: The methods may clear the Item list and destroy 'this' if there are
@@ -53,6 +60,12 @@ class RefCountedIntraProcessRendezvous : public Rendezvous {
               const Tensor& val, const bool is_dead) override;
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
+  Status SendToSlot(int64_t slot, const ParsedKey& key,
+                    const Rendezvous::Args& args, const Tensor& val,
+                    const bool is_dead) override;
+  void RecvFromSlotAsync(int64_t slot, const ParsedKey& key,
+                         const Rendezvous::Args& args,
+                         DoneCallback done) override;
   void StartAbort(const Status& status) override;
 
   // Returns the member LocalRendezvous' status.
@@ -65,6 +78,7 @@ class RefCountedIntraProcessRendezvous : public Rendezvous {
  private:
   const DeviceMgr* device_mgr_;  // Not owned.
   LocalRendezvous local_;
+  RendezvousSlotTable slots_;
 
   ~RefCountedIntraProcessRendezvous() override;
 
@@ -81,7 +95,8 @@ using IntraProcessRendezvous = RefCountedIntraProcessRendezvous;
 // Prefer to use PrivateIntraProcessRendezvous in new code.
 class PrivateIntraProcessRendezvous : public RendezvousInterface {
  public:
-  explicit PrivateIntraProcessRendezvous(const DeviceMgr* device_mgr);
+  explicit PrivateIntraProcessRendezvous(const DeviceMgr* device_mgr,
+                                         int64_t num_slots = 0);
   ~PrivateIntraProcessRendezvous() override;
 
   // Implementation of RendezvousInterface methods.
@@ -89,11 +104,18 @@ class PrivateIntraProcessRendezvous : public RendezvousInterface {
               const Tensor& val, const bool is_dead) override;
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
+  Status SendToSlot(int64_t slot, const ParsedKey& key,
+                    const Rendezvous::Args& args, const Tensor& val,
+                    const bool is_dead) override;
+  void RecvFromSlotAsync(int64_t slot, const ParsedKey& key,
+                         const Rendezvous::Args& args,
+                         DoneCallback done) override;
   void StartAbort(const Status& status) override;
 
  private:
   const DeviceMgr* device_mgr_;
   LocalRendezvous local_;
+  RendezvousSlotTable slots_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(PrivateIntraProcessRendezvous);
 };
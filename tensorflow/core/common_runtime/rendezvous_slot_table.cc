@@ -0,0 +1,242 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/rendezvous_slot_table.h"
+
+#include <utility>
+
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+// A sent value or a waiting receiver parked in a slot until its peer arrives.
+struct RendezvousSlotTable::Item {
+  enum Type { kSend = 0, kRecv = 1 };
+
+  Item(Type type, const Rendezvous::Args& args) : type(type), args(args) {
+    if (args.device_context) {
+      args.device_context->Ref();
+    }
+  }
+
+  ~Item() {
+    if (args.device_context) {
+      args.device_context->Unref();
+    }
+  }
+
+  const Type type;
+  const Rendezvous::Args args;
+
+  // Valid iff type == kSend.
+  Tensor value;
+  bool is_dead = false;
+
+  // Valid iff type == kRecv.
+  Rendezvous::DoneCallback waiter;
+  CancellationToken cancellation_token = CancellationManager::kInvalidToken;
+};
+
+namespace {
+
+// Marks a slot whose table has been aborted. Never dereferenced.
+template <typename T>
+T* AbortedSentinel() {
+  return reinterpret_cast<T*>(uintptr_t{1});
+}
+
+// Deregisters the cancellation callback of a claimed recv item. The callback
+// only ever compares the item pointer against the slot contents, so it is
+// harmless if it is already running concurrently.
+template <typename T>
+void DeregisterRecvCancellation(T* item) {
+  CancellationManager* cm = item->args.cancellation_manager;
+  if (cm != nullptr &&
+      item->cancellation_token != CancellationManager::kInvalidToken) {
+    cm->TryDeregisterCallback(item->cancellation_token);
+  }
+}
+
+}  // namespace
+
+RendezvousSlotTable::RendezvousSlotTable(int64_t num_slots)
+    : num_slots_(num_slots > 0 ? num_slots : 0),
+      slots_(std::make_unique<std::atomic<Item*>[]>(num_slots_)) {
+  for (int64_t i = 0; i < num_slots_; ++i) {
+    slots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+RendezvousSlotTable::~RendezvousSlotTable() {
+  for (int64_t i = 0; i < num_slots_; ++i) {
+    Item* item = slots_[i].exchange(nullptr, std::memory_order_acq_rel);
+    if (item == nullptr || item == AbortedSentinel<Item>()) continue;
+    if (item->type == Item::kRecv) {
+      DeregisterRecvCancellation(item);
+      item->waiter(errors::Cancelled("RendezvousSlotTable destroyed with a "
+                                     "pending RecvAsync on slot ",
+                                     i),
+                   Rendezvous::Args(), item->args, Tensor(),
+                   /*is_dead=*/false);
+    }
+    delete item;
+  }
+}
+
+Status RendezvousSlotTable::aborted_status() {
+  mutex_lock l(mu_);
+  return status_;
+}
+
+Status RendezvousSlotTable::Send(int64_t slot,
+                                 const Rendezvous::Args& send_args,
+                                 const Tensor& val, bool is_dead) {
+  DCHECK(Contains(slot));
+  std::atomic<Item*>& cell = slots_[slot];
+
+  Item* peer = cell.load(std::memory_order_acquire);
+  if (peer == nullptr) {
+    // Fast path: park the value until the receiver arrives.
+    Item* item = new Item(Item::kSend, send_args);
+    item->value = val;
+    item->is_dead = is_dead;
+    if (cell.compare_exchange_strong(peer, item, std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      return OkStatus();
+    }
+    delete item;
+  }
+
+  if (peer == AbortedSentinel<Item>()) {
+    return aborted_status();
+  }
+  if (peer->type == Item::kSend) {
+    return errors::Internal("Send of an already sent tensor to rendezvous slot ",
+                            slot);
+  }
+
+  // A receiver is waiting. Claim it; this can only fail if the table was
+  // aborted or the receive was cancelled in the meantime.
+  if (!cell.compare_exchange_strong(peer, nullptr, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+    return peer == AbortedSentinel<Item>() ? aborted_status() : OkStatus();
+  }
+  DeregisterRecvCancellation(peer);
+  peer->waiter(OkStatus(), send_args, peer->args, val, is_dead);
+  delete peer;
+  return OkStatus();
+}
+
+void RendezvousSlotTable::RecvAsync(int64_t slot,
+                                    const Rendezvous::Args& recv_args,
+                                    Rendezvous::DoneCallback done) {
+  DCHECK(Contains(slot));
+  std::atomic<Item*>& cell = slots_[slot];
+
+  Item* peer = cell.load(std::memory_order_acquire);
+  if (peer == nullptr) {
+    Item* item = new Item(Item::kRecv, recv_args);
+    item->waiter = std::move(done);
+
+    CancellationManager* cm = recv_args.cancellation_manager;
+    if (cm != nullptr) {
+      item->cancellation_token = cm->get_cancellation_token();
+      const bool registered = cm->RegisterCallback(
+          item->cancellation_token,
+          [this, slot, item]() { CancelRecv(slot, item); });
+      if (!registered) {
+        done = std::move(item->waiter);
+        delete item;
+        done(StatusGroup::MakeDerived(
+                 errors::Cancelled("RecvAsync is cancelled.")),
+             Rendezvous::Args(), recv_args, Tensor(), /*is_dead=*/false);
+        return;
+      }
+    }
+
+    if (cell.compare_exchange_strong(peer, item, std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      // The cancellation callback may have fired before `item` was published,
+      // in which case it found nothing to cancel.
+      if (cm != nullptr && cm->IsCancelled()) {
+        CancelRecv(slot, item);
+      }
+      return;
+    }
+    DeregisterRecvCancellation(item);
+    done = std::move(item->waiter);
+    delete item;
+  }
+
+  if (peer == AbortedSentinel<Item>()) {
+    done(aborted_status(), Rendezvous::Args(), recv_args, Tensor(),
+         /*is_dead=*/false);
+    return;
+  }
+  if (peer->type == Item::kRecv) {
+    done(errors::Internal("Recv of an already awaited rendezvous slot ", slot),
+         Rendezvous::Args(), recv_args, Tensor(), /*is_dead=*/false);
+    return;
+  }
+
+  // A value is waiting. Claim it; this can only fail if the table was aborted.
+  if (!cell.compare_exchange_strong(peer, nullptr, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+    done(aborted_status(), Rendezvous::Args(), recv_args, Tensor(),
+         /*is_dead=*/false);
+    return;
+  }
+  done(OkStatus(), peer->args, recv_args, peer->value, peer->is_dead);
+  delete peer;
+}
+
+void RendezvousSlotTable::CancelRecv(int64_t slot, Item* item) {
+  Item* expected = item;
+  if (!slots_[slot].compare_exchange_strong(expected, nullptr,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+    // Already matched, aborted or cancelled by another caller.
+    return;
+  }
+  item->waiter(
+      StatusGroup::MakeDerived(errors::Cancelled("RecvAsync is cancelled.")),
+      Rendezvous::Args(), item->args, Tensor(), /*is_dead=*/false);
+  delete item;
+}
+
+void RendezvousSlotTable::StartAbort(const Status& status) {
+  CHECK(!status.ok());
+  {
+    mutex_lock l(mu_);
+    status_.Update(status);
+  }
+  const Status s = aborted_status();
+  for (int64_t i = 0; i < num_slots_; ++i) {
+    Item* item =
+        slots_[i].exchange(AbortedSentinel<Item>(), std::memory_order_acq_rel);
+    if (item == nullptr || item == AbortedSentinel<Item>()) continue;
+    if (item->type == Item::kRecv) {
+      DeregisterRecvCancellation(item);
+      item->waiter(s, Rendezvous::Args(), item->args, Tensor(),
+                   /*is_dead=*/false);
+    }
+    delete item;
+  }
+}
+
+}  // namespace tensorflow
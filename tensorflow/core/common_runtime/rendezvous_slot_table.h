@@ -0,0 +1,88 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_SLOT_TABLE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_SLOT_TABLE_H_
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A fixed-size array of single-use channels, indexed by integer slot ids that
+// were assigned to Send/Recv edges at graph partition time (see
+// `PartitionOptions::get_rendezvous_slot`).
+//
+// Unlike `LocalRendezvous`, a slot exchange neither parses nor hashes the
+// rendezvous key and takes no lock: each slot is a single atomic word that
+// moves from empty to holding the first arriving party (a sent value or a
+// waiting receiver), and back to empty when the second party arrives.
+//
+// Each slot carries at most one Send and one Recv between construction and
+// destruction, which holds for the top-level frame of a partitioned graph
+// executed with a per-step rendezvous. Send/Recv pairs executed inside loops
+// or function frames must continue to use the keyed path.
+//
+// This class does not copy tensors between devices; callers are responsible
+// for that (see `IntraProcessRendezvous`).
+class RendezvousSlotTable {
+ public:
+  explicit RendezvousSlotTable(int64_t num_slots);
+  ~RendezvousSlotTable();
+
+  int64_t num_slots() const { return num_slots_; }
+
+  // Returns true iff `slot` is a valid slot id for this table.
+  bool Contains(int64_t slot) const { return slot >= 0 && slot < num_slots_; }
+
+  // REQUIRES: Contains(slot).
+  Status Send(int64_t slot, const Rendezvous::Args& send_args,
+              const Tensor& val, bool is_dead);
+
+  // REQUIRES: Contains(slot).
+  void RecvAsync(int64_t slot, const Rendezvous::Args& recv_args,
+                 Rendezvous::DoneCallback done);
+
+  // Fails all pending and future Send/Recv calls with `status`.
+  // REQUIRES: !status.ok()
+  void StartAbort(const Status& status);
+
+ private:
+  struct Item;
+
+  // Returns the status passed to the first StartAbort() call.
+  Status aborted_status();
+
+  void CancelRecv(int64_t slot, Item* item);
+
+  const int64_t num_slots_;
+  const std::unique_ptr<std::atomic<Item*>[]> slots_;
+
+  mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RendezvousSlotTable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_RENDEZVOUS_SLOT_TABLE_H_
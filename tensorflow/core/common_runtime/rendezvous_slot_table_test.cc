@@ -0,0 +1,150 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/rendezvous_slot_table.h"
+
+#include <atomic>
+
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor V(float value) { return test::AsScalar<float>(value); }
+
+TEST(RendezvousSlotTableTest, SendBeforeRecv) {
+  RendezvousSlotTable table(2);
+  TF_ASSERT_OK(table.Send(1, Rendezvous::Args(), V(3.0f), false));
+
+  Notification n;
+  table.RecvAsync(1, Rendezvous::Args(),
+                  [&n](const Status& s, const Rendezvous::Args&,
+                       const Rendezvous::Args&, const Tensor& val,
+                       bool is_dead) {
+                    TF_EXPECT_OK(s);
+                    EXPECT_FALSE(is_dead);
+                    test::ExpectTensorEqual<float>(val, V(3.0f));
+                    n.Notify();
+                  });
+  EXPECT_TRUE(n.HasBeenNotified());
+}
+
+TEST(RendezvousSlotTableTest, RecvBeforeSend) {
+  RendezvousSlotTable table(1);
+  Notification n;
+  table.RecvAsync(0, Rendezvous::Args(),
+                  [&n](const Status& s, const Rendezvous::Args&,
+                       const Rendezvous::Args&, const Tensor& val,
+                       bool is_dead) {
+                    TF_EXPECT_OK(s);
+                    EXPECT_TRUE(is_dead);
+                    n.Notify();
+                  });
+  EXPECT_FALSE(n.HasBeenNotified());
+  TF_ASSERT_OK(table.Send(0, Rendezvous::Args(), V(1.0f), true));
+  EXPECT_TRUE(n.HasBeenNotified());
+}
+
+TEST(RendezvousSlotTableTest, DuplicateSend) {
+  RendezvousSlotTable table(1);
+  TF_ASSERT_OK(table.Send(0, Rendezvous::Args(), V(1.0f), false));
+  EXPECT_TRUE(
+      errors::IsInternal(table.Send(0, Rendezvous::Args(), V(2.0f), false)));
+}
+
+TEST(RendezvousSlotTableTest, Abort) {
+  RendezvousSlotTable table(2);
+  Notification n;
+  table.RecvAsync(0, Rendezvous::Args(),
+                  [&n](const Status& s, const Rendezvous::Args&,
+                       const Rendezvous::Args&, const Tensor&, bool) {
+                    EXPECT_TRUE(errors::IsAborted(s));
+                    n.Notify();
+                  });
+  table.StartAbort(errors::Aborted("abort"));
+  EXPECT_TRUE(n.HasBeenNotified());
+  EXPECT_TRUE(
+      errors::IsAborted(table.Send(1, Rendezvous::Args(), V(1.0f), false)));
+}
+
+TEST(RendezvousSlotTableTest, Cancel) {
+  RendezvousSlotTable table(1);
+  CancellationManager cm;
+  Rendezvous::Args args;
+  args.cancellation_manager = &cm;
+  Notification n;
+  table.RecvAsync(0, args,
+                  [&n](const Status& s, const Rendezvous::Args&,
+                       const Rendezvous::Args&, const Tensor&, bool) {
+                    EXPECT_TRUE(errors::IsCancelled(s));
+                    n.Notify();
+                  });
+  cm.StartCancel();
+  EXPECT_TRUE(n.HasBeenNotified());
+}
+
+TEST(RendezvousSlotTableTest, ConcurrentSendRecv) {
+  constexpr int kNumSlots = 1000;
+  RendezvousSlotTable table(kNumSlots);
+  std::atomic<int> num_received(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 4);
+    for (int i = 0; i < kNumSlots; ++i) {
+      pool.Schedule([&table, i]() {
+        TF_CHECK_OK(table.Send(i, Rendezvous::Args(),
+                               V(static_cast<float>(i)), false));
+      });
+      pool.Schedule([&table, &num_received, i]() {
+        table.RecvAsync(i, Rendezvous::Args(),
+                        [&num_received, i](const Status& s,
+                                           const Rendezvous::Args&,
+                                           const Rendezvous::Args&,
+                                           const Tensor& val, bool) {
+                          TF_EXPECT_OK(s);
+                          EXPECT_EQ(val.scalar<float>()(),
+                                    static_cast<float>(i));
+                          num_received.fetch_add(1);
+                        });
+      });
+    }
+  }
+  EXPECT_EQ(num_received.load(), kNumSlots);
+}
+
+void BM_SendRecv(::testing::benchmark::State& state) {
+  Tensor val = V(1.0f);
+  Rendezvous::Args args;
+  bool received = false;
+  for (auto s : state) {
+    RendezvousSlotTable table(1);
+    TF_CHECK_OK(table.Send(0, args, val, false));
+    table.RecvAsync(0, args,
+                    [&received](const Status&, const Rendezvous::Args&,
+                                const Rendezvous::Args&, const Tensor&,
+                                bool) { received = true; });
+  }
+  CHECK(received);
+}
+BENCHMARK(BM_SendRecv);
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/single_threaded_executor.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/entry.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -68,6 +70,117 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 static const string& kSingleThreadedExecutor =
     *new string("SINGLE_THREADED_EXECUTOR");
 
+// Graphs with more nodes than this are executed in plain reverse post-order,
+// because `PlanExecutionOrder()` is quadratic in the width of the graph.
+constexpr int kMaxNodesForPlannedOrder = 4096;
+
+// Maximum number of flat `inputs` vectors retained for reuse by later calls to
+// `Run()`. This bounds the memory held by an idle executor, while covering the
+// typical number of concurrent invocations of a `tf.data` function.
+constexpr size_t kMaxPooledInputVectors = 8;
+
+// Computes a deterministic topological order of `graph` that is suited to
+// executing one kernel at a time with the fewest live buffers:
+//
+// * Among the ready nodes, prefer the one that is the last remaining consumer
+//   of the most values, so that those values die, and their buffers are
+//   released to the allocator, as early as possible.
+// * Otherwise, defer nodes that could forward a still-shared input to one of
+//   their outputs, so that they run after the other consumers of that input
+//   and find its buffer with a reference count of one.
+//
+// Remaining ties are broken by reverse post-order. Returns false, leaving
+// `order` unspecified, if `graph` has a cycle.
+bool PlanExecutionOrder(const Graph& graph, std::vector<Node*>* order) {
+  std::vector<Node*> rpo;
+  GetReversePostOrder(graph, &rpo);
+  std::vector<int> rpo_index(graph.num_node_ids(), 0);
+  for (size_t i = 0; i < rpo.size(); ++i) {
+    rpo_index[rpo[i]->id()] = i;
+  }
+
+  // `num_pending_inputs[id]` counts the unscheduled predecessors of a node,
+  // and `num_pending_consumers[id][j]` the unscheduled data consumers of its
+  // `j`th output.
+  std::vector<int> num_pending_inputs(graph.num_node_ids(), 0);
+  std::vector<std::vector<int>> num_pending_consumers(graph.num_node_ids());
+  std::vector<Node*> ready;
+  for (Node* n : graph.nodes()) {
+    num_pending_inputs[n->id()] = n->in_edges().size();
+    num_pending_consumers[n->id()].resize(n->num_outputs(), 0);
+    if (num_pending_inputs[n->id()] == 0) ready.push_back(n);
+  }
+  for (const Edge* e : graph.edges()) {
+    if (!e->IsControlEdge()) {
+      ++num_pending_consumers[e->src()->id()][e->src_output()];
+    }
+  }
+
+  // Returns {number of values freed, number of forwarding candidates deferred}
+  // if `n` were scheduled next.
+  auto score = [&num_pending_consumers](const Node* n) {
+    int num_freed = 0;
+    int num_deferred = 0;
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) continue;
+      int num_uses_by_n = 0;
+      for (const Edge* other : n->in_edges()) {
+        if (other->src() == e->src() &&
+            other->src_output() == e->src_output()) {
+          ++num_uses_by_n;
+        }
+      }
+      if (num_pending_consumers[e->src()->id()][e->src_output()] ==
+          num_uses_by_n) {
+        ++num_freed;
+      } else {
+        const DataType dtype = e->src()->output_type(e->src_output());
+        const DataTypeVector& output_types = n->output_types();
+        if (std::find(output_types.begin(), output_types.end(), dtype) !=
+            output_types.end()) {
+          ++num_deferred;
+        }
+      }
+    }
+    return std::make_pair(num_freed, num_deferred);
+  };
+
+  order->clear();
+  order->reserve(graph.num_nodes());
+  while (!ready.empty()) {
+    size_t best = 0;
+    auto best_score = score(ready[0]);
+    for (size_t i = 1; i < ready.size(); ++i) {
+      const auto candidate_score = score(ready[i]);
+      if (candidate_score.first != best_score.first) {
+        if (candidate_score.first < best_score.first) continue;
+      } else if (candidate_score.second != best_score.second) {
+        if (candidate_score.second > best_score.second) continue;
+      } else if (rpo_index[ready[i]->id()] > rpo_index[ready[best]->id()]) {
+        continue;
+      }
+      best = i;
+      best_score = candidate_score;
+    }
+    Node* n = ready[best];
+    ready[best] = ready.back();
+    ready.pop_back();
+    order->push_back(n);
+
+    for (const Edge* e : n->in_edges()) {
+      if (!e->IsControlEdge()) {
+        --num_pending_consumers[e->src()->id()][e->src_output()];
+      }
+    }
+    for (const Edge* e : n->out_edges()) {
+      if (--num_pending_inputs[e->dst()->id()] == 0) {
+        ready.push_back(e->dst());
+      }
+    }
+  }
+  return order->size() == graph.num_nodes();
+}
+
 class SingleThreadedExecutorImpl : public Executor {
  public:
   explicit SingleThreadedExecutorImpl(const LocalExecutorParams& params)
@@ -83,10 +196,16 @@ class SingleThreadedExecutorImpl : public Executor {
   }
 
   Status Initialize(const Graph& graph) {
-    // Topologicially sort `graph` to get a sequence of OpKernels.
+    // Topologicially sort `graph` to get a sequence of OpKernels. The order
+    // is planned to release dead tensors early and to make forwardable input
+    // buffers reach their last consumer with a reference count of one.
     std::vector<Node*> ordered_nodes;
     ordered_nodes.reserve(graph.num_nodes());
-    GetReversePostOrder(graph, &ordered_nodes);
+    if (graph.num_nodes() > kMaxNodesForPlannedOrder ||
+        !PlanExecutionOrder(graph, &ordered_nodes)) {
+      ordered_nodes.clear();
+      GetReversePostOrder(graph, &ordered_nodes);
+    }
     int ordered_nodes_size = ordered_nodes.size();
     if (ordered_nodes_size != graph.num_nodes()) {
       return errors::InvalidArgument("Graph had ", graph.num_nodes(),
@@ -218,6 +337,21 @@ class SingleThreadedExecutorImpl : public Executor {
         }
       }
 
+      // Record which outputs have consumers, so that kernels can skip
+      // computing (and allocating) the others.
+      for (size_t j = 0; j < kernel_state.num_outputs; ++j) {
+        if (kernel_state.output_locations[j].empty()) {
+          if (!kernel_state.outputs_required) {
+            kernel_state.outputs_required.reset(
+                new bool[kernel_state.num_outputs]);
+            std::fill(&kernel_state.outputs_required[0],
+                      &kernel_state.outputs_required[kernel_state.num_outputs],
+                      true);
+          }
+          kernel_state.outputs_required[j] = false;
+        }
+      }
+
       // Compute allocator attributes for each node output, and corresponding
       // node input.
       kernel_state.output_alloc_attrs.resize(kernel_state.num_outputs);
@@ -288,7 +422,11 @@ class SingleThreadedExecutorImpl : public Executor {
     // * In an error case (see below), we use the connectivity information in
     //   `KernelState::output_locations` to determine which locations have been
     //   initialized, and manually destroy them.
-    std::vector<Entry> inputs(total_num_inputs_);
+    std::unique_ptr<std::vector<Entry>> pooled_inputs = AcquireInputs();
+    auto inputs_cleanup = gtl::MakeCleanup([this, &pooled_inputs] {
+      ReleaseInputs(std::move(pooled_inputs));
+    });
+    std::vector<Entry>& inputs = *pooled_inputs;
 
     // TODO(mrry): Can we avoid copying into these vectors? Consider modifying
     // OpKernelContext to take the TensorValueVec as a pointer into `inputs`.
@@ -340,7 +478,8 @@ class SingleThreadedExecutorImpl : public Executor {
       }
     });
 
-    // TODO(mrry): Consider implementing forwarding.
+    // Inputs are forwarded whenever their buffer has a reference count of
+    // one, which the planned kernel order arranges for where possible.
     params.forward_from_array = nullptr;
 
     const size_t received_args =
@@ -439,6 +578,7 @@ class SingleThreadedExecutorImpl : public Executor {
       params.input_alloc_attrs = input_alloc_attrs;
       params.op_kernel = kernel_state.kernel;
       params.output_attr_array = kernel_state.output_alloc_attrs.data();
+      params.outputs_required_array = kernel_state.outputs_required.get();
       OpKernelContext ctx(&params, num_outputs);
 
       // Actually execute the kernel.
@@ -494,6 +634,34 @@ class SingleThreadedExecutorImpl : public Executor {
     args.runner([this, args, done]() { done(Run(args)); });
   }
 
+  // Returns a flat `inputs` vector of length `total_num_inputs_` whose entries
+  // are all in the `NO_VALUE` state, reusing one from an earlier `Run()` if
+  // possible.
+  std::unique_ptr<std::vector<Entry>> AcquireInputs() {
+    {
+      mutex_lock l(inputs_pool_mu_);
+      if (!inputs_pool_.empty()) {
+        std::unique_ptr<std::vector<Entry>> inputs =
+            std::move(inputs_pool_.back());
+        inputs_pool_.pop_back();
+        return inputs;
+      }
+    }
+    return std::make_unique<std::vector<Entry>>(total_num_inputs_);
+  }
+
+  // Clears any values left in `inputs` (e.g. after a kernel failed) and
+  // returns it to the pool.
+  void ReleaseInputs(std::unique_ptr<std::vector<Entry>> inputs) {
+    for (Entry& input : *inputs) {
+      input.ClearVal();
+    }
+    mutex_lock l(inputs_pool_mu_);
+    if (inputs_pool_.size() < kMaxPooledInputVectors) {
+      inputs_pool_.push_back(std::move(inputs));
+    }
+  }
+
   const LocalExecutorParams params_;
 
   // All following members are read-only after Initialize().
@@ -527,6 +695,10 @@ class SingleThreadedExecutorImpl : public Executor {
     // Memory space information for each output of `kernel`.
     std::vector<AllocatorAttributes>
         output_alloc_attrs;  // Length = `num_outputs`.
+
+    // For the `j`th output of `kernel`, `outputs_required[j]` is false iff the
+    // output has no consumers. Null if all outputs are required.
+    std::unique_ptr<bool[]> outputs_required;  // Length = `num_outputs`.
   };
   std::vector<KernelState> kernels_;
 
@@ -567,6 +739,11 @@ class SingleThreadedExecutorImpl : public Executor {
   // `RunAsync()` for details.
   std::vector<AllocatorAttributes>
       input_alloc_attrs_;  // Length = `total_num_inputs_`.
+
+  // Flat `inputs` vectors released by completed calls to `Run()`.
+  mutex inputs_pool_mu_;
+  std::vector<std::unique_ptr<std::vector<Entry>>> inputs_pool_
+      TF_GUARDED_BY(inputs_pool_mu_);
 };
 
 class SingleThreadedExecutorRegistrar {
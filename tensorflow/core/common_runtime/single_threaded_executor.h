@@ -43,7 +43,11 @@ namespace tensorflow {
 //    order, and cannot currently distinguish between disconnected subgraphs
 //    that are logically connected by subgraphs on a different device.
 // 4. Memory logging is not currently supported.
-// 5. Allocation forwarding is not currently supported.
+// 5. Allocation forwarding is only performed when an input buffer is not
+//    shared at the time its consumer runs; there are no forwarding
+//    reservations. The kernel order is planned once, at construction time, to
+//    release dead tensors early and to run forwarding candidates last among
+//    the consumers of a value.
 // 6. Non-default device contexts are not currently supported. In effect, this
 //    limits the executor to CPU devices.
 // 7. Ops that rely on `OpKernelContext::slice_reader_cache()` being non-null
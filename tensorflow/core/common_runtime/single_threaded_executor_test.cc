@@ -249,6 +249,96 @@ TEST_F(ExecutorTest, EmptyOutput) {
   EXPECT_EQ(0, retvals[1].tensor_data().size());
 }
 
+TEST_F(ExecutorTest, UnusedOutputNotRequired) {
+  // y, _ = MockOp(in)
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  Node* in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  Node* mock;
+  TF_ASSERT_OK(
+      NodeBuilder(g->NewName("n"), "Mock").Input(in).Finalize(g.get(), &mock));
+  test::graph::Retval(g.get(), 0, mock, 0);
+  FixupSourceAndSinkEdges(g.get());
+  bool mock_called = false;
+  Create(std::move(g), [&](OpKernelContext* ctx) {
+    mock_called = true;
+    EXPECT_TRUE(ctx->output_required(0));
+    EXPECT_FALSE(ctx->output_required(1));
+    ctx->set_output(0, ctx->input(0));
+  });
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  EXPECT_TRUE(mock_called);
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(1.0, V(retvals[0]));
+}
+
+TEST_F(ExecutorTest, ForwardingCandidateRunsLast) {
+  // a, _ = MockOp(in)
+  // s = Shape(a)
+  // b, _ = MockOp(a)
+  //
+  // `b` could forward `a`, so it should run after `s`, at which point it holds
+  // the only reference to the buffer of `a`.
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  Node* in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  Node* a;
+  TF_ASSERT_OK(NodeBuilder("a", "Mock").Input(in).Finalize(g.get(), &a));
+  Node* b;
+  TF_ASSERT_OK(NodeBuilder("b", "Mock").Input(a).Finalize(g.get(), &b));
+  Node* shape = test::graph::Unary(g.get(), "Shape", a);
+  test::graph::Retval(g.get(), 0, b, 0);
+  test::graph::Retval(g.get(), 1, shape, 0);
+  FixupSourceAndSinkEdges(g.get());
+  bool b_called = false;
+  Create(std::move(g), [&](OpKernelContext* ctx) {
+    if (ctx->op_kernel().name() == "a") {
+      // Produce a fresh buffer that is not shared with the argument.
+      Tensor* out;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({2}), &out));
+      out->flat<float>().setConstant(2.0);
+    } else {
+      b_called = true;
+      EXPECT_TRUE(ctx->input(0).RefCountIsOne());
+      ctx->set_output(0, ctx->input(0));
+    }
+  });
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT, DT_INT32});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  EXPECT_TRUE(b_called);
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(2, retvals[0].NumElements());
+  EXPECT_EQ(2, retvals[1].flat<int32>()(0));
+}
+
+TEST_F(ExecutorTest, RepeatedRunsAfterError) {
+  // c = a + b, run repeatedly, interleaved with a failing call.
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  test::graph::Retval(g.get(), 0, tmp);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (int i = 0; i < 4; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(static_cast<float>(i)), V(1.0)}));
+    TF_ASSERT_OK(Run(&call_frame));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(i + 1.0, V(retvals[0]));
+
+    // Incompatible shapes make `Add` fail, leaving `inputs` partially filled.
+    FunctionCallFrame bad_call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(bad_call_frame.SetArgs(
+        {Tensor(DT_FLOAT, TensorShape({2})), Tensor(DT_FLOAT, {3})}));
+    EXPECT_FALSE(Run(&bad_call_frame).ok());
+  }
+}
+
 TEST_F(ExecutorTest, SelfAdd) {
   // v0 <- a
   // v1 = v0 + v0
@@ -28,6 +28,7 @@ info. It does not have any negative impact on performance. */
 
 #include "absl/base/call_once.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/common_runtime/scoped_allocator.h"
 #include "tensorflow/core/common_runtime/scoped_allocator_mgr.h"
@@ -44,6 +45,7 @@ info. It does not have any negative impact on performance. */
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/shard_cost_table.h"
 #include "tensorflow/core/util/util.h"
 
 #ifdef INTEL_MKL
@@ -181,7 +183,21 @@ void ThreadPoolDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     LogInputs(op_kernel, context);
   }
 
-  op_kernel->Compute(context);
+  if (GetShardCostModelMode() != ShardCostModelMode::kStatic) {
+    // Measured costs depend on the input shapes, e.g. through row sizes.
+    absl::InlinedVector<const TensorShape*, 4> input_shapes;
+    for (int i = 0; i < context->num_inputs(); ++i) {
+      if (!context->input_is_ref(i) && context->has_input(i)) {
+        input_shapes.push_back(&context->input(i).shape());
+      }
+    }
+    const string key =
+        ShardCostKey(op_kernel->type_string_view(), input_shapes);
+    ScopedPerThreadShardCostKey shard_cost_key(key);
+    op_kernel->Compute(context);
+  } else {
+    op_kernel->Compute(context);
+  }
 
   if (context->status().ok() && node_file_writer_) {
     Status s = node_file_writer_->RecordNodeExecution(op_kernel, context);
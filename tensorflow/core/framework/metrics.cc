@@ -16,15 +16,21 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
+#include "tsl/lib/monitoring/collection_registry.h"
 #include "tsl/lib/monitoring/counter.h"
 #include "tsl/lib/monitoring/gauge.h"
+#include "tsl/lib/monitoring/metric_def.h"
 #include "tsl/lib/monitoring/sampler.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/platform/thread_annotations.h"
 #include "tsl/platform/types.h"
 
 namespace tensorflow {
@@ -64,6 +70,82 @@ auto* graph_run_output_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 14 (256MB)
     {tsl::monitoring::Buckets::Exponential(1, 4, 14)});
 
+// Gauges exported by the adaptive parallelism controllers, labeled by
+// session. Unlike the cells of a Gauge, the values of a session are removed
+// when it is destroyed, so that short-lived sessions do not accumulate.
+class AdaptiveParallelismGauges {
+ public:
+  struct Values {
+    int64_t intra_op_parallelism = 0;
+    int64_t queue_delay_usecs = 0;
+    int64_t intra_op_efficiency_percent = 0;
+  };
+
+  static AdaptiveParallelismGauges* Get() {
+    static AdaptiveParallelismGauges* gauges = new AdaptiveParallelismGauges;
+    return gauges;
+  }
+
+  template <typename Update>
+  void UpdateSession(const string& session, Update update) {
+    tsl::mutex_lock l(mu_);
+    update(&sessions_[session]);
+  }
+
+  void RemoveSession(const string& session) {
+    tsl::mutex_lock l(mu_);
+    sessions_.erase(session);
+  }
+
+ private:
+  using GaugeDef =
+      tsl::monitoring::MetricDef<tsl::monitoring::MetricKind::kGauge,
+                                 int64_t, 1>;
+
+  AdaptiveParallelismGauges()
+      : intra_op_parallelism_def_(
+            "/tensorflow/core/adaptive_intra_op_parallelism",
+            "The intra-op parallelism chosen by the adaptive parallelism "
+            "controller of a session.",
+            "session"),
+        queue_delay_def_(
+            "/tensorflow/core/adaptive_parallelism_queue_delay_usecs",
+            "The mean time in microseconds that inter-op closures of a "
+            "session spent queued during the last adjustment interval.",
+            "session"),
+        intra_op_efficiency_def_(
+            "/tensorflow/core/adaptive_parallelism_intra_op_efficiency",
+            "The intra-op parallel efficiency in percent (the time spent in "
+            "shards over the wall time times the number of shards) of a "
+            "session during the last adjustment interval.",
+            "session") {
+    Register(&intra_op_parallelism_def_, &Values::intra_op_parallelism);
+    Register(&queue_delay_def_, &Values::queue_delay_usecs);
+    Register(&intra_op_efficiency_def_, &Values::intra_op_efficiency_percent);
+  }
+
+  void Register(const GaugeDef* def, int64_t Values::*field) {
+    handles_.push_back(tsl::monitoring::CollectionRegistry::Default()->Register(
+        def, [this, def, field](tsl::monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(def);
+          tsl::mutex_lock l(mu_);
+          for (const auto& session : sessions_) {
+            collector.CollectValue({{session.first}}, session.second.*field);
+          }
+        }));
+  }
+
+  tsl::mutex mu_;
+  std::map<string, Values> sessions_ TF_GUARDED_BY(mu_);
+
+  const GaugeDef intra_op_parallelism_def_;
+  const GaugeDef queue_delay_def_;
+  const GaugeDef intra_op_efficiency_def_;
+  std::vector<
+      std::unique_ptr<tsl::monitoring::CollectionRegistry::RegistrationHandle>>
+      handles_;
+};
+
 auto* graph_unused_outputs = tsl::monitoring::Counter<1>::New(
     "/tensorflow/core/graph_unused_outputs",
     "The number of unused outputs for ops of a given type.", "name");
@@ -665,6 +747,28 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+void RecordAdaptiveParallelism(const string& session,
+                               int64_t intra_op_parallelism) {
+  AdaptiveParallelismGauges::Get()->UpdateSession(
+      session, [&](AdaptiveParallelismGauges::Values* values) {
+        values->intra_op_parallelism = intra_op_parallelism;
+      });
+}
+
+void RecordAdaptiveParallelismSignals(const string& session,
+                                      int64_t queue_delay_usecs,
+                                      int64_t intra_op_efficiency_percent) {
+  AdaptiveParallelismGauges::Get()->UpdateSession(
+      session, [&](AdaptiveParallelismGauges::Values* values) {
+        values->queue_delay_usecs = queue_delay_usecs;
+        values->intra_op_efficiency_percent = intra_op_efficiency_percent;
+      });
+}
+
+void RemoveAdaptiveParallelism(const string& session) {
+  AdaptiveParallelismGauges::Get()->RemoveSession(session);
+}
+
 void UpdateGraphPendingQueueLength(uint64 len) {
   static auto* graph_pending_queue_length_cell =
       graph_pending_queue_length_histogram->GetCell();
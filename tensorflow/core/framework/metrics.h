@@ -226,6 +226,21 @@ void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the intra-op parallelism chosen for `session` by its adaptive
+// parallelism controller.
+void RecordAdaptiveParallelism(const string& session,
+                               int64_t intra_op_parallelism);
+
+// Records the signals the adaptive parallelism controller of `session` based
+// its last decision on: the mean inter-op queueing delay, and the intra-op
+// parallel efficiency in percent.
+void RecordAdaptiveParallelismSignals(const string& session,
+                                      int64_t queue_delay_usecs,
+                                      int64_t intra_op_efficiency_percent);
+
+// Removes the adaptive parallelism metrics of `session`, once it is closed.
+void RemoveAdaptiveParallelism(const string& session);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -47,4 +47,20 @@ TEST(Metrics, Phase2ComilationStatusUntouchedCounterNotIncremented) {
   ASSERT_EQ(counter.Read(kMlirWithFallbackModeSuccess), 0);
 }
 
+TEST(Metrics, AdaptiveParallelismRemovedWithSession) {
+  CellReader<int64_t> parallelism(
+      "/tensorflow/core/adaptive_intra_op_parallelism");
+  CellReader<int64_t> queue_delay(
+      "/tensorflow/core/adaptive_parallelism_queue_delay_usecs");
+
+  tensorflow::metrics::RecordAdaptiveParallelism("session", 4);
+  tensorflow::metrics::RecordAdaptiveParallelismSignals("session", 100, 90);
+  ASSERT_EQ(parallelism.Read("session"), 4);
+  ASSERT_EQ(queue_delay.Read("session"), 100);
+
+  tensorflow::metrics::RemoveAdaptiveParallelism("session");
+  ASSERT_EQ(parallelism.Read("session"), 0);
+  ASSERT_EQ(queue_delay.Read("session"), 0);
+}
+
 }  // namespace
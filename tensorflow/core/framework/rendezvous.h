@@ -105,6 +105,22 @@ class RendezvousInterface {
   virtual void RecvAsync(const ParsedKey& key, const Args& args,
                          DoneCallback done) = 0;
 
+  // Variants of Send() and RecvAsync() for Send/Recv pairs that were assigned
+  // an integer rendezvous slot at graph partition time (see
+  // `PartitionOptions::get_rendezvous_slot`). Implementations backed by a
+  // slot table exchange the tensor through `slot` without hashing `key`; the
+  // default implementation falls back to the keyed path. `key` must be the
+  // key that the pair would otherwise use.
+  virtual Status SendToSlot(int64_t slot, const ParsedKey& key,
+                            const Args& args, const Tensor& val,
+                            const bool is_dead) {
+    return Send(key, args, val, is_dead);
+  }
+  virtual void RecvFromSlotAsync(int64_t slot, const ParsedKey& key,
+                                 const Args& args, DoneCallback done) {
+    RecvAsync(key, args, std::move(done));
+  }
+
   // Synchronous wrapper for RecvAsync.
   Status Recv(const ParsedKey& key, const Args& args, Tensor* val,
               bool* is_dead, int64_t timeout_ms);
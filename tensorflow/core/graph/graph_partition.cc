@@ -1154,6 +1154,12 @@ Status Partition(const PartitionOptions& opts, Graph* g,
                               tensor_name_attr, &status);
       if (!status.ok()) return status;
 
+      if (opts.get_rendezvous_slot) {
+        const int64_t slot = opts.get_rendezvous_slot(edge);
+        AddNodeAttr("_rendezvous_slot", slot, send);
+        AddNodeAttr("_rendezvous_slot", slot, real_recv);
+      }
+
       // Fix up the control flow edge.
       // NOTE(yuanbyu): 'real_recv' must be the real recv node.
       if (src_graph == dst_graph) {
@@ -80,6 +80,14 @@ struct PartitionOptions {
   // Optional customized function to compute the "tensor_name" attr value of
   // Send/Recv ops inserted during partitioning.
   std::function<string(const Edge*)> get_tensor_name_attr = nullptr;
+
+  // Optional function returning the integer rendezvous slot to assign to the
+  // Send/Recv pair inserted for an edge, recorded in the "_rendezvous_slot"
+  // attr of both nodes. A rendezvous that was created with at least as many
+  // slots as were assigned exchanges tensors for top-level Send/Recv pairs
+  // through the slot, without hashing the rendezvous key. Slots must be
+  // unique within one set of partitions.
+  std::function<int64_t(const Edge*)> get_rendezvous_slot = nullptr;
 };
 
 // Partition "input" graph into a set of graphs, one per location.
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <functional>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -83,7 +85,9 @@ string DeviceName(const Node* node) {
 }
 
 void Partition(const GraphDef& graph_def,
-               std::unordered_map<string, GraphDef>* partitions) {
+               std::unordered_map<string, GraphDef>* partitions,
+               std::function<int64_t(const Edge*)> get_rendezvous_slot =
+                   nullptr) {
   Graph g(OpRegistry::Global());
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
@@ -103,6 +107,7 @@ void Partition(const GraphDef& graph_def,
   popts.get_incarnation = [](const string& name) {
     return (name[0] - 'A') + 100;
   };
+  popts.get_rendezvous_slot = std::move(get_rendezvous_slot);
   Status s = Partition(popts, &g, partitions);
   CHECK(s.ok()) << s;
 
@@ -542,6 +547,39 @@ TEST_F(GraphPartitionTest, SetIncarnation) {
   }
 }
 
+TEST_F(GraphPartitionTest, RendezvousSlots) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto b1 = FloatInput(in_.WithOpName("B1"));
+  auto c1 = FloatInput(in_.WithOpName("C1"));
+  Combine(in_.WithOpName("B2"), a1, b1);
+  Combine(in_.WithOpName("C2"), a1, c1);
+  Combine(in_.WithOpName("A2"), b1, c1);
+
+  int64_t next_slot = 0;
+  Partition(ToGraphDef(), &partitions_,
+            [&next_slot](const Edge*) { return next_slot++; });
+  EXPECT_EQ(3, partitions_.size());
+  EXPECT_EQ(4, next_slot);
+
+  // Every Send/Recv pair shares one slot, and no two pairs share a slot.
+  std::unordered_map<string, int64_t> send_slots;
+  std::unordered_map<string, int64_t> recv_slots;
+  for (const auto& kv : partitions_) {
+    for (const NodeDef& ndef : kv.second.node()) {
+      if (ndef.op() != "_Send" && ndef.op() != "_Recv") continue;
+      string tensor_name;
+      TF_ASSERT_OK(GetNodeAttr(ndef, "tensor_name", &tensor_name));
+      int64_t slot;
+      TF_ASSERT_OK(GetNodeAttr(ndef, "_rendezvous_slot", &slot));
+      (ndef.op() == "_Send" ? send_slots : recv_slots)[tensor_name] = slot;
+    }
+  }
+  EXPECT_EQ(send_slots, recv_slots);
+  std::set<int64_t> distinct_slots;
+  for (const auto& kv : send_slots) distinct_slots.insert(kv.second);
+  EXPECT_EQ(distinct_slots.size(), send_slots.size());
+}
+
 TEST_F(GraphPartitionTest, GraphDebugInfo) {
   GraphDef graph_def;
   Output a1 = FloatInput(in_.WithOpName("A1"));
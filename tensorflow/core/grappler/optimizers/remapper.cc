@@ -167,6 +167,19 @@ struct TensorToHashBucket {
   int string_to_hash_bucket = kMissingIndex;
 };
 
+// Gather (or ResourceGather) of embedding table rows followed by a
+// SparseSegment reduction of the gathered rows, which can be replaced with a
+// reduction of the table rows at the gathered indices, so that the gathered
+// rows are not materialized.
+struct GatherWithSparseSegmentReduction {
+  GatherWithSparseSegmentReduction() = default;
+  GatherWithSparseSegmentReduction(int gather, int sparse_segment_reduction)
+      : gather(gather), sparse_segment_reduction(sparse_segment_reduction) {}
+
+  int gather = kMissingIndex;
+  int sparse_segment_reduction = kMissingIndex;
+};
+
 // Pad followed by Conv3D/FusedConv3D
 struct PadWithConv3D {
   PadWithConv3D() = default;
@@ -2669,6 +2682,80 @@ bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+bool FindGatherWithSparseSegmentReduction(
+    const RemapperContext& ctx, int node_index,
+    GatherWithSparseSegmentReduction* matched) {
+  // Root of the pattern must be a SparseSegment reduction on CPU.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsAnySparseSegmentReduction(*node_def) || !NodeIsOnCpu(node_def) ||
+      HasControlFaninOrFanout(*node_view) ||
+      node_view->NumRegularFanins() < 3) {
+    return false;
+  }
+
+  // Its data must be a Gather, GatherV2 or ResourceGather on CPU with no other
+  // consumer.
+  const auto* gather_node_view = node_view->GetRegularFanin(0).node_view();
+  const auto* gather_node_def = gather_node_view->node();
+  const bool is_gather_v2 = gather_node_def->op() == "GatherV2";
+  const bool is_resource_gather = gather_node_def->op() == "ResourceGather";
+  if ((gather_node_def->op() != "Gather" && !is_gather_v2 &&
+       !is_resource_gather) ||
+      !NodeIsOnCpu(gather_node_def) ||
+      HasControlFaninOrFanout(*gather_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*gather_node_view) ||
+      IsInPreserveSet(ctx, gather_node_def)) {
+    return false;
+  }
+
+  const DataType ids_dtype = GetDataTypeFromAttr(*gather_node_def, "Tindices");
+  if (ids_dtype != DT_INT32 && ids_dtype != DT_INT64) return false;
+
+  // ResourceGather and GatherV2 must gather along the first dimension.
+  if (is_resource_gather) {
+    int batch_dims = 0;
+    if (TryGetNodeAttr(*gather_node_def, "batch_dims", &batch_dims) &&
+        batch_dims != 0) {
+      return false;
+    }
+  }
+  if (is_gather_v2) {
+    int batch_dims = 0;
+    if (TryGetNodeAttr(*gather_node_def, "batch_dims", &batch_dims) &&
+        batch_dims != 0) {
+      return false;
+    }
+    if (gather_node_view->NumRegularFanins() < 3) return false;
+    const auto* axis_node_def =
+        gather_node_view->GetRegularFanin(2).node_view()->node();
+    Tensor axis;
+    if (!IsConstant(*axis_node_def) ||
+        !axis.FromProto(axis_node_def->attr().at("value").tensor()) ||
+        axis.NumElements() != 1) {
+      return false;
+    }
+    const int64_t axis_value = axis.dtype() == DT_INT32
+                                   ? axis.flat<int32>()(0)
+                                   : axis.flat<int64_t>()(0);
+    if (axis_value != 0) return false;
+  }
+
+  // The gathered ids must be a vector, so that the rows of the gathered
+  // tensor are rows of the table.
+  if (!ctx.inferred_graph_properties) return false;
+  const auto& gather_props =
+      ctx.graph_properties.GetInputProperties(gather_node_def->name());
+  if (gather_props.size() < 2 || gather_props[1].shape().unknown_rank() ||
+      gather_props[1].shape().dim_size() != 1) {
+    return false;
+  }
+
+  *matched = GatherWithSparseSegmentReduction(gather_node_view->node_index(),
+                                              node_index);
+  return true;
+}
+
 bool FindFusedBatchMatMul(RemapperContext* ctx, int node_index,
                           std::map<string, int>* matched_nodes_map,
                           std::set<int>* remove_node_indices,
@@ -4108,6 +4195,80 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return OkStatus();
 }
 
+Status AddGatherWithSparseSegmentReductionNodes(
+    RemapperContext* ctx, const GatherWithSparseSegmentReduction& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reduction = graph->node(matched.sparse_segment_reduction);
+  VLOG(2) << "Fuse " << gather.op() << " with " << reduction.op() << ":"
+          << " gather=" << gather.name() << " reduction=" << reduction.name();
+
+  const bool is_resource_gather = gather.op() == "ResourceGather";
+
+  // The reduction reads the table rows at ids[indices], which are gathered
+  // from the ids by a node of the same type as the original gather, or by a
+  // Gather for a ResourceGather.
+  NodeDef table_indices;
+  table_indices.set_name(AddPrefixToNodeName("indices", reduction.name()));
+  table_indices.set_op(is_resource_gather ? "Gather" : gather.op());
+  table_indices.set_device(reduction.device());
+  table_indices.add_input(gather.input(1));     // 0: params (ids)
+  table_indices.add_input(reduction.input(1));  // 1: indices
+  if (gather.op() == "GatherV2") {
+    table_indices.add_input(gather.input(2));  // 2: axis
+  }
+  auto* indices_attr = table_indices.mutable_attr();
+  (*indices_attr)["Tparams"] = gather.attr().at("Tindices");
+  (*indices_attr)["Tindices"] = reduction.attr().at("Tidx");
+  for (const char* name : {"Taxis", "batch_dims", "validate_indices"}) {
+    // Gather has no batch_dims, which is 0 for a matched ResourceGather.
+    if (is_resource_gather && absl::string_view(name) == "batch_dims") {
+      continue;
+    }
+    if (gather.attr().contains(name)) {
+      (*indices_attr)[name] = gather.attr().at(name);
+    }
+  }
+
+  // The table of a ResourceGather is the value of its variable.
+  NodeDef read_table;
+  if (is_resource_gather) {
+    read_table.set_name(AddPrefixToNodeName("table", reduction.name()));
+    read_table.set_op("ReadVariableOp");
+    read_table.set_device(gather.device());
+    read_table.add_input(gather.input(0));  // 0: resource
+    (*read_table.mutable_attr())["dtype"] = gather.attr().at("dtype");
+    if (gather.attr().contains("_class")) {
+      (*read_table.mutable_attr())["_class"] = gather.attr().at("_class");
+    }
+  }
+
+  NodeDef fused_reduction = reduction;
+  // 0: data (table)
+  fused_reduction.set_input(
+      0, is_resource_gather ? read_table.name() : gather.input(0));
+  fused_reduction.set_input(1, table_indices.name());
+  (*fused_reduction.mutable_attr())["Tidx"] = gather.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  if (is_resource_gather) {
+    mutation->AddNode(std::move(read_table), &status);
+    TF_RETURN_IF_ERROR(status);
+  }
+  mutation->AddNode(std::move(table_indices), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(fused_reduction), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.sparse_segment_reduction] = true;
+  (*nodes_to_delete)[matched.gather] = true;
+
+  return OkStatus();
+}
+
 Status AddFusedBatchMatMul(RemapperContext* ctx,
                            const std::map<string, int>& matched_nodes_map,
                            const std::set<int>& remove_node_indices,
@@ -4441,6 +4602,7 @@ Status ReplaceSoftplusTanhAndMulWithMish(
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
 //   (5) Fusing side output and/or activation into FusedBatchNormGrad.
+//   (6) Fusing Gather into a SparseSegment reduction of its output.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
                             const Cluster* cluster) {
   // Candidate for a FusedBatchNorm splitting.
@@ -4578,17 +4740,30 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
     return true;
   };
 
+  const auto is_gather_sparse_segment_reduction_candidate = [&]() -> bool {
+    if (!IsAnySparseSegmentReduction(*node_def) || !NodeIsOnCpu(node_def) ||
+        node_view->NumRegularFanins() < 1) {
+      return false;
+    }
+    const auto* fanin_0_node_def =
+        node_view->GetRegularFanin(0).node_view()->node();
+    return fanin_0_node_def->op() == "Gather" ||
+           fanin_0_node_def->op() == "GatherV2";
+  };
+
   if (IsMKLEnabled())
     return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
            IsContractionWithAdd(ctx, node_index) ||
            is_act_biasadd_conv_candidate() || IsBiasAdd(*node_def) ||
-           IsTranspose(*node_def);
+           IsTranspose(*node_def) ||
+           is_gather_sparse_segment_reduction_candidate();
 
   return is_act_biasadd_conv_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
          is_batch_norm_grad_fusion_candidate() ||
          is_matmul_gelu_exact_fusion_candidate() ||
-         is_act_biasadd_matmul_candidate();
+         is_act_biasadd_matmul_candidate() ||
+         is_gather_sparse_segment_reduction_candidate();
 }
 }  // namespace
 
@@ -4904,6 +5079,18 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // The reduction of gathered embedding rows has the gradient of a dense
+    // table instead of the sparse one of the gather.
+    GatherWithSparseSegmentReduction gather_with_sparse_segment_reduction;
+    if (allow_non_differentiable_rewrites &&
+        FindGatherWithSparseSegmentReduction(
+            ctx, i, &gather_with_sparse_segment_reduction)) {
+      TF_RETURN_IF_ERROR(AddGatherWithSparseSegmentReductionNodes(
+          &ctx, gather_with_sparse_segment_reduction, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     TensorToHashBucket tensor_to_hash_bucket;
     if (allow_non_differentiable_rewrites &&
         FindTensorToHashBucket(ctx, i, &tensor_to_hash_bucket)) {
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
 #include "tensorflow/cc/ops/nn_ops_internal.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
@@ -1606,6 +1607,140 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+TEST_F(RemapperTest, FuseGatherWithSparseSegmentMean) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto params = Placeholder(s.WithOpName("params"), DT_FLOAT,
+                            ops::Placeholder::Shape({10, 4}));
+  auto ids = Placeholder(s.WithOpName("ids"), DT_INT64,
+                         ops::Placeholder::Shape({6}));
+  auto indices = Placeholder(s.WithOpName("indices"), DT_INT32,
+                             ops::Placeholder::Shape({5}));
+  auto segment_ids = Placeholder(s.WithOpName("segment_ids"), DT_INT32,
+                                 ops::Placeholder::Shape({5}));
+  auto axis = ops::Const(s.WithOpName("axis"), 0);
+  auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+  auto reduction = ops::SparseSegmentMean(s.WithOpName("reduction"), gather,
+                                          indices, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), reduction);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"params", GenerateRandomTensor<DT_FLOAT>({10, 4})},
+               {"ids", test::AsTensor<int64_t>({7, 0, 3, 3, 9, 1})},
+               {"indices", test::AsTensor<int32>({0, 2, 5, 1, 4})},
+               {"segment_ids", test::AsTensor<int32>({0, 0, 0, 2, 2})}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "gather");
+    if (node.name() == "reduction") {
+      EXPECT_EQ(node.op(), "SparseSegmentMean");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "params");
+      EXPECT_EQ(node.input(1), "reduction/indices");
+      EXPECT_EQ(node.input(2), "segment_ids");
+      EXPECT_EQ(node.attr().at("Tidx").type(), DT_INT64);
+      found++;
+    } else if (node.name() == "reduction/indices") {
+      EXPECT_EQ(node.op(), "GatherV2");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "ids");
+      EXPECT_EQ(node.input(1), "indices");
+      EXPECT_EQ(node.input(2), "axis");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+}
+
+TEST_F(RemapperTest, FuseResourceGatherWithSparseSegmentSum) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto var = ops::VarHandleOp(s.WithOpName("var"), DT_FLOAT,
+                              TensorShape({10, 4}));
+  auto table = ops::Const(s.WithOpName("table"),
+                          GenerateRandomTensor<DT_FLOAT>({10, 4}));
+  auto assign = ops::AssignVariableOp(s.WithOpName("assign"), var, table);
+  auto ids = Placeholder(s.WithOpName("ids"), DT_INT32,
+                         ops::Placeholder::Shape({6}));
+  auto indices = Placeholder(s.WithOpName("indices"), DT_INT32,
+                             ops::Placeholder::Shape({5}));
+  auto segment_ids = Placeholder(s.WithOpName("segment_ids"), DT_INT32,
+                                 ops::Placeholder::Shape({5}));
+  auto gather =
+      ops::ResourceGather(s.WithOpName("gather"), var, ids, DT_FLOAT);
+  auto reduction = ops::SparseSegmentSum(s.WithOpName("reduction"), gather,
+                                         indices, segment_ids);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), reduction);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.init_ops = {"assign"};
+  item.feed = {{"ids", test::AsTensor<int32>({7, 0, 3, 3, 9, 1})},
+               {"indices", test::AsTensor<int32>({0, 2, 5, 1, 4})},
+               {"segment_ids", test::AsTensor<int32>({0, 0, 0, 2, 2})}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "gather");
+    if (node.name() == "reduction") {
+      EXPECT_EQ(node.op(), "SparseSegmentSum");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "reduction/table");
+      EXPECT_EQ(node.input(1), "reduction/indices");
+      EXPECT_EQ(node.input(2), "segment_ids");
+      found++;
+    } else if (node.name() == "reduction/table") {
+      EXPECT_EQ(node.op(), "ReadVariableOp");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "var");
+      found++;
+    } else if (node.name() == "reduction/indices") {
+      EXPECT_EQ(node.op(), "Gather");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "ids");
+      EXPECT_EQ(node.input(1), "indices");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 3);
+
+  auto tensors_expected = EvaluateFetchNodes(item);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  GrapplerItem optimized = item;
+  optimized.graph = output;
+  auto tensors = EvaluateFetchNodes(optimized);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -0,0 +1,143 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_fingerprint.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/platform/byte_order.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace {
+
+// The constants of farmhash, whose Hash64() of strings of 4 to 32 bytes is
+// reproduced below.
+constexpr uint64 k1 = 0xb492b66fbe98f273ULL;
+constexpr uint64 k2 = 0x9ae16a3b2f90404fULL;
+
+// The number of strings hashed together, which bounds the lanes on the stack.
+constexpr int kBlockSize = 64;
+
+inline uint64 Fetch64(const char* p) {
+  uint64 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint64 Fetch32(const char* p) {
+  uint32 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+// Rotates right by `shift`, which is never 0 here.
+inline uint64 Rotate(uint64 value, int shift) {
+  return (value >> shift) | (value << (64 - shift));
+}
+
+// Hashes `strings[0, n)`, with `n` at most kBlockSize.
+void BatchFingerprintBlock(const StringPiece* strings, int n,
+                           uint64* fingerprints) {
+  // The strings of 4 to 7, 8 to 16 and 17 to 32 bytes.
+  int short_strings[kBlockSize];
+  int medium_strings[kBlockSize];
+  int long_strings[kBlockSize];
+  int num_short = 0;
+  int num_medium = 0;
+  int num_long = 0;
+  for (int i = 0; i < n; ++i) {
+    const size_t size = strings[i].size();
+    if (size < 4 || size > 32) {
+      fingerprints[i] = Fingerprint64(strings[i]);
+    } else if (size < 8) {
+      short_strings[num_short++] = i;
+    } else if (size <= 16) {
+      medium_strings[num_medium++] = i;
+    } else {
+      long_strings[num_long++] = i;
+    }
+  }
+
+  // Each length ends in the same mix of two words `u` and `v` with a
+  // multiplier `mul`, which are gathered into lanes.
+  uint64 u[kBlockSize];
+  uint64 v[kBlockSize];
+  uint64 mul[kBlockSize];
+  int lane = 0;
+  for (int k = 0; k < num_short; ++k, ++lane) {
+    const StringPiece s = strings[short_strings[k]];
+    mul[lane] = k2 + s.size() * 2;
+    u[lane] = s.size() + (Fetch32(s.data()) << 3);
+    v[lane] = Fetch32(s.data() + s.size() - 4);
+  }
+  for (int k = 0; k < num_medium; ++k, ++lane) {
+    const StringPiece s = strings[medium_strings[k]];
+    mul[lane] = k2 + s.size() * 2;
+    const uint64 a = Fetch64(s.data()) + k2;
+    const uint64 b = Fetch64(s.data() + s.size() - 8);
+    u[lane] = Rotate(b, 37) * mul[lane] + a;
+    v[lane] = (Rotate(a, 25) + b) * mul[lane];
+  }
+  for (int k = 0; k < num_long; ++k, ++lane) {
+    const StringPiece s = strings[long_strings[k]];
+    mul[lane] = k2 + s.size() * 2;
+    const uint64 a = Fetch64(s.data()) * k1;
+    const uint64 b = Fetch64(s.data() + 8);
+    const uint64 c = Fetch64(s.data() + s.size() - 8) * mul[lane];
+    const uint64 d = Fetch64(s.data() + s.size() - 16) * k2;
+    u[lane] = Rotate(a + b, 43) + Rotate(c, 30) + d;
+    v[lane] = a + Rotate(b + k2, 18) + c;
+  }
+
+  const int num_lanes = lane;
+  for (lane = 0; lane < num_lanes; ++lane) {
+    uint64 a = (u[lane] ^ v[lane]) * mul[lane];
+    a ^= a >> 47;
+    uint64 b = (v[lane] ^ a) * mul[lane];
+    b ^= b >> 47;
+    u[lane] = b * mul[lane];
+  }
+
+  lane = 0;
+  for (int k = 0; k < num_short; ++k) {
+    fingerprints[short_strings[k]] = u[lane++];
+  }
+  for (int k = 0; k < num_medium; ++k) {
+    fingerprints[medium_strings[k]] = u[lane++];
+  }
+  for (int k = 0; k < num_long; ++k) {
+    fingerprints[long_strings[k]] = u[lane++];
+  }
+}
+
+}  // namespace
+
+void BatchFingerprint64(const StringPiece* strings, int64_t n,
+                        uint64* fingerprints) {
+  // The lanes read words in the byte order of farmhash.
+  if (!port::kLittleEndian) {
+    for (int64_t i = 0; i < n; ++i) fingerprints[i] = Fingerprint64(strings[i]);
+    return;
+  }
+  for (int64_t start = 0; start < n; start += kBlockSize) {
+    BatchFingerprintBlock(strings + start,
+                          std::min<int64_t>(kBlockSize, n - start),
+                          fingerprints + start);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,35 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
+#define TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
+
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Sets `fingerprints[i]` to Fingerprint64(`strings[i]`) for `i` < `n`.
+//
+// The strings are grouped by length, and those of 4 to 32 bytes, the usual
+// length of ids, are hashed a group at a time: their words are gathered into
+// lanes, which the final mix of farmhash processes in a loop without branches
+// or dependencies between lanes. Other strings are hashed one at a time.
+void BatchFingerprint64(const StringPiece* strings, int64_t n,
+                        uint64* fingerprints);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
@@ -0,0 +1,61 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_fingerprint.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Checks BatchFingerprint64() of strings of every length up to 80 bytes, at
+// every alignment, in batches mixing lengths.
+TEST(BatchFingerprintTest, MatchesFingerprint64) {
+  std::mt19937 rng(0);
+  std::string data(1 << 16, '\0');
+  for (char& c : data) c = static_cast<char>(rng());
+
+  std::vector<StringPiece> strings;
+  for (int size = 0; size <= 80; ++size) {
+    for (int offset = 0; offset < 8; ++offset) {
+      strings.push_back(StringPiece(data.data() + offset + size * 97, size));
+    }
+  }
+  std::shuffle(strings.begin(), strings.end(), rng);
+
+  std::vector<uint64> fingerprints(strings.size());
+  BatchFingerprint64(strings.data(), strings.size(), fingerprints.data());
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(fingerprints[i], Fingerprint64(strings[i]))
+        << "size " << strings[i].size();
+  }
+}
+
+TEST(BatchFingerprintTest, Empty) {
+  BatchFingerprint64(nullptr, 0, nullptr);
+  const StringPiece empty;
+  uint64 fingerprint;
+  BatchFingerprint64(&empty, 1, &fingerprint);
+  EXPECT_EQ(fingerprint, Fingerprint64(""));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -58,6 +58,8 @@ constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
 constexpr char kFullBatchSchedulingBoostMicros[] =
     "_full_batch_scheduling_boost_micros";
+constexpr char kEnableRaggedBatchingAttr[] = "_enable_ragged_batching";
+constexpr char kRaggedTokenOutputIndicesAttr[] = "_ragged_token_output_indices";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -313,6 +315,21 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     return;
   }
 
+  if (c->HasAttr(kEnableRaggedBatchingAttr)) {
+    OP_REQUIRES_OK(
+        c, c->GetAttr(kEnableRaggedBatchingAttr, &enable_ragged_batching_));
+  }
+  if (c->HasAttr(kRaggedTokenOutputIndicesAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kRaggedTokenOutputIndicesAttr,
+                                 &ragged_token_output_indices_));
+  }
+  for (const int32 index : ragged_token_output_indices_) {
+    OP_REQUIRES(c, index >= 0 && index < c->num_outputs(),
+                errors::InvalidArgument(kRaggedTokenOutputIndicesAttr,
+                                        " must be in [0, ", c->num_outputs(),
+                                        "); got ", index));
+  }
+
   if (enable_adaptive_batch_threads_) {
     // One scheduler instance contains a couple of queue instances,
     // `batcher_queue_` is the key to find queue for this batch-op in the
@@ -411,6 +428,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_ragged_batching_options(
+          {enable_ragged_batching_, ragged_token_output_indices_});
       *r = new_resource.release();
       return OkStatus();
     };
@@ -428,6 +447,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_ragged_batching_options(
+          {enable_ragged_batching_, ragged_token_output_indices_});
       *r = new_resource.release();
       return OkStatus();
     };
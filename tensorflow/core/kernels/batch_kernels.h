@@ -99,6 +99,10 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
   bool enable_adaptive_batch_threads_ = false;
+  // Ragged batching options, see
+  // `serving::BatchResourceBase::RaggedBatchingOptions`.
+  bool enable_ragged_batching_ = false;
+  std::vector<int32> ragged_token_output_indices_;
 
   mutex mu_;
 
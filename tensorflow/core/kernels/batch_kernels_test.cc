@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batch_kernel_test_util.h"
 #include "tensorflow/core/kernels/batching_util/warmup.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -247,8 +248,115 @@ TEST_P(BatchFunctionKernelParallelWarmupTest, ParallelWarmupAutoBatch) {
   }
 }
 
+TEST(BatchFunctionKernelZeroCopyTest, SingleTaskBatchIsNotCopied) {
+  BatchFunctionKernelParallelWarmupTestState test;
+  TF_ASSERT_OK(test.Init(/*enable_splitting=*/false,
+                         /*check_output_shape=*/false));
+  test.AddInputFromList<int64_t>(TensorShape({2}), {123, 456});
+  TF_ASSERT_OK(test.RunOpKernel());
+
+  test::ExpectTensorEqual<int64_t>(*test.GetOutput(0),
+                                   test::AsTensor<int64_t>({123, 456}));
+  // Neither concatenating the input nor splitting the output of a batch that
+  // consists of one unpadded task copies it.
+  EXPECT_TRUE(test.GetOutput(0)->SharesBufferWith(test.GetInput(0)));
+}
+
 INSTANTIATE_TEST_SUITE_P(BatchFunctionKernelParallelWarmupTestSuite,
                          BatchFunctionKernelParallelWarmupTest,
                          ::testing::Bool());
 
+class BatchFunctionKernelRaggedBatchingTestState : public OpsTestBase {
+ public:
+  // Init test fixture with a ragged batch kernel instance, whose function
+  // returns its tokens unchanged.
+  Status Init(const std::vector<int32> &token_output_indices) {
+    static auto *const cpu_device = []() {
+      auto device =
+          DeviceFactory::NewDevice("CPU", {}, "/job:a/replica:0/task:0");
+      return device.release();
+    }();
+    device_ = cpu_device;
+
+    NameAttrList f;
+    f.set_name("ragged_func_to_batch");
+    TF_RETURN_IF_ERROR(flib_def_->AddFunctionDef(FunctionDefHelper::Define(
+        /*Function*/ "ragged_func_to_batch",
+        /*Inputs*/ {"input1:int64", "row_splits:int64"},
+        /*Outputs*/ {"output1:int64"},
+        /*Attribute*/ {},
+        // Node info
+        {{{"output1"}, "Identity", {"input1"}, {{"T", DT_INT64}}}})));
+
+    pflr_ = std::make_unique<ProcessFunctionLibraryRuntime>(
+        device_mgr_.get(), Env::Default(), /*config=*/nullptr,
+        TF_GRAPH_DEF_VERSION, flib_def_.get(), OptimizerOptions(),
+        /*thread_pool=*/nullptr, /*parent=*/nullptr,
+        /*session_metadata=*/nullptr,
+        Rendezvous::Factory{[](const int64, const DeviceMgr *device_mgr,
+                               tsl::core::RefCountPtr<Rendezvous> *r) {
+          *r = tsl::core::RefCountPtr<Rendezvous>(
+              new IntraProcessRendezvous(device_mgr));
+          return OkStatus();
+        }});
+
+    TF_CHECK_OK(NodeDefBuilder("RaggedBatch", "BatchFunction")
+                    .Attr("max_batch_size", 8)
+                    .Attr("num_batch_threads", 8)
+                    .Attr("allowed_batch_sizes", {8})
+                    .Attr("batch_timeout_micros", 100000)
+                    .Attr("max_enqueued_batches", 10)
+                    .Attr("Tin", std::vector<DataType>{DT_INT64})
+                    .Input(std::vector<NodeDefBuilder::NodeOut>(
+                        {NodeDefBuilder::NodeOut({"n1", 0, DT_INT64})}))
+                    .Attr("Tcaptured", std::vector<DataType>{})
+                    .Input(std::vector<NodeDefBuilder::NodeOut>{})
+                    .Attr("Tout", std::vector<DataType>{DT_INT64})
+                    .Attr("f", f)
+                    .Attr("_enable_ragged_batching", true)
+                    .Attr("_ragged_token_output_indices", token_output_indices)
+                    .Finalize(node_def()));
+    return InitOp();
+  }
+
+  void TestBody() override {}
+};
+
+TEST(BatchFunctionKernelRaggedBatchingTest, SplitsTokenOutputs) {
+  // Requests of different lengths are batched without padding them to a
+  // common length, and get their own tokens back.
+  const std::vector<std::pair<TensorShape, std::vector<int64_t>>> requests = {
+      {TensorShape({1, 3}), {1, 2, 3}},
+      {TensorShape({2, 2}), {4, 5, 6, 7}},
+      {TensorShape({1, 1}), {8}}};
+  tsl::BlockingCounter blocking_counter(requests.size());
+  for (const auto &request : requests) {
+    Env::Default()->SchedClosure([&]() {
+      BatchFunctionKernelRaggedBatchingTestState test;
+      TF_CHECK_OK(test.Init(/*token_output_indices=*/{0}));
+      test.AddInputFromArray<int64_t>(request.first, request.second);
+      TF_CHECK_OK(test.RunOpKernel());
+
+      test::ExpectTensorEqual<int64_t>(
+          *test.GetOutput(0),
+          test::AsTensor<int64_t>(request.second, request.first));
+      blocking_counter.DecrementCount();
+    });
+  }
+  blocking_counter.Wait();
+}
+
+TEST(BatchFunctionKernelRaggedBatchingTest, RejectsInvalidInputs) {
+  BatchFunctionKernelRaggedBatchingTestState test;
+  TF_ASSERT_OK(test.Init(/*token_output_indices=*/{0}));
+  test.AddInputFromArray<int64_t>(TensorShape({3}), {1, 2, 3});
+  EXPECT_TRUE(errors::IsInvalidArgument(test.RunOpKernel()));
+}
+
+TEST(BatchFunctionKernelRaggedBatchingTest, RejectsInvalidOutputIndices) {
+  BatchFunctionKernelRaggedBatchingTestState test;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      test.Init(/*token_output_indices=*/{1})));
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include <cmath>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+BatchLatencyModel::BatchLatencyModel(double smoothing)
+    : smoothing_(smoothing) {
+  DCHECK(smoothing > 0 && smoothing <= 1) << smoothing;
+}
+
+int BatchLatencyModel::BucketIndex(int64_t batch_size) {
+  return batch_size <= 1 ? 0 : Log2Ceiling64(batch_size);
+}
+
+void BatchLatencyModel::Record(int64_t batch_size, int64_t latency_micros) {
+  if (batch_size <= 0 || latency_micros < 0) return;
+  const int index = BucketIndex(batch_size);
+  mutex_lock l(mu_);
+  if (static_cast<int>(buckets_.size()) <= index) buckets_.resize(index + 1);
+  Bucket& bucket = buckets_[index];
+  if (bucket.num_observations++ == 0) {
+    bucket.size = batch_size;
+    bucket.latency_micros = latency_micros;
+    return;
+  }
+  bucket.deviation_micros +=
+      smoothing_ * (std::abs(latency_micros - bucket.latency_micros) -
+                    bucket.deviation_micros);
+  bucket.size += smoothing_ * (batch_size - bucket.size);
+  bucket.latency_micros +=
+      smoothing_ * (latency_micros - bucket.latency_micros);
+}
+
+int64_t BatchLatencyModel::PredictMicros(int64_t batch_size) const {
+  tf_shared_lock l(mu_);
+  // The observed buckets closest to `batch_size` from below and above.
+  const Bucket* lower = nullptr;
+  const Bucket* upper = nullptr;
+  for (const Bucket& bucket : buckets_) {
+    if (bucket.num_observations == 0) continue;
+    if (bucket.size <= batch_size &&
+        (lower == nullptr || bucket.size > lower->size)) {
+      lower = &bucket;
+    }
+    if (bucket.size >= batch_size &&
+        (upper == nullptr || bucket.size < upper->size)) {
+      upper = &bucket;
+    }
+  }
+  auto estimate = [](const Bucket* bucket) {
+    return bucket->latency_micros + 2 * bucket->deviation_micros;
+  };
+
+  double prediction;
+  if (lower == nullptr && upper == nullptr) {
+    return 0;
+  } else if (upper == nullptr) {
+    prediction = estimate(lower) * batch_size / lower->size;
+  } else if (lower == nullptr || upper->size == lower->size) {
+    // Processing smaller batches is not expected to take longer.
+    prediction = estimate(upper);
+  } else {
+    const double weight =
+        (batch_size - lower->size) / (upper->size - lower->size);
+    prediction = estimate(lower) + weight * (estimate(upper) - estimate(lower));
+  }
+  return static_cast<int64_t>(std::ceil(prediction));
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,75 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Learns how long processing a batch takes as a function of its size, from
+// observed processing times.
+//
+// Observations are grouped into buckets of batch sizes (1, 2, 3-4, 5-8, ...),
+// each of which keeps exponentially weighted moving averages of the size,
+// latency and absolute latency deviation of the batches it observed. The
+// latency of other sizes is interpolated linearly between the neighboring
+// buckets, and extrapolated proportionally to the size above the largest one.
+//
+// This object is thread-safe.
+class BatchLatencyModel {
+ public:
+  // `smoothing` is the weight of a new observation in the moving averages, in
+  // (0, 1].
+  explicit BatchLatencyModel(double smoothing = 0.2);
+
+  // Records that processing a batch of `batch_size` took `latency_micros`.
+  void Record(int64_t batch_size, int64_t latency_micros);
+
+  // Returns a conservative estimate (the average plus twice the average
+  // deviation) of the time it takes to process a batch of `batch_size`, or 0
+  // if no batch has been recorded yet.
+  int64_t PredictMicros(int64_t batch_size) const;
+
+ private:
+  struct Bucket {
+    int64_t num_observations = 0;
+    double size = 0;
+    double latency_micros = 0;
+    double deviation_micros = 0;
+  };
+
+  // Returns the index of the bucket of `batch_size`.
+  static int BucketIndex(int64_t batch_size);
+
+  const double smoothing_;
+
+  mutable mutex mu_;
+  std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BatchLatencyModel);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
@@ -0,0 +1,65 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(BatchLatencyModelTest, NoObservations) {
+  BatchLatencyModel model;
+  EXPECT_EQ(model.PredictMicros(1), 0);
+  EXPECT_EQ(model.PredictMicros(100), 0);
+}
+
+TEST(BatchLatencyModelTest, InterpolatesAndExtrapolates) {
+  BatchLatencyModel model;
+  model.Record(2, 100);
+  model.Record(8, 400);
+
+  EXPECT_EQ(model.PredictMicros(2), 100);
+  EXPECT_EQ(model.PredictMicros(8), 400);
+  // Linear between observed sizes.
+  EXPECT_EQ(model.PredictMicros(4), 200);
+  // Proportional above the largest observed size.
+  EXPECT_EQ(model.PredictMicros(16), 800);
+  // Bounded by the smallest observed size below it.
+  EXPECT_EQ(model.PredictMicros(1), 100);
+}
+
+TEST(BatchLatencyModelTest, TracksChangesAndDeviation) {
+  BatchLatencyModel model(/*smoothing=*/0.5);
+  model.Record(4, 100);
+  model.Record(4, 300);
+  // Average 200, deviation 0.5 * 200 = 100.
+  EXPECT_EQ(model.PredictMicros(4), 400);
+
+  for (int i = 0; i < 50; ++i) model.Record(4, 50);
+  EXPECT_NEAR(model.PredictMicros(4), 50, 1);
+}
+
+TEST(BatchLatencyModelTest, IgnoresInvalidObservations) {
+  BatchLatencyModel model;
+  model.Record(0, 100);
+  model.Record(4, -1);
+  EXPECT_EQ(model.PredictMicros(4), 0);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -192,6 +192,35 @@ void RecordBatchDelayUsV2(int64_t batch_delay_us, const string& model_name,
       ->Add(static_cast<double>(batch_delay_us));
 }
 
+void RecordPriorityClassBatchDelayUs(int64_t batch_delay_us,
+                                     const string& model_name,
+                                     const string& op_name,
+                                     int priority_class) {
+  static auto* cell = tensorflow::monitoring::Sampler<3>::New(
+      {"/tensorflow/serving/batching/priority_class_batch_delay_us",
+       "Tracks the batching delay (in microseconds) for inputs by model_name "
+       "(if available) and priority class.",
+       "model_name", "op_name", "priority_class"},
+      monitoring::Buckets::Exponential(1, 2, 27));
+  cell->GetCell(model_name, op_name, absl::StrCat(priority_class))
+      ->Add(static_cast<double>(batch_delay_us));
+}
+
+void RecordPriorityClassBatchFillRatio(double fill_ratio,
+                                       const string& model_name,
+                                       const string& op_name,
+                                       int priority_class) {
+  static auto* cell = tensorflow::monitoring::Sampler<3>::New(
+      {"/tensorflow/serving/batching/priority_class_batch_fill_ratio",
+       "Tracks the fraction of the processed batch size filled by inputs of "
+       "each priority class by model_name (if available).",
+       "model_name", "op_name", "priority_class"},
+      monitoring::Buckets::Explicit(
+          {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0}));
+  cell->GetCell(model_name, op_name, absl::StrCat(priority_class))
+      ->Add(fill_ratio);
+}
+
 void RecordBatchParamBatchTimeoutMicros(int64_t batch_timeout_micros,
                                         const string& model_name,
                                         const string& op_name) {
@@ -238,6 +267,67 @@ const string& GetModelName(OpKernelContext* ctx) {
   return ctx->session_metadata()->name();
 }
 
+// Merges the row and token dimensions of `input`, of shape [rows, length,
+// ...], into one of size rows * length. The result shares the buffer of
+// `input`.
+Tensor MergeRowsAndTokens(const Tensor& input) {
+  TensorShape shape = input.shape();
+  shape.set_dim(0, input.dim_size(0) * input.dim_size(1));
+  shape.RemoveDim(1);
+  Tensor tokens;
+  CHECK(tokens.CopyFrom(input, shape));
+  return tokens;
+}
+
+// Inverse of `MergeRowsAndTokens`.
+Tensor SplitRowsAndTokens(const Tensor& tokens, int64_t rows, int64_t length) {
+  TensorShape shape = tokens.shape();
+  shape.set_dim(0, length);
+  shape.InsertDim(0, rows);
+  Tensor input;
+  CHECK(input.CopyFrom(tokens, shape));
+  return input;
+}
+
+// The priority classes of batch tasks when the priority queue is enabled.
+enum PriorityClass {
+  kHighPriorityClass = 0,
+  kLowPriorityClass = 1,
+  kNumPriorityClasses = 2,
+};
+
+// The share of the batch slots that high priority tasks get relative to low
+// priority ones when both are enqueued.
+constexpr int kHighPriorityClassWeight = 4;
+
+int GetPriorityClass(const BatchResourceBase::BatchTask& task) {
+  return task.criticality >= tsl::criticality::Criticality::kCritical
+             ? kHighPriorityClass
+             : kLowPriorityClass;
+}
+
+// Records the batching delay of each task in `batch`, and the fraction of
+// `processed_size` filled by each priority class.
+void RecordPriorityClassMetrics(const BatchResourceBase::BatchT& batch,
+                                int64_t processed_size, uint64 current_time,
+                                const string& model_name,
+                                const string& op_name) {
+  int64_t class_sizes[kNumPriorityClasses] = {};
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    const BatchResourceBase::BatchTask& task = batch.task(i);
+    const int priority_class = GetPriorityClass(task);
+    class_sizes[priority_class] += task.size();
+    RecordPriorityClassBatchDelayUs((current_time - task.start_time) * 1e-3,
+                                    model_name, op_name, priority_class);
+  }
+  if (processed_size <= 0) return;
+  for (int i = 0; i < kNumPriorityClasses; ++i) {
+    RecordPriorityClassBatchFillRatio(
+        static_cast<double>(class_sizes[i]) / processed_size, model_name,
+        op_name, i);
+  }
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -331,6 +421,15 @@ Status BatchResourceBase::RegisterInput(
           "have equal 0th-dimension size.\nBelow are the input tensors: \n",
           GetTensorNamesAndShapesString(context, tensors));
     }
+    if (ragged_batching_options_.enabled &&
+        (tensor.shape().dims() < 2 ||
+         tensor.shape().dim_size(1) != tensors[0].shape().dim_size(1))) {
+      return errors::InvalidArgument(
+          "With ragged batching, batching input tensors must have at least two "
+          "dimensions, and those supplied in a given op invocation must have "
+          "equal 1st-dimension size.\nBelow are the input tensors: \n",
+          GetTensorNamesAndShapesString(context, tensors));
+    }
     batch_components->inputs.push_back(tensor);
   }
   RecordInputBatchSize(tensors[0].shape().dim_size(0), GetModelName(context),
@@ -449,6 +548,22 @@ BatchResourceBase::GetBatcherQueueOptions(
   batcher_queue_options.batch_timeout_micros = batch_timeout_micros;
   if (low_priority_max_batch_size > 0) {
     batcher_queue_options.enable_priority_queue = true;
+    // Low priority tasks mostly fill the spare slots of high priority batches,
+    // and only form batches of their own after their (typically longer)
+    // timeout.
+    batcher_queue_options.get_task_priority_class = GetPriorityClass;
+    batcher_queue_options.priority_classes.resize(kNumPriorityClasses);
+    auto& high_priority_class =
+        batcher_queue_options.priority_classes[kHighPriorityClass];
+    high_priority_class.weight = kHighPriorityClassWeight;
+    high_priority_class.batch_timeout_micros = batch_timeout_micros;
+    auto& low_priority_class =
+        batcher_queue_options.priority_classes[kLowPriorityClass];
+    low_priority_class.weight = 1;
+    low_priority_class.batch_timeout_micros = low_priority_batch_timeout_micros;
+    low_priority_class.max_enqueued_size =
+        static_cast<size_t>(std::max(low_priority_max_enqueued_batches, 0)) *
+        low_priority_max_batch_size;
   }
   batcher_queue_options.high_priority_queue_options.input_batch_size_limit =
       max_batch_size;
@@ -544,7 +659,8 @@ BatchResourceBase::GetAdaptiveBatcherQueueOptions(
 // or equal to 'batch_size'. If 'allowed_batch_sizes_' is empty, simply
 // returns 'batch_size'.
 int BatchResourceBase::RoundToLowestAllowedBatchSize(int batch_size) const {
-  if (batcher_queue_options_.disable_padding || allowed_batch_sizes_.empty()) {
+  if (batcher_queue_options_.disable_padding || allowed_batch_sizes_.empty() ||
+      ragged_batching_options_.enabled) {
     return batch_size;
   }
   for (int allowed_size : allowed_batch_sizes_) {
@@ -589,6 +705,10 @@ Status BatchResourceBase::ConcatInputTensors(
   RecordBatchSize(batch.size(), GetModelName(context),
                   context->op_kernel().name());
 
+  if (ragged_batching_options_.enabled) {
+    return ConcatRaggedInputTensors(batch, context, concatenated_tensors);
+  }
+
   // All tasks should have the same number of input edges.
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
@@ -638,6 +758,60 @@ Status BatchResourceBase::ConcatInputTensors(
   return OkStatus();
 }
 
+Status BatchResourceBase::ConcatRaggedInputTensors(
+    const BatchT& batch, OpKernelContext* context,
+    std::vector<Tensor>* concatenated_tensors) const {
+  // Warmup batches consist of copies of the first row of the first task.
+  const int num_warmup_rows = batch.task(0).forced_warmup_batch_size;
+  const int num_rows = num_warmup_rows > 0 ? num_warmup_rows : batch.size();
+
+  Tensor row_splits(DT_INT64, TensorShape({num_rows + 1}));
+  auto row_splits_vec = row_splits.vec<int64_t>();
+  row_splits_vec(0) = 0;
+  int row = 0;
+  auto add_rows = [&row, &row_splits_vec](int64_t rows, int64_t length) {
+    for (int64_t i = 0; i < rows; ++i, ++row) {
+      row_splits_vec(row + 1) = row_splits_vec(row) + length;
+    }
+  };
+  if (num_warmup_rows > 0) {
+    add_rows(num_warmup_rows, batch.task(0).inputs[0].dim_size(1));
+  } else {
+    for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+      const BatchTask& task = batch.task(task_idx);
+      add_rows(task.size(), task.inputs[0].dim_size(1));
+    }
+  }
+  profiler::TraceMe trace_me([num_rows, num_tokens = row_splits_vec(row)]() {
+    return profiler::TraceMeEncode(
+        "ConcatRaggedInputTensors",
+        {{"batch_size", num_rows}, {"num_tokens", num_tokens}});
+  });
+
+  const int num_inputs = batch.task(0).inputs.size();
+  concatenated_tensors->reserve(num_inputs + 1);
+  for (int i = 0; i < num_inputs; ++i) {
+    std::vector<Tensor> to_concatenate;
+    if (num_warmup_rows > 0) {
+      const Tensor padding =
+          MergeRowsAndTokens(batch.task(0).inputs.at(i).Slice(0, 1));
+      to_concatenate.assign(num_warmup_rows, padding);
+    } else {
+      to_concatenate.reserve(batch.num_tasks());
+      for (int task_idx = 0; task_idx < batch.num_tasks(); ++task_idx) {
+        to_concatenate.push_back(
+            MergeRowsAndTokens(batch.task(task_idx).inputs.at(i)));
+      }
+    }
+
+    Tensor concatenated_tensor;
+    TF_RETURN_IF_ERROR(Concat(context, to_concatenate, &concatenated_tensor));
+    concatenated_tensors->push_back(std::move(concatenated_tensor));
+  }
+  concatenated_tensors->push_back(std::move(row_splits));
+  return OkStatus();
+}
+
 /*static*/ Status BatchResourceBase::SplitInputTask(
     std::unique_ptr<BatchTask>* input_task_ptr, int open_batch_remaining_slot,
     int max_batch_size, std::vector<std::unique_ptr<BatchTask>>* output_tasks) {
@@ -754,6 +928,21 @@ Status BatchResourceBase::SplitOutputTensors(
     task_sizes_plus_optional_padding.push_back(padding_size);
   }
 
+  // With ragged batching, the number of tokens of each task.
+  std::vector<int64_t> task_num_tokens;
+  int64_t num_tokens = 0;
+  if (ragged_batching_options_.enabled) {
+    task_num_tokens.reserve(batch->num_tasks());
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      const BatchTask& task = batch->task(i);
+      task_num_tokens.push_back(static_cast<int64_t>(task.size()) *
+                                task.inputs[0].dim_size(1));
+      num_tokens += task_num_tokens.back();
+    }
+  }
+  const std::vector<int32>& token_output_indices =
+      ragged_batching_options_.token_output_indices;
+
   DCHECK_EQ(batch->task(0).context->num_outputs(), combined_outputs.size());
   int combined_outputs_size = combined_outputs.size();
   if (combined_outputs_size != batch->task(0).context->num_outputs()) {
@@ -768,32 +957,52 @@ Status BatchResourceBase::SplitOutputTensors(
       return errors::FailedPrecondition(
           "Batched output tensor has 0 dimensions");
     }
-    if (output_tensor.shape().dim_size(0) !=
-        static_cast<int64_t>(batch->size() + padding_size)) {
+    const bool is_token_output =
+        ragged_batching_options_.enabled &&
+        std::find(token_output_indices.begin(), token_output_indices.end(),
+                  i) != token_output_indices.end();
+    if (is_token_output) {
+      if (output_tensor.shape().dim_size(0) != num_tokens) {
+        return errors::FailedPrecondition(
+            "Batched token output tensor ", i,
+            "'s 0th dimension does not equal the number of tokens of the "
+            "input tensors; got ",
+            output_tensor.shape().dim_size(0), ", expected ", num_tokens);
+      }
+    } else if (output_tensor.shape().dim_size(0) !=
+               static_cast<int64_t>(batch->size() + padding_size)) {
       return errors::FailedPrecondition(
           "Batched output tensor's 0th dimension does not equal the sum of "
           "the 0th dimension sizes of the input tensors");
     }
+    const std::vector<int64_t>& split_sizes =
+        is_token_output ? task_num_tokens : task_sizes_plus_optional_padding;
 
+    // The splits share the buffer of the batched output where possible, so
+    // the outputs of the tasks are not copied.
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+    const Status split_status =
+        Split(batch->task(batch->num_tasks() - 1).context, output_tensor,
+              split_sizes, &split_tensor);
     DCHECK(split_status.ok()) << split_status;
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
                               split_status.message());
     }
-    DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
-    if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
+    DCHECK_EQ(split_tensor.size(), split_sizes.size());
+    if (split_tensor.size() != split_sizes.size()) {
       return errors::Internal(
           "Tensor split operation did not work as expected; got ",
-          split_tensor.size(), " splits; expected ",
-          task_sizes_plus_optional_padding.size());
+          split_tensor.size(), " splits; expected ", split_sizes.size());
     }
 
     // Ignore a possible final split_tensors entry containing the padding.
     for (int j = 0; j < batch->num_tasks(); ++j) {
       BatchTask& task = *(batch->mutable_task(j));
+      if (is_token_output) {
+        split_tensor[j] = SplitRowsAndTokens(split_tensor[j], task.size(),
+                                             task.inputs[0].dim_size(1));
+      }
       if (task.is_partial) {
         std::vector<Tensor>& tensor_vector = (*task.output)[task.split_index];
         tensor_vector[i] = std::move(split_tensor[j]);
@@ -885,6 +1094,11 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
                          model_name, last_task_context->op_kernel().name(),
                          processed_size);
   }
+  if (batcher_queue_options_.enable_priority_queue) {
+    RecordPriorityClassMetrics(*batch, processed_size, current_time,
+                               model_name,
+                               last_task_context->op_kernel().name());
+  }
   // Releases the cleanup method here, because the callback of the function
   // library runtime will handle it now.
   finally.release();
@@ -1040,7 +1254,24 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
     }
   };
   if (batcher_) {
-    TF_RETURN_IF_ERROR(batcher_->AddQueue(batcher_queue_options_,
+    BatcherT::QueueOptions batcher_queue_options = batcher_queue_options_;
+    if (batcher_queue_options.get_task_priority_class) {
+      batcher_queue_options.evict_task_callback =
+          [this](std::unique_ptr<BatchTask> task, const Status& status) {
+            if (!session_metadata().name().empty()) {
+              absl::MutexLock lock(&outstanding_batch_mu_);
+              num_outstanding_batched_items_ -= task->size();
+            }
+            WithContext wc(task->propagated_context);
+            if (task->is_partial) {
+              task->status->Update(status);
+            } else {
+              task->context->SetStatus(status);
+            }
+            task->done_callback();
+          };
+    }
+    TF_RETURN_IF_ERROR(batcher_->AddQueue(batcher_queue_options,
                                           process_batch_callback, &new_queue));
   } else if (adaptive_batcher_) {
     TF_RETURN_IF_ERROR(adaptive_batcher_->AddQueue(
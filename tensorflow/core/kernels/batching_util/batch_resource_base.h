@@ -159,6 +159,30 @@ class BatchResourceBase : public ResourceBase {
 
   const SessionMetadata& session_metadata() const { return session_metadata_; }
 
+  // Options for batching variable-length inputs without padding them.
+  //
+  // When enabled, every batched input must have shape [rows, length, ...],
+  // where `length` may differ between op invocations but is the same for all
+  // inputs of one invocation. Instead of padding the inputs to a common shape,
+  // the rows of all tasks are flattened and concatenated along the token axis
+  // into tensors of shape [total_tokens, ...], and an int64 `row_splits` vector
+  // of size [num_rows + 1] (in the tf.RaggedTensor sense) is passed to the
+  // batched function right after them, before the captured inputs. Batches
+  // are not padded to `allowed_batch_sizes` either.
+  //
+  // Outputs listed in `token_output_indices` are expected to be batched along
+  // the token axis as well and are split back into the shape [rows, length,
+  // ...] of the corresponding invocation; the other outputs are split along
+  // rows as usual.
+  struct RaggedBatchingOptions {
+    bool enabled = false;
+    std::vector<int32> token_output_indices;
+  };
+
+  void set_ragged_batching_options(RaggedBatchingOptions options) {
+    ragged_batching_options_ = std::move(options);
+  }
+
   using CreateBatchTaskFn =
       std::function<StatusOr<std::unique_ptr<BatchTask>>()>;
 
@@ -260,6 +284,13 @@ class BatchResourceBase : public ResourceBase {
   Status ConcatInputTensors(const BatchT& batch, OpKernelContext* context,
                             std::vector<Tensor>* concatenated_tensors) const;
 
+  // Like `ConcatInputTensors`, but concatenates the inputs along the token
+  // axis and appends the row splits of the batch, as described in
+  // `RaggedBatchingOptions`.
+  Status ConcatRaggedInputTensors(
+      const BatchT& batch, OpKernelContext* context,
+      std::vector<Tensor>* concatenated_tensors) const;
+
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
                             BatchT* batch) const;
 
@@ -285,6 +316,8 @@ class BatchResourceBase : public ResourceBase {
 
   SessionMetadata session_metadata_;
 
+  RaggedBatchingOptions ragged_batching_options_;
+
   absl::Mutex outstanding_batch_mu_;
   int num_outstanding_batched_items_ TF_GUARDED_BY(outstanding_batch_mu_) = 0;
 
@@ -33,10 +33,16 @@ typedef Eigen::GpuDevice GPUDevice;
 // Concatenates 'inputs' into a single tensor along the zeroth dimension.
 // Requires that all elements of 'inputs' have element type T. Writes to
 // 'output' using 'context' for the allocation to ensure proper device
-// placement.
+// placement. A single input is not copied; 'output' shares its buffer.
 template <typename T>
 Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor> inputs,
               Tensor* output) {
+  // Special case: trivial 1-way concat, e.g. a batch made of a single task.
+  if (inputs.size() == 1) {
+    *output = inputs[0];
+    return OkStatus();
+  }
+
   const int input_dims = inputs[0].dims();
   const TensorShape& input_shape = inputs[0].shape();
 
@@ -111,8 +117,9 @@ inline Status Concat(OpKernelContext* context,
 
 // The Split*() functions split 'input' with element type T into 'sizes.size()'
 // tensors along the zeroth dimension, with the ith split having zeroth-
-// dimension size 'sizes[i]'. They allocate the output tensors using 'context',
-// for proper device placement.
+// dimension size 'sizes[i]'. Splits that are aligned share the buffer of
+// 'input' (and keep it alive); the others are allocated using 'context', for
+// proper device placement.
 
 // Handles special cases that are cheap. Sets 'done==true' iff it found an
 // applicable special case and wrote to the outputs. Otherwise acts as a no-op.
@@ -166,6 +173,15 @@ Status SplitCPU(OpKernelContext* context, const Tensor& input,
 
   int64_t position = 0;
   for (const int64_t size : sizes) {
+    // Even if the inner dimensions are not aligned, some of the splits may
+    // start at an aligned offset.
+    Tensor slice = input.Slice(position, position + size);
+    if (slice.IsAligned()) {
+      outputs->push_back(std::move(slice));
+      position += size;
+      continue;
+    }
+
     TensorShape output_shape = input.shape();
     output_shape.set_dim(0, size);
     Tensor output;
@@ -18,8 +18,10 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -30,6 +32,7 @@ limitations under the License.
 #include "absl/types/variant.h"
 #include "absl/utility/utility.h"
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -100,6 +103,31 @@ namespace serving {
 // For bulk processing jobs and throughput-oriented benchmarks, you may want to
 // set the maximum queue size to a large value.
 //
+// DEADLINE-AWARE BATCHING: Queues created with a `get_task_deadline_micros`
+// function learn how long their batches take to process as a function of
+// their size, and also close the open batch once waiting any longer would make
+// its earliest deadline unattainable. This allows a large batch timeout (e.g.
+// the latency SLO) to be used without risking the deadlines of the requests.
+// If `Options.enable_deadline_aware_scheduling` is true, threads also serve
+// the schedulable batch with the least slack (time left until its earliest
+// deadline, minus its predicted processing time) among those that can still
+// meet their deadline, before those that cannot, and fall back to round-robin
+// for batches without deadlines. Batches without deadlines may thus be delayed
+// indefinitely while batches with deadlines saturate the threads.
+//
+// PRIORITY BATCHING: Queues created with a `get_task_priority_class` function
+// keep the tasks of each priority class in a separate FIFO, and only form a
+// batch once a thread asks for one, which happens when the enqueued tasks fill
+// a batch or the oldest task of a class reaches the batch timeout of its class.
+// The batch slots are then shared by the classes with enqueued tasks in
+// proportion to their weights (weighted fair queueing), and slots left over by
+// a class are filled with the tasks of the others. Giving the lower-priority
+// classes small weights and long timeouts thus lets them ride along in the
+// spare slots of higher-priority batches, and defers them while the
+// higher-priority classes need the slots. When the queue is full, the most
+// recently enqueued tasks of lower-priority classes are evicted to make room
+// for the tasks of higher-priority ones.
+//
 // TODO(b/26539183): Support queue servicing policies other than round-robin.
 // E.g. let each queue specify a "share" (an int >= 1), so e.g. with queues A
 // and B having shares 1 and 2 respectively, the servicing pattern is ABBABB...
@@ -128,6 +156,11 @@ class SharedBatchScheduler
     // The environment to use.
     // (Typically only overridden by test code.)
     Env* env = Env::Default();
+
+    // If true, batch threads serve the batches of queues with task deadlines
+    // in order of urgency rather than round-robin. See the class
+    // documentation above.
+    bool enable_deadline_aware_scheduling = false;
   };
   // Ownership is shared between the caller of Create() and any queues created
   // via AddQueue().
@@ -228,6 +261,10 @@ class SharedBatchScheduler
 
     // A separate set of queue options for different priority inputs.
     // Use iff `enable_priority_queue` is true.
+    //
+    // These options are not interpreted by the queue itself; users such as
+    // BatchResourceBase translate them into `get_task_priority_class` and
+    // `priority_classes` below.
     struct PriorityQueueOptions {
       // See QueueOptions.max_execution_batch_size
       size_t max_execution_batch_size = 0;
@@ -242,6 +279,55 @@ class SharedBatchScheduler
     PriorityQueueOptions high_priority_queue_options;
     // A subset of queue options for low priority input.
     PriorityQueueOptions low_priority_queue_options;
+
+    // If set, returns the deadline of a task, as an absolute time in
+    // microseconds of `Options.env`'s clock, or a non-positive value if the
+    // task has no deadline. Enables deadline-aware batching for the queue (see
+    // the class documentation above).
+    //
+    // Must not be set if `enable_lazy_split` is true.
+    std::function<int64_t(const TaskType& task)> get_task_deadline_micros;
+
+    // The model of batch processing times used for deadline-aware batching.
+    // If null, the queue learns its own model from its batches. Sharing a
+    // model allows queues serving the same model to learn from each other, or
+    // a model to be initialized from previous measurements.
+    std::shared_ptr<BatchLatencyModel> batch_latency_model;
+
+    // If set, returns the priority class of a task, in
+    // [0, `priority_classes.size()`), lower classes having higher priority.
+    // Enables priority batching for the queue (see the class documentation
+    // above).
+    //
+    // Must not be set if `enable_lazy_split` is true or
+    // `get_task_deadline_micros` is set.
+    std::function<int(const TaskType& task)> get_task_priority_class;
+
+    // Options of a priority class.
+    struct PriorityClassOptions {
+      // The share of batch slots the class gets relative to the weights of the
+      // other classes with enqueued tasks. Must be positive.
+      int weight = 1;
+
+      // A batch is formed once the oldest enqueued task of the class has been
+      // enqueued for this amount of time. See `batch_timeout_micros`.
+      int64_t batch_timeout_micros = 0;
+
+      // The maximum total size of the enqueued tasks of the class, or 0 for no
+      // limit other than the capacity of the queue.
+      size_t max_enqueued_size = 0;
+    };
+    // The options of each priority class. Use iff `get_task_priority_class` is
+    // set. The capacity of the queue is `max_enqueued_batches` times
+    // `max_execution_batch_size`, shared by all classes.
+    std::vector<PriorityClassOptions> priority_classes;
+
+    // Completes an enqueued task that was evicted to make room for a
+    // higher-priority task with `status`. Called outside of the queue's lock,
+    // before Schedule() returns for the higher-priority task. Required iff
+    // `get_task_priority_class` is set.
+    std::function<void(std::unique_ptr<TaskType> task, const Status& status)>
+        evict_task_callback;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -352,6 +438,10 @@ class Queue {
   // dequeued (out of mutex-protected area).
   Status ScheduleWithLazySplit(std::unique_ptr<TaskType>* task);
 
+  // Enqueue `task` in the FIFO of its priority class, from which batches are
+  // formed when they are scheduled.
+  Status ScheduleWithPriority(std::unique_ptr<TaskType>* task);
+
   // Returns the number of enqueued tasks, with the same semantics as
   // BatchScheduler::NumEnqueuedTasks().
   size_t NumEnqueuedTasks() const;
@@ -381,6 +471,11 @@ class Queue {
   // Processes a batch that has been returned earlier by ScheduleBatch().
   void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
 
+  // If ScheduleBatch() would return a batch with a task deadline, sets
+  // `*slack_micros` to the time left until its earliest deadline minus its
+  // predicted processing time, and returns true. Returns false otherwise.
+  bool GetSchedulableBatchSlack(int64_t* slack_micros) const;
+
   // Determines whether the queue is empty, i.e. has no tasks waiting or being
   // processed.
   bool IsEmpty() const;
@@ -407,6 +502,16 @@ class Queue {
     }
   }
 
+  // Returns the batch latency model of the queue based on queue options.
+  static std::shared_ptr<BatchLatencyModel> GetBatchLatencyModel(
+      const typename SharedBatchScheduler<TaskType>::QueueOptions& options) {
+    if (!options.get_task_deadline_micros) return nullptr;
+    if (options.batch_latency_model != nullptr) {
+      return options.batch_latency_model;
+    }
+    return std::make_shared<BatchLatencyModel>();
+  }
+
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -445,6 +550,32 @@ class Queue {
   // Returns the number of enqueued batches.
   int64 num_enqueued_batches() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Returns the deadline of `task`, or kNoDeadlineMicros.
+  int64_t TaskDeadlineMicros(const TaskType& task) const;
+
+  // Returns whether the open batch must be closed now for its earliest
+  // deadline to be met.
+  bool IsOpenBatchDue() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Whether the queue batches tasks by priority class.
+  bool IsPriorityBatching() const {
+    return options_.get_task_priority_class != nullptr;
+  }
+
+  // Returns the number of tasks enqueued in the priority classes.
+  size_t NumPrioritizedTasks() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Determines whether a batch should be formed from the priority classes.
+  bool IsPrioritizedBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Forms a closed batch from the tasks of the priority classes.
+  std::unique_ptr<Batch<TaskType>> FormPrioritizedBatch()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Represents the absence of a deadline.
+  static constexpr int64_t kNoDeadlineMicros =
+      std::numeric_limits<int64_t>::max();
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -455,6 +586,10 @@ class Queue {
   // `GetMaxExecutionBatchSize` for more details on what it means.
   const size_t max_execution_batch_size_;
 
+  // Predicts batch processing times. Null iff the queue has no
+  // `get_task_deadline_micros` function.
+  const std::shared_ptr<BatchLatencyModel> batch_latency_model_;
+
   // A callback invoked to processes a batch of work units. Always invoked
   // from a batch thread.
   ProcessBatchCallback process_batch_callback_;
@@ -486,13 +621,34 @@ class Queue {
   std::deque<std::unique_ptr<Batch<BatchInputTaskHandle<TaskType>>>>
       task_handle_batches_ TF_GUARDED_BY(mu_);
 
-  // The enqueued batches for low priority input
-  std::deque<std::unique_ptr<Batch<TaskType>>> low_priority_batches_
-      TF_GUARDED_BY(mu_);
+  // The enqueued tasks of a priority class.
+  struct PriorityClass {
+    struct EnqueuedTask {
+      std::unique_ptr<TaskType> task;
+      uint64 enqueue_time_micros;
+    };
+    // In the order they were enqueued.
+    std::deque<EnqueuedTask> tasks;
+    // The total size of `tasks`.
+    size_t size = 0;
+    // The total size of the tasks of the class added to batches divided by
+    // its weight, not counting the time the class had no enqueued tasks. The
+    // class with the lowest virtual time is served next.
+    double virtual_time = 0;
+  };
+
+  // The priority classes, indexed by `get_task_priority_class`.
+  //
+  // Used iff `QueueOptions.get_task_priority_class` is set. `batches_` then
+  // only holds an empty open batch.
+  std::vector<PriorityClass> priority_classes_ TF_GUARDED_BY(mu_);
+
+  // The total size of the tasks in `priority_classes_`.
+  size_t prioritized_tasks_size_ TF_GUARDED_BY(mu_) = 0;
 
-  // The enqueued batches for high priority input
-  std::deque<std::unique_ptr<Batch<TaskType>>> high_priority_batches_
-      TF_GUARDED_BY(mu_);
+  // The virtual time of the class last served. Classes that get new tasks
+  // after having none start from it.
+  double virtual_time_ TF_GUARDED_BY(mu_) = 0;
 
   // The counter of the TraceMe context ids.
   uint64 traceme_context_id_counter_ TF_GUARDED_BY(mu_) = 0;
@@ -501,6 +657,10 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // The earliest deadline of the tasks in the open (back-most) batch in
+  // 'batches_', or kNoDeadlineMicros.
+  int64_t open_batch_deadline_micros_ TF_GUARDED_BY(mu_) = kNoDeadlineMicros;
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -635,6 +795,40 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "enable_large_batch_splitting is enabled.");
   }
 
+  if (options.enable_lazy_split && options.get_task_deadline_micros) {
+    return errors::InvalidArgument(
+        "get_task_deadline_micros is not supported when enable_lazy_split is "
+        "enabled.");
+  }
+
+  if (options.get_task_priority_class) {
+    if (options.enable_lazy_split || options.get_task_deadline_micros) {
+      return errors::InvalidArgument(
+          "get_task_priority_class is not supported when enable_lazy_split is "
+          "enabled or get_task_deadline_micros is set.");
+    }
+    if (options.priority_classes.empty()) {
+      return errors::InvalidArgument(
+          "priority_classes must be specified when get_task_priority_class is "
+          "set.");
+    }
+    for (const auto& priority_class : options.priority_classes) {
+      if (priority_class.weight <= 0 ||
+          priority_class.batch_timeout_micros < 0) {
+        return errors::InvalidArgument(
+            "Priority class weights must be positive and batch timeouts "
+            "non-negative; were ",
+            priority_class.weight, " and ",
+            priority_class.batch_timeout_micros);
+      }
+    }
+    if (options.evict_task_callback == nullptr) {
+      return errors::InvalidArgument(
+          "evict_task_callback must be specified when get_task_priority_class "
+          "is set.");
+    }
+  }
+
   if (options.enable_large_batch_splitting &&
       (options.input_batch_size_limit < options.max_execution_batch_size)) {
     return errors::InvalidArgument(
@@ -697,6 +891,34 @@ void SharedBatchScheduler<TaskType>::GetNextWorkItem_Locked(
     BatchUniquePtr* batch_to_process_out) {
   BatchUniquePtr batch_to_process;
   internal::Queue<TaskType>* queue_for_batch = nullptr;
+  if (options_.enable_deadline_aware_scheduling) {
+    // Serves the batch closest to missing its deadline among those that can
+    // still meet it, or else the one that misses it by the least.
+    auto urgency = [](int64_t slack_micros) {
+      return slack_micros >= 0 ? std::make_pair(0, slack_micros)
+                               : std::make_pair(1, -slack_micros);
+    };
+    internal::Queue<TaskType>* most_urgent_queue = nullptr;
+    int64_t most_urgent_slack_micros = 0;
+    for (const auto& queue : queues_) {
+      int64_t slack_micros;
+      if (queue->GetSchedulableBatchSlack(&slack_micros) &&
+          (most_urgent_queue == nullptr ||
+           urgency(slack_micros) < urgency(most_urgent_slack_micros))) {
+        most_urgent_queue = queue.get();
+        most_urgent_slack_micros = slack_micros;
+      }
+    }
+    if (most_urgent_queue != nullptr) {
+      batch_to_process = most_urgent_queue->ScheduleBatch();
+      if (BatchExists(batch_to_process)) {
+        *queue_for_batch_out = most_urgent_queue;
+        *batch_to_process_out = std::move(batch_to_process);
+        return;
+      }
+    }
+  }
+
   const int num_queues = queues_.size();
   for (int num_queues_tried = 0;
        !BatchExists(batch_to_process) && num_queues_tried < num_queues;
@@ -792,6 +1014,7 @@ Queue<TaskType>::Queue(
     : options_(options),
       env_(env),
       max_execution_batch_size_(GetMaxExecutionBatchSize(options_)),
+      batch_latency_model_(GetBatchLatencyModel(options_)),
       process_batch_callback_(process_batch_callback),
       schedulable_batch_callback_(schedulable_batch_callback) {
   // Set the higher 32 bits of traceme_context_id_counter_ to be the creation
@@ -799,6 +1022,7 @@ Queue<TaskType>::Queue(
   // the same traceme_context_id_counter_.
   traceme_context_id_counter_ = (absl::GetCurrentTimeNanos() & 0xFFFFFFFF)
                                 << 32;
+  priority_classes_.resize(options_.priority_classes.size());
   // Create an initial, open batch.
   if (options_.enable_lazy_split) {
     task_handle_batches_.emplace_back(
@@ -831,6 +1055,9 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
   if (options_.enable_lazy_split) {
     return ScheduleWithLazySplit(std::move(task));
   }
+  if (IsPriorityBatching()) {
+    return ScheduleWithPriority(task);
+  }
   return ScheduleWithoutOrEagerSplit(std::move(task));
 }
 
@@ -945,6 +1172,12 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplit(
       }
       if (batches_.back()->empty()) {
         open_batch_start_time_micros_ = env_->NowMicros();
+        open_batch_deadline_micros_ = kNoDeadlineMicros;
+      }
+      if (batch_latency_model_ != nullptr) {
+        open_batch_deadline_micros_ =
+            std::min(open_batch_deadline_micros_,
+                     TaskDeadlineMicros(*output_tasks[i]));
       }
       profiler::TraceMeProducer trace_me(
           [&output_tasks, i] {
@@ -971,10 +1204,122 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplit(
   return OkStatus();
 }
 
+template <typename TaskType>
+Status Queue<TaskType>::ScheduleWithPriority(std::unique_ptr<TaskType>* task) {
+  profiler::TraceMe trace_me([task] {
+    return profiler::TraceMeEncode(
+        "ScheduleWithPriority",
+        {{"batching_input_task_size", (*task)->size()}});
+  });
+  const int num_priority_classes = options_.priority_classes.size();
+  const int priority_class = options_.get_task_priority_class(**task);
+  if (priority_class < 0 || priority_class >= num_priority_classes) {
+    return errors::InvalidArgument("Task priority class ", priority_class,
+                                   " is not in [0, ", num_priority_classes,
+                                   ")");
+  }
+  const size_t task_size = (*task)->size();
+
+  std::vector<std::unique_ptr<TaskType>> evicted_tasks;
+  bool notify_of_schedulable_batch = false;
+  {
+    mutex_lock l(mu_);
+
+    DCHECK(!closed_);
+
+    PriorityClass& enqueue_class = priority_classes_[priority_class];
+    const size_t max_enqueued_class_size =
+        options_.priority_classes[priority_class].max_enqueued_size;
+    if (max_enqueued_class_size > 0 &&
+        enqueue_class.size + task_size > max_enqueued_class_size) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full for priority class ",
+          priority_class, "; task size is ", task_size, " but ",
+          enqueue_class.size, " of at most ", max_enqueued_class_size,
+          " are already enqueued");
+    }
+
+    // Lower-priority tasks may be evicted to make room for the task.
+    const size_t capacity =
+        options_.max_enqueued_batches * max_execution_batch_size();
+    size_t evictable_size = 0;
+    for (int i = priority_class + 1; i < num_priority_classes; ++i) {
+      evictable_size += priority_classes_[i].size;
+    }
+    if (prioritized_tasks_size_ + task_size > capacity + evictable_size) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full; task size is ",
+          task_size, " but ", prioritized_tasks_size_, " of at most ", capacity,
+          " are already enqueued, of which ", evictable_size,
+          " have a lower priority");
+    }
+
+    std::vector<std::unique_ptr<TaskType>> output_tasks;
+    if (task_size > max_execution_batch_size()) {
+      // Only possible with large batch splitting.
+      TF_RETURN_IF_ERROR(options_.split_input_task_func(
+          task, max_execution_batch_size(), max_execution_batch_size(),
+          &output_tasks));
+    } else {
+      output_tasks.push_back(std::move(*task));
+    }
+
+    // Evicts the most recently enqueued tasks of the lowest priority first.
+    for (int i = num_priority_classes - 1;
+         i > priority_class && prioritized_tasks_size_ + task_size > capacity;
+         --i) {
+      PriorityClass& evict_class = priority_classes_[i];
+      while (!evict_class.tasks.empty() &&
+             prioritized_tasks_size_ + task_size > capacity) {
+        std::unique_ptr<TaskType> evicted_task =
+            std::move(evict_class.tasks.back().task);
+        evict_class.tasks.pop_back();
+        evict_class.size -= evicted_task->size();
+        prioritized_tasks_size_ -= evicted_task->size();
+        evicted_tasks.push_back(std::move(evicted_task));
+      }
+    }
+
+    if (enqueue_class.tasks.empty()) {
+      // Classes do not accumulate credit while they have no enqueued tasks.
+      enqueue_class.virtual_time =
+          std::max(enqueue_class.virtual_time, virtual_time_);
+    }
+    const uint64 now_micros = env_->NowMicros();
+    for (auto& output_task : output_tasks) {
+      enqueue_class.size += output_task->size();
+      prioritized_tasks_size_ += output_task->size();
+      enqueue_class.tasks.push_back({std::move(output_task), now_micros});
+    }
+
+    if (!schedulable_batch_ && IsPrioritizedBatchSchedulable()) {
+      schedulable_batch_ = true;
+      notify_of_schedulable_batch = true;
+    }
+  }
+
+  for (auto& evicted_task : evicted_tasks) {
+    options_.evict_task_callback(
+        std::move(evicted_task),
+        errors::Unavailable("The task was evicted from the batch scheduling "
+                            "queue to make room for a higher-priority task"));
+  }
+  if (notify_of_schedulable_batch) {
+    schedulable_batch_callback_();
+  }
+
+  return OkStatus();
+}
+
 template <typename TaskType>
 size_t Queue<TaskType>::NumEnqueuedTasks() const {
   size_t num_enqueued_tasks = 0;
   mutex_lock l(mu_);
+  if (IsPriorityBatching()) {
+    return NumPrioritizedTasks();
+  }
   if (options_.enable_lazy_split) {
     for (const auto& batch : task_handle_batches_) {
       num_enqueued_tasks += batch->num_tasks();
@@ -996,6 +1341,10 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
 
 template <typename TaskType>
 size_t Queue<TaskType>::SchedulingCapacityInternal() const {
+  if (IsPriorityBatching()) {
+    return options_.max_enqueued_batches * max_execution_batch_size() -
+           prioritized_tasks_size_;
+  }
   const int64 num_new_batches_schedulable =
       static_cast<int64_t>(options_.max_enqueued_batches) -
       this->num_enqueued_batches();
@@ -1059,6 +1408,16 @@ Queue<TaskType>::ScheduleBatchWithEagerSplit() {
   {
     mutex_lock l(mu_);
 
+    if (IsPriorityBatching()) {
+      if (IsPrioritizedBatchSchedulable()) {
+        ++num_batches_being_processed_;
+        batch_to_schedule = FormPrioritizedBatch();
+      } else {
+        schedulable_batch_ = false;
+      }
+      return batch_to_schedule;
+    }
+
     // Consider closing the open batch at this time, to schedule it.
     if (batches_.size() == 1 && IsOpenBatchSchedulable()) {
       StartNewBatch();
@@ -1119,7 +1478,13 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros = env_->NowMicros();
   process_batch_callback_(std::move(batch));
+  if (batch_latency_model_ != nullptr) {
+    batch_latency_model_->Record(batch_size,
+                                 env_->NowMicros() - start_time_micros);
+  }
 
   {
     mutex_lock l(mu_);
@@ -1130,6 +1495,31 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
   }
 }
 
+template <typename TaskType>
+bool Queue<TaskType>::GetSchedulableBatchSlack(int64_t* slack_micros) const {
+  if (batch_latency_model_ == nullptr) return false;
+  mutex_lock l(mu_);
+  const Batch<TaskType>* batch;
+  int64_t deadline_micros;
+  if (batches_.size() >= 2) {
+    batch = batches_.front().get();
+    deadline_micros = kNoDeadlineMicros;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      deadline_micros =
+          std::min(deadline_micros, TaskDeadlineMicros(batch->task(i)));
+    }
+  } else if (IsOpenBatchSchedulable()) {
+    batch = batches_.back().get();
+    deadline_micros = open_batch_deadline_micros_;
+  } else {
+    return false;
+  }
+  if (deadline_micros == kNoDeadlineMicros) return false;
+  *slack_micros = deadline_micros - static_cast<int64_t>(env_->NowMicros()) -
+                  batch_latency_model_->PredictMicros(batch->size());
+  return true;
+}
+
 template <typename TaskType>
 bool Queue<TaskType>::IsEmpty() const {
   mutex_lock l(mu_);
@@ -1160,7 +1550,7 @@ bool Queue<TaskType>::IsEmptyInternal() const {
            task_handle_batches_.back()->empty();
   }
   return num_batches_being_processed_ == 0 && batches_.size() == 1 &&
-         batches_.back()->empty();
+         batches_.back()->empty() && NumPrioritizedTasks() == 0;
 }
 
 template <typename TaskType>
@@ -1194,7 +1584,8 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + options_.batch_timeout_micros ||
+         IsOpenBatchDue();
 }
 
 template <typename TaskType>
@@ -1212,6 +1603,90 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
              open_batch_start_time_micros_ + options_.batch_timeout_micros;
 }
 
+template <typename TaskType>
+size_t Queue<TaskType>::NumPrioritizedTasks() const {
+  size_t num_tasks = 0;
+  for (const PriorityClass& priority_class : priority_classes_) {
+    num_tasks += priority_class.tasks.size();
+  }
+  return num_tasks;
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsPrioritizedBatchSchedulable() const {
+  if (NumPrioritizedTasks() == 0) {
+    return false;
+  }
+  if (closed_ || prioritized_tasks_size_ >= max_execution_batch_size()) {
+    return true;
+  }
+  const uint64 now_micros = env_->NowMicros();
+  for (int i = 0; i < priority_classes_.size(); ++i) {
+    const PriorityClass& priority_class = priority_classes_[i];
+    if (!priority_class.tasks.empty() &&
+        now_micros >= priority_class.tasks.front().enqueue_time_micros +
+                          options_.priority_classes[i].batch_timeout_micros) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::FormPrioritizedBatch() {
+  auto batch =
+      std::make_unique<Batch<TaskType>>(++traceme_context_id_counter_);
+  // Classes whose next task does not fit in the batch any more.
+  std::vector<bool> class_is_full(priority_classes_.size(), false);
+  while (batch->size() < max_execution_batch_size()) {
+    // Serves the class with the lowest virtual time, or the one with the
+    // highest priority among those tied.
+    int next_class = -1;
+    for (int i = 0; i < priority_classes_.size(); ++i) {
+      if (priority_classes_[i].tasks.empty() || class_is_full[i]) continue;
+      if (next_class == -1 || priority_classes_[i].virtual_time <
+                                  priority_classes_[next_class].virtual_time) {
+        next_class = i;
+      }
+    }
+    if (next_class == -1) break;
+
+    PriorityClass& priority_class = priority_classes_[next_class];
+    const size_t task_size = priority_class.tasks.front().task->size();
+    if (batch->size() + task_size > max_execution_batch_size()) {
+      class_is_full[next_class] = true;
+      continue;
+    }
+    virtual_time_ = priority_class.virtual_time;
+    priority_class.virtual_time +=
+        static_cast<double>(task_size) /
+        options_.priority_classes[next_class].weight;
+    priority_class.size -= task_size;
+    prioritized_tasks_size_ -= task_size;
+    batch->AddTask(std::move(priority_class.tasks.front().task));
+    priority_class.tasks.pop_front();
+  }
+  batch->Close();
+  return batch;
+}
+
+template <typename TaskType>
+int64_t Queue<TaskType>::TaskDeadlineMicros(const TaskType& task) const {
+  const int64_t deadline_micros = options_.get_task_deadline_micros(task);
+  return deadline_micros > 0 ? deadline_micros : kNoDeadlineMicros;
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchDue() const {
+  if (batch_latency_model_ == nullptr ||
+      open_batch_deadline_micros_ == kNoDeadlineMicros) {
+    return false;
+  }
+  return static_cast<int64_t>(env_->NowMicros()) +
+             batch_latency_model_->PredictMicros(batches_.back()->size()) >=
+         open_batch_deadline_micros_;
+}
+
 template <typename TaskType>
 size_t Queue<TaskType>::tail_batch_task_size() const {
   if (options_.enable_lazy_split) {
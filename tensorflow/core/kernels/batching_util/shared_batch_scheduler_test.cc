@@ -20,16 +20,20 @@ limitations under the License.
 #include <thread>  // NOLINT(build/c++11)
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/base/call_once.h"
 #include "absl/container/fixed_array.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
@@ -804,6 +808,343 @@ INSTANTIATE_TEST_SUITE_P(
                       std::make_tuple(/*enable_input_batch_split=*/false,
                                       /*enable_lazy_split=*/false)));
 
+class DeadlineTask : public BatchTask {
+ public:
+  DeadlineTask(size_t size, int64_t deadline_micros)
+      : size_(size), deadline_micros_(deadline_micros) {}
+
+  ~DeadlineTask() override = default;
+
+  size_t size() const override { return size_; }
+
+  int64_t deadline_micros() const { return deadline_micros_; }
+
+ private:
+  const size_t size_;
+  const int64_t deadline_micros_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeadlineTask);
+};
+
+using DeadlineScheduler = SharedBatchScheduler<DeadlineTask>;
+
+Status ScheduleDeadlineTask(size_t task_size, int64_t deadline_micros,
+                            BatchScheduler<DeadlineTask>* scheduler) {
+  std::unique_ptr<DeadlineTask> task(
+      new DeadlineTask(task_size, deadline_micros));
+  return scheduler->Schedule(&task);
+}
+
+std::shared_ptr<DeadlineScheduler> CreateDeadlineScheduler(
+    int num_batch_threads, Env* env, bool enable_deadline_aware_scheduling) {
+  DeadlineScheduler::Options options;
+  options.num_batch_threads = num_batch_threads;
+  options.env = env;
+  options.enable_deadline_aware_scheduling = enable_deadline_aware_scheduling;
+
+  std::shared_ptr<DeadlineScheduler> scheduler;
+  TF_CHECK_OK(DeadlineScheduler::Create(options, &scheduler));
+  return scheduler;
+}
+
+DeadlineScheduler::QueueOptions CreateDeadlineQueueOptions(
+    size_t max_batch_size, int64_t batch_timeout_micros,
+    std::shared_ptr<BatchLatencyModel> batch_latency_model = nullptr) {
+  DeadlineScheduler::QueueOptions options;
+  options.input_batch_size_limit = max_batch_size;
+  options.max_execution_batch_size = max_batch_size;
+  options.batch_timeout_micros = batch_timeout_micros;
+  options.max_enqueued_batches = 100;
+  options.get_task_deadline_micros = [](const DeadlineTask& task) {
+    return task.deadline_micros();
+  };
+  options.batch_latency_model = std::move(batch_latency_model);
+  return options;
+}
+
+TEST(SharedBatchSchedulerDeadlineTest, ClosesBatchWhenDeadlineIsDue) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification batch_processed;
+    auto callback =
+        [&batch_processed](std::unique_ptr<Batch<DeadlineTask>> batch) {
+          ASSERT_TRUE(batch->IsClosed());
+          EXPECT_EQ(batch->size(), 2);
+          batch_processed.Notify();
+        };
+    auto batch_latency_model = std::make_shared<BatchLatencyModel>();
+    batch_latency_model->Record(2, 100);
+
+    auto scheduler = CreateDeadlineScheduler(1, &env, false);
+    std::unique_ptr<BatchScheduler<DeadlineTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(
+        CreateDeadlineQueueOptions(10, 10 * 1000, batch_latency_model),
+        callback, &queue));
+
+    // The batch times out at 10ms, but takes 100us to process and contains a
+    // task due at 1ms.
+    TF_ASSERT_OK(ScheduleDeadlineTask(1, 2000, queue.get()));
+    TF_ASSERT_OK(ScheduleDeadlineTask(1, 1000, queue.get()));
+    env.AdvanceByMicroseconds(899);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(1);
+    batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerDeadlineTest, ServesMostUrgentBatchFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification first_batch_scheduled, first_batch_proceed;
+    mutex mu;
+    std::vector<int> processed_queues;
+    auto create_callback = [&](int queue_index) {
+      return [&, queue_index](std::unique_ptr<Batch<DeadlineTask>> batch) {
+        if (!first_batch_scheduled.HasBeenNotified()) {
+          first_batch_scheduled.Notify();
+          first_batch_proceed.WaitForNotification();
+          return;
+        }
+        mutex_lock l(mu);
+        processed_queues.push_back(queue_index);
+      };
+    };
+
+    auto scheduler = CreateDeadlineScheduler(1, &env, true);
+    std::vector<std::unique_ptr<BatchScheduler<DeadlineTask>>> queues(2);
+    for (int i = 0; i < 2; ++i) {
+      TF_ASSERT_OK(scheduler->AddQueue(
+          CreateDeadlineQueueOptions(1, 10 * 1000), create_callback(i),
+          &queues[i]));
+    }
+
+    // Occupy the only batch thread with a batch of queue 0.
+    TF_ASSERT_OK(ScheduleDeadlineTask(1, 100 * 1000, queues[0].get()));
+    first_batch_scheduled.WaitForNotification();
+
+    // Round-robin would serve queue 1 next, but queue 0 has the batch with the
+    // earliest deadline.
+    TF_ASSERT_OK(ScheduleDeadlineTask(1, 50 * 1000, queues[1].get()));
+    TF_ASSERT_OK(ScheduleDeadlineTask(1, 5 * 1000, queues[0].get()));
+    first_batch_proceed.Notify();
+    queues[0].reset();
+    queues[1].reset();
+    EXPECT_EQ(processed_queues, std::vector<int>({0, 1}));
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST(SharedBatchSchedulerDeadlineTest, InvalidLazySplitOptions) {
+  auto scheduler = CreateDeadlineScheduler(1, Env::Default(), true);
+  DeadlineScheduler::QueueOptions options =
+      CreateDeadlineQueueOptions(10, 1000);
+  options.enable_large_batch_splitting = true;
+  options.enable_lazy_split = true;
+  options.split_input_task_func =
+      [](std::unique_ptr<DeadlineTask>* input_task, int first_output_task_size,
+         int max_batch_size,
+         std::vector<std::unique_ptr<DeadlineTask>>* output_tasks) {
+        output_tasks->push_back(std::move(*input_task));
+        return OkStatus();
+      };
+  std::unique_ptr<BatchScheduler<DeadlineTask>> queue;
+  EXPECT_THAT(
+      scheduler->AddQueue(
+          options, [](std::unique_ptr<Batch<DeadlineTask>> batch) {}, &queue),
+      testing::StatusIs(error::INVALID_ARGUMENT,
+                        HasSubstr("get_task_deadline_micros")));
+}
+
+class PriorityTask : public BatchTask {
+ public:
+  PriorityTask(size_t size, int priority_class)
+      : size_(size), priority_class_(priority_class) {}
+
+  ~PriorityTask() override = default;
+
+  size_t size() const override { return size_; }
+
+  int priority_class() const { return priority_class_; }
+
+ private:
+  const size_t size_;
+  const int priority_class_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PriorityTask);
+};
+
+using PriorityScheduler = SharedBatchScheduler<PriorityTask>;
+
+Status SchedulePriorityTask(size_t task_size, int priority_class,
+                            BatchScheduler<PriorityTask>* scheduler) {
+  std::unique_ptr<PriorityTask> task(
+      new PriorityTask(task_size, priority_class));
+  return scheduler->Schedule(&task);
+}
+
+// Returns options of a queue with a high priority class (0) of weight
+// `high_priority_weight` and a low priority class (1) of weight 1.
+PriorityScheduler::QueueOptions CreatePriorityQueueOptions(
+    size_t max_batch_size, size_t max_enqueued_batches,
+    int high_priority_weight,
+    std::function<void(std::unique_ptr<PriorityTask>, const Status&)>
+        evict_task_callback) {
+  PriorityScheduler::QueueOptions options;
+  options.input_batch_size_limit = max_batch_size;
+  options.max_execution_batch_size = max_batch_size;
+  options.max_enqueued_batches = max_enqueued_batches;
+  options.get_task_priority_class = [](const PriorityTask& task) {
+    return task.priority_class();
+  };
+  options.priority_classes.resize(2);
+  options.priority_classes[0].weight = high_priority_weight;
+  options.priority_classes[0].batch_timeout_micros = 1000 * 1000 * 1000;
+  options.priority_classes[1].batch_timeout_micros = 1000 * 1000 * 1000;
+  options.evict_task_callback = std::move(evict_task_callback);
+  return options;
+}
+
+// A scheduler with a single batch thread, which is kept busy by a batch of
+// another queue until `Release()` is called.
+class BlockedPriorityScheduler {
+ public:
+  BlockedPriorityScheduler() {
+    PriorityScheduler::Options options;
+    options.num_batch_threads = 1;
+    TF_CHECK_OK(PriorityScheduler::Create(options, &scheduler_));
+    PriorityScheduler::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 1;
+    TF_CHECK_OK(scheduler_->AddQueue(
+        queue_options,
+        [this](std::unique_ptr<Batch<PriorityTask>> batch) {
+          blocked_.Notify();
+          release_.WaitForNotification();
+        },
+        &blocking_queue_));
+    TF_CHECK_OK(SchedulePriorityTask(1, 0, blocking_queue_.get()));
+    blocked_.WaitForNotification();
+  }
+
+  ~BlockedPriorityScheduler() { Release(); }
+
+  PriorityScheduler* scheduler() { return scheduler_.get(); }
+
+  void Release() {
+    if (!release_.HasBeenNotified()) release_.Notify();
+  }
+
+ private:
+  std::shared_ptr<PriorityScheduler> scheduler_;
+  Notification blocked_, release_;
+  std::unique_ptr<BatchScheduler<PriorityTask>> blocking_queue_;
+};
+
+TEST(SharedBatchSchedulerPriorityTest, SharesBatchSlotsByWeight) {
+  BlockedPriorityScheduler blocked_scheduler;
+  mutex mu;
+  // The number of tasks of each priority class in each processed batch.
+  std::vector<std::vector<int>> batch_compositions;
+  std::unique_ptr<BatchScheduler<PriorityTask>> queue;
+  TF_ASSERT_OK(blocked_scheduler.scheduler()->AddQueue(
+      CreatePriorityQueueOptions(
+          /*max_batch_size=*/4, /*max_enqueued_batches=*/10,
+          /*high_priority_weight=*/3,
+          [](std::unique_ptr<PriorityTask> task, const Status& status) {}),
+      [&](std::unique_ptr<Batch<PriorityTask>> batch) {
+        std::vector<int> composition(2, 0);
+        for (int i = 0; i < batch->num_tasks(); ++i) {
+          ++composition[batch->task(i).priority_class()];
+        }
+        mutex_lock l(mu);
+        batch_compositions.push_back(composition);
+      },
+      &queue));
+
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(SchedulePriorityTask(1, 1, queue.get()));
+  }
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(SchedulePriorityTask(1, 0, queue.get()));
+  }
+  EXPECT_EQ(queue->NumEnqueuedTasks(), 8);
+  blocked_scheduler.Release();
+  queue.reset();
+
+  // The high priority class gets three of the four slots of the first batch,
+  // and the low priority class fills the slots it leaves in the second one.
+  EXPECT_EQ(batch_compositions,
+            std::vector<std::vector<int>>({{3, 1}, {1, 3}}));
+}
+
+TEST(SharedBatchSchedulerPriorityTest, EvictsLowerPriorityTasks) {
+  BlockedPriorityScheduler blocked_scheduler;
+  std::vector<Status> evicted_task_statuses;
+  std::unique_ptr<BatchScheduler<PriorityTask>> queue;
+  TF_ASSERT_OK(blocked_scheduler.scheduler()->AddQueue(
+      CreatePriorityQueueOptions(
+          /*max_batch_size=*/4, /*max_enqueued_batches=*/1,
+          /*high_priority_weight=*/1,
+          [&](std::unique_ptr<PriorityTask> task, const Status& status) {
+            EXPECT_EQ(task->priority_class(), 1);
+            evicted_task_statuses.push_back(status);
+          }),
+      [](std::unique_ptr<Batch<PriorityTask>> batch) {}, &queue));
+
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(SchedulePriorityTask(1, 1, queue.get()));
+  }
+  // Makes room by evicting one low priority task.
+  TF_ASSERT_OK(SchedulePriorityTask(2, 0, queue.get()));
+  ASSERT_EQ(evicted_task_statuses.size(), 1);
+  EXPECT_TRUE(errors::IsUnavailable(evicted_task_statuses[0]));
+  EXPECT_EQ(queue->NumEnqueuedTasks(), 3);
+  EXPECT_EQ(queue->SchedulingCapacity(), 0);
+
+  // Neither evicting all low priority tasks nor tasks of the same priority
+  // makes room.
+  EXPECT_TRUE(errors::IsUnavailable(SchedulePriorityTask(3, 0, queue.get())));
+  EXPECT_TRUE(errors::IsUnavailable(SchedulePriorityTask(1, 1, queue.get())));
+  EXPECT_EQ(evicted_task_statuses.size(), 1);
+
+  blocked_scheduler.Release();
+}
+
+TEST(SharedBatchSchedulerPriorityTest, InvalidOptions) {
+  BlockedPriorityScheduler blocked_scheduler;
+  PriorityScheduler::QueueOptions options = CreatePriorityQueueOptions(
+      /*max_batch_size=*/4, /*max_enqueued_batches=*/1,
+      /*high_priority_weight=*/1, nullptr);
+  std::unique_ptr<BatchScheduler<PriorityTask>> queue;
+  EXPECT_THAT(blocked_scheduler.scheduler()->AddQueue(
+                  options, [](std::unique_ptr<Batch<PriorityTask>> batch) {},
+                  &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT,
+                                HasSubstr("evict_task_callback")));
+
+  options.evict_task_callback = [](std::unique_ptr<PriorityTask> task,
+                                   const Status& status) {};
+  options.priority_classes[1].weight = 0;
+  EXPECT_THAT(blocked_scheduler.scheduler()->AddQueue(
+                  options, [](std::unique_ptr<Batch<PriorityTask>> batch) {},
+                  &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT,
+                                HasSubstr("weights must be positive")));
+}
+
 #ifdef PLATFORM_GOOGLE
 // This benchmark relies on https://github.com/google/benchmark features,
 // (in particular, `Benchmark::ThreadRange`) not available in open-sourced TF
@@ -914,6 +1255,102 @@ BENCHMARK(BM_QueueSchedule)->Apply([](benchmark::internal::Benchmark* b) {
 
 #endif  // PLATFORM_GOOGLE
 
+// Simulates serving two queues with different latency SLOs on one batch
+// thread, at a constant arrival rate, on a fake clock. Batches of size b take
+// 400us + 40us * b to process.
+//
+// Reports the goodput (tasks per second finishing before their deadline) and
+// the fraction of tasks meeting their deadline with
+//  - policy 0: batch timeouts and round-robin scheduling,
+//  - policy 1: deadline-aware batch formation and round-robin scheduling,
+//  - policy 2: deadline-aware batch formation and scheduling.
+constexpr int64_t kSimulationDurationMicros = 200 * 1000;
+constexpr int kSimulationTickMicros = 50;
+// Real time given to the batch threads to pick up batches after each tick.
+constexpr int64_t kSimulationRealMicrosPerTick = 1000;
+
+struct DeadlineSimulationResult {
+  int64_t num_tasks = 0;
+  int64_t num_tasks_meeting_deadline = 0;
+};
+
+DeadlineSimulationResult RunDeadlineSimulation(int policy,
+                                               int task_interval_micros) {
+  const int64_t kSloMicros[] = {2000, 10 * 1000};
+  const size_t kMaxBatchSize = 32;
+  const int64_t kBatchTimeoutMicros = 500;
+
+  test_util::FakeClockEnv env(Env::Default());
+  mutex mu;
+  DeadlineSimulationResult result;
+  auto callback = [&env, &mu,
+                   &result](std::unique_ptr<Batch<DeadlineTask>> batch) {
+    env.SleepForMicroseconds(400 + 40 * batch->size());
+    const int64_t now_micros = env.NowMicros();
+    mutex_lock l(mu);
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      if (now_micros <= batch->task(i).deadline_micros()) {
+        ++result.num_tasks_meeting_deadline;
+      }
+    }
+  };
+
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+  {
+    auto scheduler = CreateDeadlineScheduler(1, &env, policy == 2);
+    std::vector<std::unique_ptr<BatchScheduler<DeadlineTask>>> queues(2);
+    for (int i = 0; i < 2; ++i) {
+      DeadlineScheduler::QueueOptions options;
+      if (policy == 0) {
+        options =
+            CreateDeadlineQueueOptions(kMaxBatchSize, kBatchTimeoutMicros);
+        options.get_task_deadline_micros = nullptr;
+      } else {
+        options = CreateDeadlineQueueOptions(kMaxBatchSize, kSloMicros[i]);
+      }
+      TF_CHECK_OK(scheduler->AddQueue(options, callback, &queues[i]));
+    }
+
+    for (int64_t now_micros = 0; now_micros < kSimulationDurationMicros;
+         now_micros += kSimulationTickMicros) {
+      for (int i = 0; i < 2; ++i) {
+        if (now_micros % task_interval_micros != 0) continue;
+        ++result.num_tasks;
+        // Rejected tasks miss their deadline.
+        ScheduleDeadlineTask(1, now_micros + kSloMicros[i], queues[i].get())
+            .IgnoreError();
+      }
+      env.AdvanceByMicroseconds(kSimulationTickMicros);
+      Env::Default()->SleepForMicroseconds(kSimulationRealMicrosPerTick);
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+  return result;
+}
+
+void BM_DeadlineAwareBatching(::testing::benchmark::State& state) {
+  const int policy = state.range(0);
+  const int task_interval_micros = state.range(1);
+  DeadlineSimulationResult result;
+  for (auto s : state) {
+    result = RunDeadlineSimulation(policy, task_interval_micros);
+  }
+  state.SetLabel(strings::StrCat(
+      "goodput=",
+      result.num_tasks_meeting_deadline * 1e6 / kSimulationDurationMicros,
+      "/s met_deadline=",
+      100.0 * result.num_tasks_meeting_deadline / result.num_tasks, "%"));
+}
+BENCHMARK(BM_DeadlineAwareBatching)
+    ->UseRealTime()
+    ->Iterations(1)
+    ->ArgNames({"policy", "task_interval_micros"})
+    ->ArgsProduct({{0, 1, 2}, {100, 200, 400}});
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,125 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Builds the file of a MmappedHashTable from a vocabulary text file, parsed as
+// by InitializeTableFromTextFile. For example, to map the lines of a
+// vocabulary to their line numbers:
+//
+//   build_mmapped_lookup_table --vocabulary_file=vocab.txt \
+//       --output=vocab.mht --key_dtype=string --value_dtype=int64 \
+//       --key_index=-2 --value_index=-1
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/lookup_util.h"
+#include "tensorflow/core/kernels/mmapped_lookup_table.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+Status BuildMmappedLookupTable(const string& vocabulary_file,
+                               const string& output, DataType key_dtype,
+                               int32_t key_index, DataType value_dtype,
+                               int32_t value_index, const string& delimiter,
+                               int64_t vocab_size, int64_t offset) {
+  if (delimiter.size() != 1) {
+    return errors::InvalidArgument("Delimiter must be a single character, got ",
+                                   delimiter);
+  }
+  lookup::MmappedLookupTableBuilder builder(key_dtype, value_dtype);
+  TF_RETURN_IF_ERROR(lookup::ReadTextFileEntries(
+      vocabulary_file, vocab_size, delimiter[0], key_index, key_dtype,
+      value_index, value_dtype, offset, Env::Default(),
+      [&builder](const Tensor& key, const Tensor& value) {
+        return builder.Add(key, value);
+      }));
+  return builder.Write(Env::Default(), output);
+}
+
+int ParseFlagsAndBuildMmappedLookupTable(int argc, char* argv[]) {
+  string vocabulary_file;
+  string output;
+  string key_dtype_name = "string";
+  string value_dtype_name = "int64";
+  int32_t key_index = -2;
+  int32_t value_index = -1;
+  string delimiter = "\t";
+  int64_t vocab_size = -1;
+  int64_t offset = 0;
+  std::vector<Flag> flag_list = {
+      Flag("vocabulary_file", &vocabulary_file, "input vocabulary file name"),
+      Flag("output", &output, "output table file name"),
+      Flag("key_dtype", &key_dtype_name, "type of the keys: string or int64"),
+      Flag("value_dtype", &value_dtype_name,
+           "type of the values: string or int64"),
+      Flag("key_index", &key_index,
+           "column of the keys, or -2 for the whole line, or -1 for the line "
+           "number"),
+      Flag("value_index", &value_index,
+           "column of the values, or -2 for the whole line, or -1 for the line "
+           "number"),
+      Flag("delimiter", &delimiter, "delimiter of the columns"),
+      Flag("vocab_size", &vocab_size,
+           "number of lines to read, or -1 for all of them"),
+      Flag("offset", &offset, "offset added to line numbers"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (!parse_result) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << ".\n" << usage;
+    return -1;
+  }
+  if (vocabulary_file.empty() || output.empty()) {
+    LOG(ERROR) << "vocabulary_file and output can't be empty.\n" << usage;
+    return -1;
+  }
+  DataType key_dtype;
+  DataType value_dtype;
+  if (!DataTypeFromString(key_dtype_name, &key_dtype) ||
+      !DataTypeFromString(value_dtype_name, &value_dtype)) {
+    LOG(ERROR) << "Invalid key_dtype or value_dtype.\n" << usage;
+    return -1;
+  }
+
+  Status status = BuildMmappedLookupTable(vocabulary_file, output, key_dtype,
+                                          key_index, value_dtype, value_index,
+                                          delimiter, vocab_size, offset);
+  if (!status.ok()) {
+    LOG(ERROR) << "Building " << output << " failed: " << status;
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::ParseFlagsAndBuildMmappedLookupTable(argc, argv);
+}
@@ -13,10 +13,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/util/shard_cost_table.h"
 
 namespace tensorflow {
 
@@ -51,4 +58,57 @@ BM_Diag(16);
 BM_Diag(128);
 BM_Diag(512);
 
+// Runs Diag, whose Shard() cost of 5 per output element is a guess, under the
+// static cost model or after calibrating it on the same graph. The input is
+// fed so that the op is not constant folded.
+//
+// Arguments: calibrated (0 or 1), size of the diagonal.
+static void BM_DiagShardCostModel(::testing::benchmark::State& state) {
+  const bool calibrated = state.range(0) != 0;
+  const int n = state.range(1);
+
+  Graph g(OpRegistry::Global());
+  Node* input;
+  TF_CHECK_OK(NodeBuilder("input", "Placeholder")
+                  .Attr("dtype", DT_FLOAT)
+                  .Finalize(&g, &input));
+  Node* diag = test::graph::Diag(&g, input, DT_FLOAT);
+  GraphDef graph_def;
+  g.ToGraphDef(&graph_def);
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_CHECK_OK(session->Create(graph_def));
+
+  Tensor in(DT_FLOAT, TensorShape({n}));
+  in.flat<float>().setRandom();
+  const std::vector<std::pair<string, Tensor>> inputs = {{"input", in}};
+  std::vector<Tensor> outputs;
+  auto run = [&]() {
+    TF_CHECK_OK(session->Run(inputs, {diag->name()}, {}, &outputs));
+  };
+
+  const ShardCostModelMode previous_mode = GetShardCostModelMode();
+  ShardCostTable::Global()->Clear();
+  if (calibrated) {
+    SetShardCostModelMode(ShardCostModelMode::kCalibrate);
+    for (int i = 0; i < 100; ++i) run();
+    SetShardCostModelMode(ShardCostModelMode::kCalibrated);
+  } else {
+    SetShardCostModelMode(ShardCostModelMode::kStatic);
+  }
+
+  for (auto s : state) run();
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n * n);
+
+  SetShardCostModelMode(previous_mode);
+  ShardCostTable::Global()->Clear();
+}
+BENCHMARK(BM_DiagShardCostModel)
+    ->UseRealTime()
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 64)
+    ->ArgPair(0, 512)
+    ->ArgPair(1, 512)
+    ->ArgPair(0, 2048)
+    ->ArgPair(1, 2048);
+
 }  // end namespace tensorflow
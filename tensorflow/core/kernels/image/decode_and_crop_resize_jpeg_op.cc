@@ -0,0 +1,290 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// The two decoded pixels, as offsets into the decoded image, that an output
+// row or column interpolates between.
+struct CachedInterpolation {
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+// Returns the largest libjpeg scale_denom at which the crop window still
+// decodes to at least the output size, so the resize never upsamples what
+// the IDCT has already downscaled.
+int ChooseRatio(int crop_height, int crop_width, int out_height,
+                int out_width) {
+  for (int ratio : {8, 4, 2}) {
+    if (crop_height / ratio >= out_height && crop_width / ratio >= out_width) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+// Computes the interpolation of `out_size` outputs over a crop of `crop_size`
+// full resolution pixels, decoded at 1/`ratio` scale into `decoded_size`
+// pixels whose first one starts `offset` full resolution pixels before the
+// crop. Offsets are scaled by `stride`. With a ratio of 1 this matches
+// ResizeBilinear on the cropped image.
+void ComputeInterpolation(bool half_pixel_centers, int64_t out_size,
+                          int64_t crop_size, int ratio, int offset,
+                          int64_t decoded_size, int64_t stride,
+                          CachedInterpolation* interpolation) {
+  const float scale = static_cast<float>(crop_size) / out_size;
+  for (int64_t i = 0; i < out_size; ++i) {
+    const float in = half_pixel_centers
+                         ? (offset + (i + 0.5f) * scale) / ratio - 0.5f
+                         : (offset + i * scale) / ratio;
+    const float in_f = std::floor(in);
+    const int64_t lower = std::min(
+        std::max(static_cast<int64_t>(in_f), static_cast<int64_t>(0)),
+        decoded_size - 1);
+    const int64_t upper =
+        std::min(static_cast<int64_t>(std::ceil(in)), decoded_size - 1);
+    interpolation[i] = {lower * stride, upper * stride, in - in_f};
+  }
+}
+
+// Interpolates one decoded row horizontally.
+template <int kChannels>
+void InterpolateRow(const uint8* row,
+                    const std::vector<CachedInterpolation>& xs, float* out) {
+  for (const CachedInterpolation& x : xs) {
+    const uint8* left = row + x.lower;
+    const uint8* right = row + x.upper;
+    for (int c = 0; c < kChannels; ++c) {
+      const float top_left = left[c];
+      out[c] = top_left + (right[c] - top_left) * x.lerp;
+    }
+    out += kChannels;
+  }
+}
+
+// Resizes the decoded image into `output`. Each output row blends two
+// horizontally interpolated rows, which are kept across output rows sharing a
+// source row; the blend runs over contiguous floats and vectorizes.
+template <int kChannels>
+void ResizeImage(OpKernelContext* context, const uint8* decoded,
+                 const std::vector<CachedInterpolation>& xs,
+                 const std::vector<CachedInterpolation>& ys, float* output) {
+  const int64_t out_row_size = xs.size() * kChannels;
+  auto resize_rows = [&](int64_t start, int64_t limit) {
+    std::vector<float> top(out_row_size);
+    std::vector<float> bottom(out_row_size);
+    int64_t top_row = -1;
+    int64_t bottom_row = -1;
+    for (int64_t y = start; y < limit; ++y) {
+      if (ys[y].lower != top_row) {
+        if (ys[y].lower == bottom_row) {
+          std::swap(top, bottom);
+          std::swap(top_row, bottom_row);
+        } else {
+          InterpolateRow<kChannels>(decoded + ys[y].lower, xs, top.data());
+          top_row = ys[y].lower;
+        }
+      }
+      if (ys[y].upper != bottom_row) {
+        InterpolateRow<kChannels>(decoded + ys[y].upper, xs, bottom.data());
+        bottom_row = ys[y].upper;
+      }
+      const float y_lerp = ys[y].lerp;
+      float* out = output + y * out_row_size;
+      for (int64_t i = 0; i < out_row_size; ++i) {
+        out[i] = top[i] + (bottom[i] - top[i]) * y_lerp;
+      }
+    }
+  };
+  auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+  Shard(worker_threads.num_threads, worker_threads.workers, ys.size(),
+        out_row_size * 8, resize_rows);
+}
+
+}  // namespace
+
+// Decodes the crop window of a JPEG image and bilinearly resizes it. The crop
+// is decoded at the smallest DCT scale that keeps it at least as large as the
+// output, so most of the downscaling happens in the IDCT and only the crop's
+// MCUs are decoded.
+class DecodeAndCropResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndCropResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    int channels;
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels));
+    OP_REQUIRES(context, channels == 0 || channels == 1 || channels == 3,
+                errors::InvalidArgument("channels must be 0, 1, or 3, got ",
+                                        channels));
+    flags_.components = channels;
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context, context->GetAttr("acceptable_fraction",
+                                             &flags_.min_acceptable_fraction));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+    OP_REQUIRES_OK(context, context->GetAttr("half_pixel_centers",
+                                             &half_pixel_centers_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<tstring>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context,
+                crop_window.dims() == 1 && crop_window.dim_size(0) == 4,
+                errors::InvalidArgument("crop_window must be 1-D with four "
+                                        "elements, got shape ",
+                                        crop_window.shape().DebugString()));
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, size.dims() == 1 && size.dim_size(0) == 2,
+                errors::InvalidArgument("size must be 1-D with two elements, "
+                                        "got shape ",
+                                        size.shape().DebugString()));
+    auto crop_window_vec = crop_window.vec<int32>();
+    const int crop_y = crop_window_vec(0);
+    const int crop_x = crop_window_vec(1);
+    const int crop_height = crop_window_vec(2);
+    const int crop_width = crop_window_vec(3);
+    auto size_vec = size.vec<int32>();
+    const int out_height = size_vec(0);
+    const int out_width = size_vec(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        out_height, ", ", out_width, "]"));
+
+    int image_height, image_width;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                                   &image_height, nullptr),
+                errors::InvalidArgument("Invalid JPEG data, size ",
+                                        input.size()));
+    OP_REQUIRES(
+        context,
+        crop_height > 0 && crop_width > 0 && crop_y >= 0 && crop_x >= 0 &&
+            crop_y <= image_height - crop_height &&
+            crop_x <= image_width - crop_width,
+        errors::InvalidArgument("crop_window [", crop_y, ", ", crop_x, ", ",
+                                crop_height, ", ", crop_width,
+                                "] is out of bounds for a ", image_height, "x",
+                                image_width, " image"));
+
+    // Use local copy of flags to avoid race condition as the class member is
+    // shared among different invocations.
+    jpeg::UncompressFlags flags = flags_;
+    const int ratio =
+        ChooseRatio(crop_height, crop_width, out_height, out_width);
+    flags.ratio = ratio;
+    // libjpeg decodes ceil(size / ratio) pixels and crops in those scaled
+    // coordinates, so decode the scaled pixels covering the crop window.
+    const int scaled_height = (image_height + ratio - 1) / ratio;
+    const int scaled_width = (image_width + ratio - 1) / ratio;
+    flags.crop = true;
+    flags.crop_y = crop_y / ratio;
+    flags.crop_x = crop_x / ratio;
+    flags.crop_height =
+        std::min((crop_y + crop_height + ratio - 1) / ratio, scaled_height) -
+        flags.crop_y;
+    flags.crop_width =
+        std::min((crop_x + crop_width + ratio - 1) / ratio, scaled_width) -
+        flags.crop_x;
+
+    Tensor decoded;
+    uint8* buffer = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [&](int width, int height, int channels) -> uint8* {
+          Status status = context->allocate_temp(
+              DT_UINT8, TensorShape({height, width, channels}), &decoded);
+          if (!status.ok()) {
+            VLOG(1) << status;
+            context->SetStatus(status);
+            return nullptr;
+          }
+          return decoded.flat<uint8>().data();
+        });
+    OP_REQUIRES(
+        context, buffer,
+        errors::InvalidArgument(
+            "jpeg::Uncompress failed. Invalid JPEG data or crop window."));
+
+    const int64_t decoded_height = decoded.dim_size(0);
+    const int64_t decoded_width = decoded.dim_size(1);
+    const int64_t channels = decoded.dim_size(2);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, TensorShape({out_height, out_width, channels}), &output));
+
+    std::vector<CachedInterpolation> ys(out_height);
+    std::vector<CachedInterpolation> xs(out_width);
+    ComputeInterpolation(half_pixel_centers_, out_height, crop_height, ratio,
+                         crop_y - flags.crop_y * ratio, decoded_height,
+                         decoded_width * channels, ys.data());
+    ComputeInterpolation(half_pixel_centers_, out_width, crop_width, ratio,
+                         crop_x - flags.crop_x * ratio, decoded_width,
+                         channels, xs.data());
+    if (channels == 1) {
+      ResizeImage<1>(context, buffer, xs, ys, output->flat<float>().data());
+    } else {
+      ResizeImage<3>(context, buffer, xs, ys, output->flat<float>().data());
+    }
+  }
+
+ private:
+  jpeg::UncompressFlags flags_;
+  bool half_pixel_centers_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropResizeJpeg").Device(DEVICE_CPU),
+                        DecodeAndCropResizeJpegOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,132 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 480;
+
+// A smooth gradient, which survives both JPEG compression and DCT scaling.
+float Gradient(int channel, float x, float y) {
+  return 20 + 30 * channel + 0.15f * x + 0.1f * y;
+}
+
+class DecodeAndCropResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void SetUp() override {
+    std::vector<uint8> image(kHeight * kWidth * 3);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          image[(y * kWidth + x) * 3 + c] = std::lround(Gradient(c, x, y));
+        }
+      }
+    }
+    jpeg::CompressFlags flags;
+    flags.format = jpeg::FORMAT_RGB;
+    flags.quality = 100;
+    ASSERT_TRUE(jpeg::Compress(image.data(), kWidth, kHeight, flags, &jpeg_));
+  }
+
+  Status Run(const std::vector<int32>& crop_window,
+             const std::vector<int32>& size) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("op", "DecodeAndCropResizeJpeg")
+                           .Input(FakeInput(DT_STRING))
+                           .Input(FakeInput(DT_INT32))
+                           .Input(FakeInput(DT_INT32))
+                           .Attr("dct_method", "INTEGER_ACCURATE")
+                           .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    AddInputFromArray<tstring>(TensorShape({}), {jpeg_});
+    AddInputFromArray<int32>(TensorShape({4}), crop_window);
+    AddInputFromArray<int32>(TensorShape({2}), size);
+    return RunOpKernel();
+  }
+
+  // Checks that resizing the crop window matches the gradient at the centers
+  // of the output pixels.
+  void CheckDownscale(const std::vector<int32>& crop_window,
+                      const std::vector<int32>& size) {
+    TF_ASSERT_OK(Run(crop_window, size));
+    const Tensor& output = *GetOutput(0);
+    ASSERT_EQ(output.shape(), TensorShape({size[0], size[1], 3}));
+    auto image = output.tensor<float, 3>();
+    const float y_scale = static_cast<float>(crop_window[2]) / size[0];
+    const float x_scale = static_cast<float>(crop_window[3]) / size[1];
+    for (int y = 0; y < size[0]; ++y) {
+      for (int x = 0; x < size[1]; ++x) {
+        for (int c = 0; c < 3; ++c) {
+          EXPECT_NEAR(image(y, x, c),
+                      Gradient(c, crop_window[1] + (x + 0.5f) * x_scale - 0.5f,
+                               crop_window[0] + (y + 0.5f) * y_scale - 0.5f),
+                      3);
+        }
+      }
+    }
+  }
+
+  tstring jpeg_;
+};
+
+TEST_F(DecodeAndCropResizeJpegOpTest, SameSizeMatchesDecodeAndCrop) {
+  TF_ASSERT_OK(Run({8, 16, 200, 100}, {200, 100}));
+
+  jpeg::UncompressFlags flags;
+  flags.dct_method = JDCT_ISLOW;
+  flags.crop = true;
+  flags.crop_y = 8;
+  flags.crop_x = 16;
+  flags.crop_height = 200;
+  flags.crop_width = 100;
+  Tensor expected(DT_FLOAT, TensorShape({200, 100, 3}));
+  std::vector<uint8> cropped(expected.NumElements());
+  ASSERT_NE(jpeg::Uncompress(jpeg_.data(), jpeg_.size(), flags, nullptr,
+                             [&cropped](int, int, int) {
+                               return cropped.data();
+                             }),
+            nullptr);
+  std::copy(cropped.begin(), cropped.end(), expected.flat<float>().data());
+  test::ExpectTensorEqual<float>(*GetOutput(0), expected);
+}
+
+TEST_F(DecodeAndCropResizeJpegOpTest, DownscaleByEight) {
+  CheckDownscale({13, 27, 401, 333}, {50, 41});
+}
+
+TEST_F(DecodeAndCropResizeJpegOpTest, DownscaleByTwo) {
+  CheckDownscale({3, 5, 470, 620}, {224, 224});
+}
+
+TEST_F(DecodeAndCropResizeJpegOpTest, InvalidCropWindow) {
+  EXPECT_TRUE(errors::IsInvalidArgument(Run({400, 0, 100, 100}, {10, 10})));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,16 +15,25 @@ limitations under the License.
 
 // Tests kernels of lookup ops.
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -100,5 +109,207 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+class MutableDenseHashTableTest : public OpsTestBase {
+ protected:
+  // Creates a table of int64 keys and values, with the kernel selected by
+  // `kernel_label`.
+  void MakeTable(const string& kernel_label, int64_t num_shards,
+                 int64_t initial_num_buckets) {
+    inputs_.clear();
+    NodeDefBuilder builder("table", "AnonymousMutableDenseHashTable");
+    builder.Input(FakeInput(DT_INT64))
+        .Input(FakeInput(DT_INT64))
+        .Attr("key_dtype", DT_INT64)
+        .Attr("value_dtype", DT_INT64)
+        .Attr("initial_num_buckets", initial_num_buckets)
+        .Attr("_num_shards", num_shards);
+    if (!kernel_label.empty()) builder.Attr("_kernel", kernel_label);
+    TF_ASSERT_OK(builder.Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<int64_t>(TensorShape({}), {-1});
+    AddInputFromArray<int64_t>(TensorShape({}), {-2});
+    TF_ASSERT_OK(RunOpKernel());
+    handle_ = GetOutput(0)->scalar<ResourceHandle>()();
+    TF_ASSERT_OK_AND_ASSIGN(table_,
+                            handle_.GetResource<lookup::LookupInterface>());
+  }
+
+  // Inserts `keys` with values 10 times the keys.
+  void Insert(const std::vector<int64_t>& keys) {
+    std::vector<int64_t> values;
+    for (int64_t key : keys) values.push_back(key * 10);
+    TF_ASSERT_OK(table_->Insert(context_.get(), test::AsTensor<int64_t>(keys),
+                                test::AsTensor<int64_t>(values)));
+  }
+
+  // Returns the values of `keys`, or 0 for missing keys.
+  std::vector<int64_t> Find(const std::vector<int64_t>& keys) {
+    Tensor values(DT_INT64, TensorShape({static_cast<int64_t>(keys.size())}));
+    TF_CHECK_OK(table_->Find(context_.get(), test::AsTensor<int64_t>(keys),
+                             &values, test::AsScalar<int64_t>(0)));
+    const auto values_flat = values.flat<int64_t>();
+    return std::vector<int64_t>(values_flat.data(),
+                                values_flat.data() + values_flat.size());
+  }
+
+  // Exports the table with the LookupTableExportV2 kernel.
+  void Export(Tensor* keys, Tensor* values) {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("export", "LookupTableExportV2")
+                     .Input(FakeInput(DT_RESOURCE))
+                     .Attr("Tkeys", DT_INT64)
+                     .Attr("Tvalues", DT_INT64)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<ResourceHandle>(TensorShape({}), {handle_});
+    TF_ASSERT_OK(RunOpKernel());
+    *keys = *GetOutput(0);
+    *values = *GetOutput(1);
+  }
+
+  ResourceHandle handle_;
+  lookup::LookupInterface* table_ = nullptr;
+};
+
+TEST_F(MutableDenseHashTableTest, Sharded) {
+  MakeTable("sharded", /*num_shards=*/4, /*initial_num_buckets=*/16);
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 1000; ++key) keys.push_back(key);
+  Insert(keys);
+  EXPECT_EQ(table_->size(), 1000);
+  std::vector<int64_t> values = Find(keys);
+  for (int64_t key : keys) EXPECT_EQ(values[key], key * 10);
+
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key < 1000; key += 2) odd_keys.push_back(key);
+  TF_ASSERT_OK(
+      table_->Remove(context_.get(), test::AsTensor<int64_t>(odd_keys)));
+  EXPECT_EQ(table_->size(), 500);
+  values = Find(keys);
+  for (int64_t key : keys) EXPECT_EQ(values[key], key % 2 ? 0 : key * 10);
+
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      table_->Insert(context_.get(), test::AsTensor<int64_t>({-1}),
+                     test::AsTensor<int64_t>({0}))));
+}
+
+TEST_F(MutableDenseHashTableTest, ShardedExportsDefaultLayout) {
+  MakeTable("sharded", /*num_shards=*/4, /*initial_num_buckets=*/16);
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 1000; ++key) keys.push_back(key);
+  Insert(keys);
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key < 1000; key += 2) odd_keys.push_back(key);
+  TF_ASSERT_OK(
+      table_->Remove(context_.get(), test::AsTensor<int64_t>(odd_keys)));
+  Tensor exported_keys;
+  Tensor exported_values;
+  Export(&exported_keys, &exported_values);
+  const int64_t num_buckets = exported_keys.dim_size(0);
+  EXPECT_EQ(num_buckets & (num_buckets - 1), 0);
+  EXPECT_LE(500, num_buckets * 0.8);
+
+  // The default kernel finds the keys in the exported buckets, which it
+  // imports as they are.
+  MakeTable("", /*num_shards=*/1, /*initial_num_buckets=*/16);
+  TF_ASSERT_OK(table_->CheckKeyAndValueTensorsForImport(exported_keys,
+                                                        exported_values));
+  TF_ASSERT_OK(
+      table_->ImportValues(context_.get(), exported_keys, exported_values));
+  EXPECT_EQ(table_->size(), 500);
+  const std::vector<int64_t> values = Find(keys);
+  for (int64_t key : keys) EXPECT_EQ(values[key], key % 2 ? 0 : key * 10);
+
+  // And so does the sharded kernel, with another number of shards.
+  MakeTable("sharded", /*num_shards=*/2, /*initial_num_buckets=*/16);
+  TF_ASSERT_OK(
+      table_->ImportValues(context_.get(), exported_keys, exported_values));
+  EXPECT_EQ(table_->size(), 500);
+  EXPECT_EQ(Find(keys), values);
+}
+
+TEST_F(MutableDenseHashTableTest, ShardedConcurrentFind) {
+  MakeTable("sharded", /*num_shards=*/4, /*initial_num_buckets=*/16);
+  constexpr int64_t kNumKeys = 10000;
+  constexpr int kNumReaders = 4;
+  std::atomic<bool> done(false);
+  {
+    thread::ThreadPool pool(Env::Default(), "readers", kNumReaders);
+    for (int i = 0; i < kNumReaders; ++i) {
+      pool.Schedule([this, i, &done] {
+        int64_t key = i;
+        while (!done) {
+          // Keys are either missing or have their value, even while the
+          // shards grow.
+          const int64_t value = Find({key})[0];
+          EXPECT_TRUE(value == 0 || value == key * 10) << key << " " << value;
+          key = (key + 7) % kNumKeys;
+        }
+      });
+    }
+    for (int64_t begin = 0; begin < kNumKeys; begin += 100) {
+      std::vector<int64_t> keys;
+      for (int64_t key = begin; key < begin + 100; ++key) keys.push_back(key);
+      Insert(keys);
+    }
+    done = true;
+  }
+  EXPECT_EQ(table_->size(), kNumKeys);
+  EXPECT_EQ(Find({0, kNumKeys - 1, kNumKeys}),
+            std::vector<int64_t>({0, (kNumKeys - 1) * 10, 0}));
+}
+
+class MutableDenseHashTableBenchmark : public MutableDenseHashTableTest {
+ public:
+  using MutableDenseHashTableTest::Find;
+  using MutableDenseHashTableTest::Insert;
+  using MutableDenseHashTableTest::MakeTable;
+
+  void TestBody() override {}
+};
+
+// Looks up single keys from `num_threads` threads, in the default or sharded
+// table.
+void BM_MutableDenseHashTableFind(::testing::benchmark::State& state) {
+  const bool sharded = state.range(0);
+  const int num_threads = state.range(1);
+  constexpr int64_t kNumKeys = 1 << 16;
+  constexpr int kLookupsPerThread = 1000;
+
+  MutableDenseHashTableBenchmark table;
+  table.MakeTable(sharded ? "sharded" : "", /*num_shards=*/16,
+                  /*initial_num_buckets=*/kNumKeys * 2);
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < kNumKeys; ++key) keys.push_back(key);
+  table.Insert(keys);
+
+  thread::ThreadPool pool(Env::Default(), "find", num_threads);
+  for (auto s : state) {
+    BlockingCounter counter(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      pool.Schedule([&table, &counter, i] {
+        for (int64_t j = 0; j < kLookupsPerThread; ++j) {
+          table.Find({(i * 7919 + j * 104729) % kNumKeys});
+        }
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads *
+                          kLookupsPerThread);
+}
+
+BENCHMARK(BM_MutableDenseHashTableFind)
+    ->UseRealTime()
+    ->ArgPair(0, 1)
+    ->ArgPair(0, 4)
+    ->ArgPair(0, 16)
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 4)
+    ->ArgPair(1, 16)
+    ->ArgPair(1, 64);
+
 }  // namespace
 }  // namespace tensorflow
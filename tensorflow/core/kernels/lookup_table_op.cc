@@ -16,9 +16,13 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -878,6 +882,698 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// A MutableDenseHashTable split into a power of two number of shards by key
+// hash, for tables that are looked up and updated concurrently from many
+// threads. It is selected by the "sharded" kernel label (the `_kernel` attr of
+// the table op), and the number of shards by the optional `_num_shards` attr.
+//
+// Each shard is an open-addressing table like MutableDenseHashTable, with a
+// lock for the writers of the shard. Lookups of trivially copyable keys and
+// values take no lock: they read the shard optimistically and retry if a
+// writer modified it meanwhile, as detected by its sequence counter (a
+// seqlock). A full shard is grown by filling larger buckets while lookups keep
+// reading the old ones, and then publishing the new buckets, so growing a shard
+// neither blocks lookups nor writers of other shards. The old buckets are freed
+// once no lock-free lookup of the shard is in progress.
+//
+// Unlike MutableDenseHashTable, inserts and removes of several keys are not
+// atomic across shards. Tables are exported in the layout of
+// MutableDenseHashTable, so that checkpoints can be restored by either kernel.
+template <class K, class V>
+class ShardedMutableDenseHashTable final : public LookupInterface {
+ public:
+  ShardedMutableDenseHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "max_load_factor", &max_load_factor_));
+    OP_REQUIRES(ctx, max_load_factor_ > 0 && max_load_factor_ < 1,
+                errors::InvalidArgument(
+                    "max_load_factor must be between 0 and 1, got: ",
+                    max_load_factor_));
+
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(value_shape_) ||
+                    TensorShapeUtils::IsVector(value_shape_),
+                errors::InvalidArgument(
+                    "Empty value must be a scalar or a vector, got shape ",
+                    value_shape_.DebugString()));
+
+    const Tensor* empty_key_input;
+    OP_REQUIRES_OK(ctx, ctx->input("empty_key", &empty_key_input));
+    key_shape_ = empty_key_input->shape();
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(key_shape_) ||
+                    TensorShapeUtils::IsVector(key_shape_),
+                errors::InvalidArgument(
+                    "Empty key must be a scalar or a vector, got shape ",
+                    key_shape_.DebugString()));
+    empty_key_ = *empty_key_input;
+
+    const Tensor* deleted_key_input;
+    OP_REQUIRES_OK(ctx, ctx->input("deleted_key", &deleted_key_input));
+    OP_REQUIRES(ctx, key_shape_.IsSameSize(deleted_key_input->shape()),
+                errors::InvalidArgument(
+                    "Empty and deleted keys must have same shape, got shapes: ",
+                    key_shape_.DebugString(), " and ",
+                    deleted_key_input->shape().DebugString()));
+    deleted_key_ = *deleted_key_input;
+    OP_REQUIRES(
+        ctx, !IsEqualKey(EmptyKeyMatrix(), 0, DeletedKeyMatrix(), 0),
+        errors::InvalidArgument("Empty and deleted keys cannot be equal"));
+
+    int64_t num_shards = kDefaultNumShards;
+    TryGetNodeAttr(kernel->def(), "_num_shards", &num_shards);
+    OP_REQUIRES(ctx, num_shards >= 1 && (num_shards & (num_shards - 1)) == 0,
+                errors::InvalidArgument(
+                    "Number of shards must be a power of 2, got: ",
+                    num_shards));
+    while ((int64_t{1} << shard_bits_) < num_shards) ++shard_bits_;
+
+    int64_t initial_num_buckets;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_num_buckets",
+                                    &initial_num_buckets));
+    OP_REQUIRES(ctx,
+                initial_num_buckets >= 4 &&
+                    (initial_num_buckets & (initial_num_buckets - 1)) == 0,
+                errors::InvalidArgument(
+                    "Number of buckets must be at least 4 and a power of 2, "
+                    "got: ",
+                    initial_num_buckets));
+    const int64_t shard_num_buckets =
+        std::max<int64_t>(4, initial_num_buckets / num_shards);
+    shards_.reserve(num_shards);
+    for (int64_t i = 0; i < num_shards; ++i) {
+      shards_.push_back(std::make_unique<Shard>());
+      std::unique_ptr<Buckets> buckets;
+      OP_REQUIRES_OK(ctx, AllocateBuckets(ctx, shard_num_buckets, &buckets));
+      mutex_lock l(shards_.back()->mu);
+      Publish(shards_.back().get(), std::move(buckets), /*num_entries=*/0);
+    }
+  }
+
+  size_t size() const override {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+      tf_shared_lock l(shard->mu);
+      size += shard->num_entries;
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const int64_t num_elements = (key.dims() == 0) ? 1 : key.dim_size(0);
+    const int64_t key_size = key_shape_.num_elements();
+    const int64_t value_size = value_shape_.num_elements();
+    TF_RETURN_IF_ERROR(CheckKeyElements(key, num_elements));
+    const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
+    auto value_matrix = value->shaped<V, 2>({num_elements, value_size});
+    const auto default_flat = default_value.flat<V>();
+
+    std::vector<uint64> key_hashes;
+    TF_RETURN_IF_ERROR(HashKeys(key_matrix, &key_hashes));
+
+    // Copies the value of key `i` from bucket `index` of `buckets`, or the
+    // default value if the key was not found.
+    auto copy_value = [&](const Buckets& buckets, int64_t i, int64_t index) {
+      const auto value_buckets_matrix = buckets.values.template matrix<V>();
+      for (int64_t j = 0; j < value_size; ++j) {
+        value_matrix(i, j) =
+            index >= 0
+                ? SubtleMustCopyIfIntegral(value_buckets_matrix(index, j))
+                : SubtleMustCopyIfIntegral(default_flat(j));
+      }
+    };
+
+    const std::vector<std::vector<int64_t>> shard_keys =
+        GroupByShard(key_hashes);
+    if (kLockFreeFind) {
+      for (int s = 0; s < shards_.size(); ++s) {
+        if (shard_keys[s].empty()) continue;
+        const Shard& shard = *shards_[s];
+        ReaderScope reader(shard);
+        for (int64_t i : shard_keys[s]) {
+          while (true) {
+            const uint64 seq = shard.seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;  // A writer is modifying the shard.
+            const Buckets* buckets = shard.buckets.load();
+            const int64_t index =
+                FindBucket(*buckets, key_matrix, i, key_hashes[i]);
+            if (index != kNotFound) copy_value(*buckets, i, index);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.seq.load(std::memory_order_relaxed) != seq) continue;
+            if (index == kNotFound) {
+              return errors::Internal(
+                  "Internal error in ShardedMutableDenseHashTable lookup");
+            }
+            break;
+          }
+        }
+      }
+      return OkStatus();
+    }
+
+    for (int s = 0; s < shards_.size(); ++s) {
+      if (shard_keys[s].empty()) continue;
+      const Shard& shard = *shards_[s];
+      tf_shared_lock l(shard.mu);
+      const Buckets& buckets = *shard.buckets.load(std::memory_order_relaxed);
+      for (int64_t i : shard_keys[s]) {
+        const int64_t index = FindBucket(buckets, key_matrix, i, key_hashes[i]);
+        if (index == kNotFound) {
+          return errors::Internal(
+              "Internal error in ShardedMutableDenseHashTable lookup");
+        }
+        copy_value(buckets, i, index);
+      }
+    }
+    return OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& key,
+                const Tensor& value) override {
+    const int64_t num_elements = (key.dims() == 0) ? 1 : key.dim_size(0);
+    TF_RETURN_IF_ERROR(CheckKeyElements(key, num_elements));
+    const auto key_matrix =
+        key.shaped<K, 2>({num_elements, key_shape_.num_elements()});
+    const auto value_matrix =
+        value.shaped<V, 2>({num_elements, value_shape_.num_elements()});
+    std::vector<uint64> key_hashes;
+    TF_RETURN_IF_ERROR(HashKeys(key_matrix, &key_hashes));
+
+    const std::vector<std::vector<int64_t>> shard_keys =
+        GroupByShard(key_hashes);
+    for (int s = 0; s < shards_.size(); ++s) {
+      if (shard_keys[s].empty()) continue;
+      Shard* shard = shards_[s].get();
+      mutex_lock l(shard->mu);
+      FreeRetiredBuckets(shard);
+      // As in MutableDenseHashTable, all keys are assumed to be new.
+      TF_RETURN_IF_ERROR(
+          MaybeGrow(ctx, shard, shard->num_entries + shard_keys[s].size()));
+      Buckets* buckets = shard->buckets.load(std::memory_order_relaxed);
+      for (int64_t i : shard_keys[s]) {
+        TF_RETURN_IF_ERROR(InsertKey(shard, buckets, key_matrix, value_matrix,
+                                     i, key_hashes[i], /*in_place=*/true));
+      }
+    }
+    return OkStatus();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& key) override {
+    const int64_t num_elements = key.dim_size(0);
+    TF_RETURN_IF_ERROR(CheckKeyElements(key, num_elements));
+    const int64_t key_size = key_shape_.num_elements();
+    const auto key_matrix = key.shaped<K, 2>({num_elements, key_size});
+    std::vector<uint64> key_hashes;
+    TF_RETURN_IF_ERROR(HashKeys(key_matrix, &key_hashes));
+    const auto deleted_key_flat = deleted_key_.template flat<K>();
+
+    const std::vector<std::vector<int64_t>> shard_keys =
+        GroupByShard(key_hashes);
+    for (int s = 0; s < shards_.size(); ++s) {
+      if (shard_keys[s].empty()) continue;
+      Shard* shard = shards_[s].get();
+      mutex_lock l(shard->mu);
+      FreeRetiredBuckets(shard);
+      Buckets* buckets = shard->buckets.load(std::memory_order_relaxed);
+      auto key_buckets_matrix = buckets->keys.template matrix<K>();
+      for (int64_t i : shard_keys[s]) {
+        const int64_t index =
+            FindBucket(*buckets, key_matrix, i, key_hashes[i]);
+        if (index == kNotFound) {
+          return errors::Internal(
+              "Internal error in ShardedMutableDenseHashTable remove");
+        }
+        if (index == kAbsent) continue;
+        WriteBegin(shard);
+        for (int64_t j = 0; j < key_size; ++j) {
+          key_buckets_matrix(index, j) =
+              SubtleMustCopyIfIntegral(deleted_key_flat(j));
+        }
+        WriteEnd(shard);
+        --shard->num_entries;
+      }
+    }
+    return OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    const int64_t num_elements = keys.dim_size(0);
+    const auto key_matrix =
+        keys.shaped<K, 2>({num_elements, key_shape_.num_elements()});
+    const auto value_matrix =
+        values.shaped<V, 2>({num_elements, value_shape_.num_elements()});
+
+    // Rebuilds the shards from the keys that are not the empty or deleted
+    // key, as the imported buckets may come from a table with another number
+    // of shards.
+    std::vector<uint64> key_hashes(num_elements);
+    std::vector<std::vector<int64_t>> shard_keys(shards_.size());
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (IsEqualKey(EmptyKeyMatrix(), 0, key_matrix, i) ||
+          IsEqualKey(DeletedKeyMatrix(), 0, key_matrix, i)) {
+        continue;
+      }
+      key_hashes[i] = HashKey(key_matrix, i);
+      shard_keys[ShardIndex(key_hashes[i])].push_back(i);
+    }
+    // Keeps the total number of buckets, unless a shard needs more.
+    const int64_t min_shard_num_buckets =
+        std::max<int64_t>(4, num_elements >> shard_bits_);
+    for (int s = 0; s < shards_.size(); ++s) {
+      Shard* shard = shards_[s].get();
+      std::unique_ptr<Buckets> buckets;
+      TF_RETURN_IF_ERROR(AllocateBuckets(
+          ctx, NumBucketsFor(shard_keys[s].size(), min_shard_num_buckets),
+          &buckets));
+      mutex_lock l(shard->mu);
+      int64_t num_entries = 0;
+      for (int64_t i : shard_keys[s]) {
+        TF_RETURN_IF_ERROR(InsertKey(shard, buckets.get(), key_matrix,
+                                     value_matrix, i, key_hashes[i],
+                                     /*in_place=*/false, &num_entries));
+      }
+      FreeRetiredBuckets(shard);
+      Publish(shard, std::move(buckets), num_entries);
+    }
+    return OkStatus();
+  }
+
+  // Exports the keys and values as the buckets of a MutableDenseHashTable
+  // holding them, which the keys of all shards are rehashed into.
+  Status ExportValues(OpKernelContext* ctx) override {
+    std::vector<std::unique_ptr<tf_shared_lock>> locks;
+    locks.reserve(shards_.size());
+    int64_t num_entries = 0;
+    int64_t num_shard_buckets = 0;
+    for (const auto& shard : shards_) {
+      locks.push_back(std::make_unique<tf_shared_lock>(shard->mu));
+      num_entries += shard->num_entries;
+      num_shard_buckets +=
+          shard->buckets.load(std::memory_order_relaxed)->num_buckets;
+    }
+    // Keeps about the total number of buckets of the shards, which is not a
+    // power of two if the shards have grown differently.
+    int64_t min_num_buckets = 4;
+    while (min_num_buckets * 2 <= num_shard_buckets) min_num_buckets <<= 1;
+    std::unique_ptr<Buckets> exported;
+    TF_RETURN_IF_ERROR(AllocateBuckets(
+        ctx, NumBucketsFor(num_entries, min_num_buckets), &exported));
+
+    const int64_t key_size = key_shape_.num_elements();
+    const int64_t value_size = value_shape_.num_elements();
+    auto exported_keys = exported->keys.template matrix<K>();
+    auto exported_values = exported->values.template matrix<V>();
+    for (const auto& shard : shards_) {
+      const Buckets& buckets = *shard->buckets.load(std::memory_order_relaxed);
+      const auto key_buckets_matrix = buckets.keys.template shaped<K, 2>(
+          {buckets.num_buckets, key_size});
+      const auto value_buckets_matrix = buckets.values.template matrix<V>();
+      for (int64_t i = 0; i < buckets.num_buckets; ++i) {
+        if (IsEqualKey(key_buckets_matrix, i, EmptyKeyMatrix(), 0) ||
+            IsEqualKey(key_buckets_matrix, i, DeletedKeyMatrix(), 0)) {
+          continue;
+        }
+        // Each key is in a single shard, so it is not in `exported` yet.
+        const int64_t index = FindInsertBucket(
+            *exported, key_buckets_matrix, i, HashKey(key_buckets_matrix, i));
+        if (index == kNotFound) {
+          return errors::Internal(
+              "Internal error in ShardedMutableDenseHashTable export");
+        }
+        for (int64_t j = 0; j < key_size; ++j) {
+          exported_keys(index, j) = key_buckets_matrix(i, j);
+        }
+        for (int64_t j = 0; j < value_size; ++j) {
+          exported_values(index, j) = value_buckets_matrix(i, j);
+        }
+      }
+    }
+    TF_RETURN_IF_ERROR(ctx->set_output("keys", exported->keys));
+    return ctx->set_output("values", exported->values);
+  }
+
+  Status CheckKeyAndValueTensorsForImport(const Tensor& keys,
+                                          const Tensor& values) override {
+    TF_RETURN_IF_ERROR(CheckKeyAndValueTypes(keys, values));
+    TF_RETURN_IF_ERROR(CheckKeyShape(keys.shape()));
+
+    // See MutableDenseHashTable::CheckKeyAndValueTensorsForImport().
+    TensorShape key_shape = MaybeVectorizeShape(key_shape_);
+    TensorShape value_shape = MaybeVectorizeShape(value_shape_);
+    TensorShape expected_value_shape = keys.shape();
+    expected_value_shape.RemoveLastDims(key_shape.dims());
+    expected_value_shape.AppendShape(value_shape);
+    if (values.shape() != expected_value_shape) {
+      return errors::InvalidArgument(
+          "Expected shape ", expected_value_shape.DebugString(),
+          " for value, got ", values.shape().DebugString());
+    }
+    return OkStatus();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const override { return key_shape_; }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64_t MemoryUsed() const override {
+    int64_t memory_used = sizeof(ShardedMutableDenseHashTable) +
+                          empty_key_.AllocatedBytes() +
+                          deleted_key_.AllocatedBytes();
+    for (const auto& shard : shards_) {
+      tf_shared_lock l(shard->mu);
+      const Buckets& buckets = *shard->buckets.load(std::memory_order_relaxed);
+      memory_used += sizeof(Shard) + buckets.keys.AllocatedBytes() +
+                     buckets.values.AllocatedBytes();
+    }
+    return memory_used;
+  }
+
+ private:
+  static constexpr int64_t kDefaultNumShards = 16;
+
+  // Whether lookups may read keys and values that are concurrently written.
+  static constexpr bool kLockFreeFind =
+      std::is_trivially_copyable<K>::value &&
+      std::is_trivially_copyable<V>::value;
+
+  // Results of FindBucket() other than a bucket index.
+  static constexpr int64_t kAbsent = -1;
+  static constexpr int64_t kNotFound = -2;
+
+  struct Buckets {
+    int64_t num_buckets;
+    Tensor keys;    // [num_buckets, key_size]
+    Tensor values;  // [num_buckets, value_size]
+  };
+
+  struct Shard {
+    // Held by the writers of the shard, and shared by lookups that are not
+    // lock-free.
+    mutable mutex mu;
+    // Odd while a writer modifies the current buckets.
+    std::atomic<uint64> seq{0};
+    // The current buckets, owned by `owned_buckets`.
+    std::atomic<Buckets*> buckets{nullptr};
+    std::unique_ptr<Buckets> owned_buckets TF_GUARDED_BY(mu);
+    // Replaced buckets that lock-free lookups may still be reading.
+    std::vector<std::unique_ptr<Buckets>> retired_buckets TF_GUARDED_BY(mu);
+    int64_t num_entries TF_GUARDED_BY(mu) = 0;
+    // The number of lock-free lookups reading the shard.
+    mutable std::atomic<int64_t> num_readers{0};
+  };
+
+  // Counts a lock-free lookup of `shard` during its lifetime.
+  class ReaderScope {
+   public:
+    explicit ReaderScope(const Shard& shard) : shard_(shard) {
+      // Ordered before the load of the buckets of the shard, so that a writer
+      // that does not see the reader has published its buckets before the
+      // reader loads them.
+      shard_.num_readers.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~ReaderScope() {
+      shard_.num_readers.fetch_sub(1, std::memory_order_release);
+    }
+
+   private:
+    const Shard& shard_;
+  };
+
+  typename TTypes<K>::ConstMatrix EmptyKeyMatrix() const {
+    return empty_key_.template shaped<K, 2>({1, key_shape_.num_elements()});
+  }
+
+  typename TTypes<K>::ConstMatrix DeletedKeyMatrix() const {
+    return deleted_key_.template shaped<K, 2>({1, key_shape_.num_elements()});
+  }
+
+  Status CheckKeyElements(const Tensor& key, int64_t num_elements) const {
+    if (key.NumElements() != num_elements * key_shape_.num_elements()) {
+      TensorShape expected_shape({num_elements});
+      expected_shape.AppendShape(key_shape_);
+      return errors::InvalidArgument("Expected key shape ",
+                                     expected_shape.DebugString(), " got ",
+                                     key.shape().DebugString());
+    }
+    return OkStatus();
+  }
+
+  // Hashes the keys of `key_matrix`, which must not be the empty or deleted
+  // key.
+  Status HashKeys(typename TTypes<K>::ConstMatrix key_matrix,
+                  std::vector<uint64>* key_hashes) const {
+    key_hashes->resize(key_matrix.dimension(0));
+    for (int64_t i = 0; i < key_matrix.dimension(0); ++i) {
+      if (IsEqualKey(EmptyKeyMatrix(), 0, key_matrix, i)) {
+        return errors::InvalidArgument(
+            "Using the empty_key as a table key is not allowed");
+      }
+      if (IsEqualKey(DeletedKeyMatrix(), 0, key_matrix, i)) {
+        return errors::InvalidArgument(
+            "Using the deleted_key as a table key is not allowed");
+      }
+      (*key_hashes)[i] = HashKey(key_matrix, i);
+    }
+    return OkStatus();
+  }
+
+  uint64 HashKey(typename TTypes<K>::ConstMatrix key, int64_t index) const {
+    if (key_shape_.num_elements() == 1) {
+      return HashScalar(key(index, 0));
+    }
+    uint64 result = 0;
+    for (int64_t i = 0; i < key_shape_.num_elements(); ++i) {
+      result = Hash64Combine(result, HashScalar(key(index, i)));
+    }
+    return result;
+  }
+
+  // Shards are selected by the high bits of the mixed hash, as the low bits of
+  // the hash select the bucket and scalar integer keys are their own hash.
+  int ShardIndex(uint64 key_hash) const {
+    if (shard_bits_ == 0) return 0;
+    return (key_hash * 0x9E3779B97F4A7C15ULL) >> (64 - shard_bits_);
+  }
+
+  // Returns the indices of the keys of each shard.
+  std::vector<std::vector<int64_t>> GroupByShard(
+      const std::vector<uint64>& key_hashes) const {
+    std::vector<std::vector<int64_t>> shard_keys(shards_.size());
+    for (int64_t i = 0; i < key_hashes.size(); ++i) {
+      shard_keys[ShardIndex(key_hashes[i])].push_back(i);
+    }
+    return shard_keys;
+  }
+
+  template <typename MT1, typename MT2>
+  bool IsEqualKey(MT1 tensor1, int64_t index1, MT2 tensor2,
+                  int64_t index2) const {
+    for (int64_t i = 0; i < key_shape_.num_elements(); ++i) {
+      if (tensor1(index1, i) != tensor2(index2, i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns the index of the bucket holding key `i` of `key_matrix`, kAbsent
+  // if the key is not in `buckets`, or kNotFound if probing did not end,
+  // which can only happen if `buckets` are concurrently modified.
+  int64_t FindBucket(const Buckets& buckets,
+                     typename TTypes<K>::ConstMatrix key_matrix, int64_t i,
+                     uint64 key_hash) const {
+    const auto key_buckets_matrix = buckets.keys.template matrix<K>();
+    const int64_t bit_mask = buckets.num_buckets - 1;
+    int64_t bucket_index = key_hash & bit_mask;
+    for (int64_t num_probes = 1; num_probes <= buckets.num_buckets;
+         ++num_probes) {
+      if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
+        return bucket_index;
+      }
+      if (IsEqualKey(key_buckets_matrix, bucket_index, EmptyKeyMatrix(), 0)) {
+        return kAbsent;
+      }
+      bucket_index =
+          (bucket_index + num_probes) & bit_mask;  // quadratic probing
+    }
+    return kNotFound;
+  }
+
+  // Inserts or updates key `i` of `key_matrix` in `buckets`, counting new
+  // keys in `*num_entries`, or in the entries of `shard` if null. If
+  // `in_place`, `buckets` are the current buckets of `shard` and concurrent
+  // lookups may be reading them.
+  // Returns the index of the bucket to store key `i` of `key_matrix` in: the
+  // bucket holding the key, or else the first empty or deleted bucket of its
+  // probe sequence, or kNotFound if there is none.
+  int64_t FindInsertBucket(const Buckets& buckets,
+                           typename TTypes<K>::ConstMatrix key_matrix,
+                           int64_t i, uint64 key_hash) const {
+    const auto key_buckets_matrix = buckets.keys.template matrix<K>();
+    const int64_t bit_mask = buckets.num_buckets - 1;
+    int64_t bucket_index = key_hash & bit_mask;
+    for (int64_t num_probes = 1; num_probes <= buckets.num_buckets;
+         ++num_probes) {
+      if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i) ||
+          IsEqualKey(key_buckets_matrix, bucket_index, EmptyKeyMatrix(), 0) ||
+          IsEqualKey(key_buckets_matrix, bucket_index, DeletedKeyMatrix(), 0)) {
+        return bucket_index;
+      }
+      bucket_index =
+          (bucket_index + num_probes) & bit_mask;  // quadratic probing
+    }
+    return kNotFound;
+  }
+
+  Status InsertKey(Shard* shard, Buckets* buckets,
+                   typename TTypes<K>::ConstMatrix key_matrix,
+                   typename TTypes<V>::ConstMatrix value_matrix, int64_t i,
+                   uint64 key_hash, bool in_place,
+                   int64_t* num_entries = nullptr)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    const int64_t bucket_index =
+        FindInsertBucket(*buckets, key_matrix, i, key_hash);
+    if (bucket_index == kNotFound) {
+      return errors::Internal(
+          "Internal error in ShardedMutableDenseHashTable insert");
+    }
+    auto key_buckets_matrix = buckets->keys.template matrix<K>();
+    auto value_buckets_matrix = buckets->values.template matrix<V>();
+    const bool found =
+        IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i);
+    if (in_place) WriteBegin(shard);
+    if (!found) {
+      ++(num_entries != nullptr ? *num_entries : shard->num_entries);
+      for (int64_t j = 0; j < key_shape_.num_elements(); ++j) {
+        key_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyIfIntegral(key_matrix(i, j));
+      }
+    }
+    for (int64_t j = 0; j < value_shape_.num_elements(); ++j) {
+      value_buckets_matrix(bucket_index, j) =
+          SubtleMustCopyIfIntegral(value_matrix(i, j));
+    }
+    if (in_place) WriteEnd(shard);
+    return OkStatus();
+  }
+
+  void WriteBegin(Shard* shard) const TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->seq.store(shard->seq.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void WriteEnd(Shard* shard) const TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->seq.store(shard->seq.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+  }
+
+  // Returns the number of buckets, at least `min_num_buckets`, needed to
+  // hold `num_entries`.
+  int64_t NumBucketsFor(int64_t num_entries, int64_t min_num_buckets) const {
+    int64_t num_buckets = 4;
+    while (num_buckets < min_num_buckets ||
+           num_entries > num_buckets * max_load_factor_) {
+      num_buckets <<= 1;
+    }
+    return num_buckets;
+  }
+
+  // Grows the buckets of `shard` if they cannot hold `num_entries`.
+  Status MaybeGrow(OpKernelContext* ctx, Shard* shard, int64_t num_entries)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    const Buckets* old_buckets = shard->buckets.load(std::memory_order_relaxed);
+    if (num_entries <= old_buckets->num_buckets * max_load_factor_) {
+      return OkStatus();
+    }
+    std::unique_ptr<Buckets> new_buckets;
+    TF_RETURN_IF_ERROR(AllocateBuckets(
+        ctx, NumBucketsFor(num_entries, old_buckets->num_buckets),
+        &new_buckets));
+
+    // Fills the new buckets while lookups keep reading the old ones, which
+    // are not modified anymore, and then publishes them.
+    const int64_t num_old_buckets = old_buckets->num_buckets;
+    const auto old_keys = old_buckets->keys.template shaped<K, 2>(
+        {num_old_buckets, key_shape_.num_elements()});
+    const auto old_values = old_buckets->values.template shaped<V, 2>(
+        {num_old_buckets, value_shape_.num_elements()});
+    int64_t new_num_entries = 0;
+    for (int64_t i = 0; i < num_old_buckets; ++i) {
+      if (IsEqualKey(old_keys, i, EmptyKeyMatrix(), 0) ||
+          IsEqualKey(old_keys, i, DeletedKeyMatrix(), 0)) {
+        continue;
+      }
+      TF_RETURN_IF_ERROR(InsertKey(shard, new_buckets.get(), old_keys,
+                                   old_values, i, HashKey(old_keys, i),
+                                   /*in_place=*/false, &new_num_entries));
+    }
+    Publish(shard, std::move(new_buckets), new_num_entries);
+    return OkStatus();
+  }
+
+  Status AllocateBuckets(OpKernelContext* ctx, int64_t num_buckets,
+                         std::unique_ptr<Buckets>* buckets) const {
+    auto new_buckets = std::make_unique<Buckets>();
+    new_buckets->num_buckets = num_buckets;
+    const int64_t key_size = key_shape_.num_elements();
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(key_dtype(),
+                                          TensorShape({num_buckets, key_size}),
+                                          &new_buckets->keys));
+    auto key_buckets_matrix = new_buckets->keys.template matrix<K>();
+    const auto empty_key_flat = empty_key_.template flat<K>();
+    for (int64_t i = 0; i < num_buckets; ++i) {
+      for (int64_t j = 0; j < key_size; ++j) {
+        key_buckets_matrix(i, j) = empty_key_flat(j);
+      }
+    }
+    const int64_t value_size = value_shape_.num_elements();
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        value_dtype(), TensorShape({num_buckets, value_size}),
+        &new_buckets->values));
+    // Avoids exposing uninitialized memory in ExportValues().
+    new_buckets->values.template flat<V>().setConstant(V());
+    *buckets = std::move(new_buckets);
+    return OkStatus();
+  }
+
+  // Makes `buckets` the current buckets of `shard`, with `num_entries` keys.
+  // The replaced buckets are retired, as lock-free lookups may still be
+  // reading them.
+  void Publish(Shard* shard, std::unique_ptr<Buckets> buckets,
+               int64_t num_entries) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->buckets.store(buckets.get());
+    if (shard->owned_buckets != nullptr) {
+      shard->retired_buckets.push_back(std::move(shard->owned_buckets));
+    }
+    shard->owned_buckets = std::move(buckets);
+    shard->num_entries = num_entries;
+  }
+
+  // Frees the retired buckets of `shard` if no lock-free lookup of the shard
+  // is in progress. Lookups starting later only read the current buckets.
+  void FreeRetiredBuckets(Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    if (shard->retired_buckets.empty()) return;
+    if (shard->num_readers.load() == 0) shard->retired_buckets.clear();
+  }
+
+  TensorShape key_shape_;
+  TensorShape value_shape_;
+  float max_load_factor_;
+  Tensor empty_key_;
+  Tensor deleted_key_;
+  int shard_bits_ = 0;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -1244,4 +1940,53 @@ REGISTER_KERNEL(tstring, ResourceHandle);
 
 #undef REGISTER_KERNEL
 
+// Register the sharded MutableDenseHashTable, selected by the "sharded" kernel
+// label.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableDenseHashTable")                                          \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype")                        \
+          .Label("sharded"),                                                 \
+      LookupTableOp<                                                         \
+          lookup::ShardedMutableDenseHashTable<key_dtype, value_dtype>,      \
+          key_dtype, value_dtype>)                                           \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableDenseHashTableV2")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype")                        \
+          .Label("sharded"),                                                 \
+      LookupTableOp<                                                         \
+          lookup::ShardedMutableDenseHashTable<key_dtype, value_dtype>,      \
+          key_dtype, value_dtype>)                                           \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("AnonymousMutableDenseHashTable")                                 \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype")                        \
+          .Label("sharded"),                                                 \
+      AnonymousLookupTableOp<                                                \
+          lookup::ShardedMutableDenseHashTable<key_dtype, value_dtype>,      \
+          key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64_t, bool);
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(int64_t, Variant);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64_t);
+REGISTER_KERNEL(tstring, ResourceHandle);
+
+#undef REGISTER_KERNEL
+
 }  // namespace tensorflow
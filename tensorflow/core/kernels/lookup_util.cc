@@ -57,6 +57,36 @@ Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
   return OkStatus();
 }
 
+// Checks that the key and value indices of a text file are valid for the
+// given data types.
+Status CheckTextFileIndices(int32_t key_index, DataType key_dtype,
+                            int32_t value_index, DataType value_dtype) {
+  if (key_index == kLineNumber && key_dtype != DT_INT64) {
+    return errors::InvalidArgument(
+        "Key index for line number requires table key dtype of int64, got ",
+        DataTypeString(key_dtype));
+  }
+  if (key_index == kWholeLine && !DataTypeIsInteger(key_dtype) &&
+      key_dtype != DT_STRING) {
+    return errors::InvalidArgument(
+        "Key index for whole line requires string or integer table key, got ",
+        DataTypeString(key_dtype));
+  }
+  if (value_index == kLineNumber && value_dtype != DT_INT64) {
+    return errors::InvalidArgument(
+        "Value index for line number requires table value dtype of int64, got ",
+        DataTypeString(value_dtype));
+  }
+  if (value_index == kWholeLine && !DataTypeIsInteger(value_dtype) &&
+      value_dtype != DT_STRING) {
+    return errors::InvalidArgument(
+        "Value index for whole line requires table value dtype of integer or "
+        "string, got ",
+        DataTypeString(value_dtype));
+  }
+  return OkStatus();
+}
+
 // Iterator that reads a text file. Each iteration process one line, it parses
 // the line and populates the keys and values tensors used for initialization
 // with a single key and corresponding value.
@@ -374,31 +404,10 @@ Status InitializeTableFromTextFile(
     int32_t key_index, int32_t value_index, int64_t offset, Env* env,
     std::unique_ptr<InitializableLookupTable::InitializerSerializer> serializer,
     InitializableLookupTable* table) {
-  if (key_index == kLineNumber && table->key_dtype() != DT_INT64) {
-    return errors::InvalidArgument(
-        "Key index for line number requires table key dtype of int64, got ",
-        DataTypeString(table->key_dtype()));
-  }
   const DataType& key_dtype = table->key_dtype();
   const DataType& value_dtype = table->value_dtype();
-  if (key_index == kWholeLine && !DataTypeIsInteger(key_dtype) &&
-      key_dtype != DT_STRING) {
-    return errors::InvalidArgument(
-        "Key index for whole line requires string or integer table key, got ",
-        DataTypeString(table->key_dtype()));
-  }
-  if (value_index == kLineNumber && value_dtype != DT_INT64) {
-    return errors::InvalidArgument(
-        "Value index for line number requires table value dtype of int64, got ",
-        DataTypeString(table->value_dtype()));
-  }
-  if (value_index == kWholeLine && !DataTypeIsInteger(value_dtype) &&
-      value_dtype != DT_STRING) {
-    return errors::InvalidArgument(
-        "Value index for whole line requires table value dtype of integer or "
-        "string, got ",
-        DataTypeString(table->value_dtype()));
-  }
+  TF_RETURN_IF_ERROR(
+      CheckTextFileIndices(key_index, key_dtype, value_index, value_dtype));
 
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
@@ -417,5 +426,23 @@ Status InitializeTableFromTextFile(
   return s;
 }
 
+Status ReadTextFileEntries(
+    const string& filename, int64_t vocab_size, char delimiter,
+    int32_t key_index, DataType key_dtype, int32_t value_index,
+    DataType value_dtype, int64_t offset, Env* env,
+    const std::function<Status(const Tensor& key, const Tensor& value)>& fn) {
+  TF_RETURN_IF_ERROR(
+      CheckTextFileIndices(key_index, key_dtype, value_index, value_dtype));
+  TextFileLineIterator iter;
+  TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
+                               key_index, value_dtype, value_index, offset,
+                               env));
+  for (; iter.Valid(); iter.Next()) {
+    TF_RETURN_IF_ERROR(fn(iter.keys(), iter.values()));
+  }
+  if (!absl::IsOutOfRange(iter.status())) return iter.status();
+  return OkStatus();
+}
+
 }  // namespace lookup
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_LOOKUP_UTIL_H_
 #define TENSORFLOW_CORE_KERNELS_LOOKUP_UTIL_H_
 
+#include <functional>
+
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
@@ -65,6 +67,15 @@ Status InitializeTableFromTextFile(
     std::unique_ptr<InitializableLookupTable::InitializerSerializer> serializer,
     InitializableLookupTable* table);
 
+// Reads the keys and values of the lines of `filename` as
+// InitializeTableFromTextFile() does, calling `fn` with each of them as scalar
+// tensors.
+Status ReadTextFileEntries(
+    const string& filename, int64_t vocab_size, char delimiter,
+    int32_t key_index, DataType key_dtype, int32_t value_index,
+    DataType value_dtype, int64_t offset, Env* env,
+    const std::function<Status(const Tensor& key, const Tensor& value)>& fn);
+
 }  // namespace lookup
 }  // namespace tensorflow
 
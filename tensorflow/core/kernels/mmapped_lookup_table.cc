@@ -0,0 +1,397 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mmapped_lookup_table.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace lookup {
+
+using mmapped_lookup_table::Bucket;
+using mmapped_lookup_table::Header;
+using mmapped_lookup_table::kEmptyBucket;
+
+namespace {
+
+// Number of buckets written at once by MmappedLookupTableBuilder::Write().
+constexpr int64_t kWriteBatchSize = 1 << 16;
+
+bool IsSupportedType(DataType dtype) {
+  return dtype == DT_INT64 || dtype == DT_STRING;
+}
+
+uint64 HashInt64(int64_t key) {
+  return Fingerprint64(
+      StringPiece(reinterpret_cast<const char*>(&key), sizeof(key)));
+}
+
+// A mapping of a file, and the size and modification time the file had when
+// it was mapped.
+struct SharedRegion {
+  std::weak_ptr<const ReadOnlyMemoryRegion> region;
+  uint64 length = 0;
+  int64_t mtime_nsec = 0;
+};
+
+// Maps `filename` in memory, sharing the mapping with the tables of the
+// process that already use it, unless the file has been rebuilt since.
+Status MapFile(Env* env, const std::string& filename,
+               std::shared_ptr<const ReadOnlyMemoryRegion>* region) {
+  static mutex* mu = new mutex;
+  static auto* regions = new absl::flat_hash_map<std::string, SharedRegion>;
+  FileStatistics stat;
+  TF_RETURN_IF_ERROR(env->Stat(filename, &stat));
+  mutex_lock l(*mu);
+  SharedRegion& shared_region = (*regions)[filename];
+  if (shared_region.length == stat.length &&
+      shared_region.mtime_nsec == stat.mtime_nsec) {
+    *region = shared_region.region.lock();
+    if (*region != nullptr) return OkStatus();
+  }
+  std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+  TF_RETURN_IF_ERROR(
+      env->NewReadOnlyMemoryRegionFromFile(filename, &new_region));
+  *region = std::move(new_region);
+  shared_region.region = *region;
+  shared_region.length = stat.length;
+  shared_region.mtime_nsec = stat.mtime_nsec;
+  return OkStatus();
+}
+
+}  // namespace
+
+MmappedLookupTableBuilder::MmappedLookupTableBuilder(DataType key_dtype,
+                                                     DataType value_dtype)
+    : key_dtype_(key_dtype), value_dtype_(value_dtype) {}
+
+Status MmappedLookupTableBuilder::Add(const Tensor& keys,
+                                      const Tensor& values) {
+  if (!IsSupportedType(key_dtype_) || !IsSupportedType(value_dtype_)) {
+    return errors::InvalidArgument(
+        "Mmapped lookup tables only support int64 and string keys and values, "
+        "got ",
+        DataTypeString(key_dtype_), " and ", DataTypeString(value_dtype_));
+  }
+  if (keys.dtype() != key_dtype_ || values.dtype() != value_dtype_) {
+    return errors::InvalidArgument(
+        "Expected keys of type ", DataTypeString(key_dtype_),
+        " and values of type ", DataTypeString(value_dtype_), ", got ",
+        DataTypeString(keys.dtype()), " and ", DataTypeString(values.dtype()));
+  }
+  if (!keys.shape().IsSameSize(values.shape())) {
+    return errors::InvalidArgument(
+        "Expected keys and values of the same shape, got shapes ",
+        keys.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+  for (int64_t i = 0; i < keys.NumElements(); ++i) {
+    Bucket entry;
+    uint64 unused_hash;
+    entry.key = Encode(keys, i, &entry.key_size, &entry.hash);
+    entry.value = Encode(values, i, &entry.value_size, &unused_hash);
+    if (entry.key_size == kEmptyBucket || entry.value_size == kEmptyBucket) {
+      return errors::InvalidArgument("String of entry ", i, " is too long");
+    }
+    entries_.push_back(entry);
+  }
+  return OkStatus();
+}
+
+uint64 MmappedLookupTableBuilder::Encode(const Tensor& t, int64_t i,
+                                         uint32* size, uint64* hash) {
+  if (t.dtype() == DT_INT64) {
+    const int64_t value = t.flat<int64_t>()(i);
+    *size = 0;
+    *hash = HashInt64(value);
+    return static_cast<uint64>(value);
+  }
+  const tstring& value = t.flat<tstring>()(i);
+  const uint64 offset = strings_.size();
+  *size = std::min<size_t>(value.size(), kEmptyBucket);
+  *hash = Fingerprint64(value);
+  strings_.append(value.data(), value.size());
+  return offset;
+}
+
+Status MmappedLookupTableBuilder::Write(Env* env,
+                                       const std::string& filename) {
+  Header header;
+  header.magic = mmapped_lookup_table::kMagic;
+  header.key_dtype = key_dtype_;
+  header.value_dtype = value_dtype_;
+  header.num_entries = entries_.size();
+  // Keeps the load factor at most 1/2, so that probes stay short.
+  header.num_buckets = 1;
+  while (header.num_buckets < 2 * header.num_entries) {
+    header.num_buckets <<= 1;
+  }
+  header.strings_offset = sizeof(Header) + header.num_buckets * sizeof(Bucket);
+  header.strings_size = strings_.size();
+
+  // Places the entries in the buckets, as indices in `entries_`.
+  constexpr uint64 kNoEntry = ~uint64{0};
+  std::vector<uint64> slots(header.num_buckets, kNoEntry);
+  const uint64 bit_mask = header.num_buckets - 1;
+  for (uint64 i = 0; i < entries_.size(); ++i) {
+    const Bucket& entry = entries_[i];
+    uint64 bucket_index = entry.hash & bit_mask;
+    while (slots[bucket_index] != kNoEntry) {
+      const Bucket& other = entries_[slots[bucket_index]];
+      if (other.hash == entry.hash && other.key_size == entry.key_size &&
+          (key_dtype_ == DT_INT64
+               ? other.key == entry.key
+               : strings_.compare(other.key, other.key_size, strings_,
+                                  entry.key, entry.key_size) == 0)) {
+        return errors::InvalidArgument("Duplicate key of entry ", i);
+      }
+      bucket_index = (bucket_index + 1) & bit_mask;
+    }
+    slots[bucket_index] = i;
+  }
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(&header), sizeof(header))));
+  Bucket empty_bucket = {};
+  empty_bucket.key_size = kEmptyBucket;
+  std::vector<Bucket> buckets;
+  buckets.reserve(std::min<uint64>(header.num_buckets, kWriteBatchSize));
+  for (uint64 begin = 0; begin < header.num_buckets;
+       begin += kWriteBatchSize) {
+    const uint64 end =
+        std::min<uint64>(begin + kWriteBatchSize, header.num_buckets);
+    buckets.clear();
+    for (uint64 j = begin; j < end; ++j) {
+      buckets.push_back(slots[j] == kNoEntry ? empty_bucket
+                                             : entries_[slots[j]]);
+    }
+    TF_RETURN_IF_ERROR(file->Append(
+        StringPiece(reinterpret_cast<const char*>(buckets.data()),
+                    buckets.size() * sizeof(Bucket))));
+  }
+  TF_RETURN_IF_ERROR(file->Append(strings_));
+  return file->Close();
+}
+
+MmappedLookupTable::MmappedLookupTable(OpKernelContext* ctx,
+                                       OpKernel* kernel) {
+  const Tensor* filename;
+  OP_REQUIRES_OK(ctx, ctx->input("filename", &filename));
+  OP_REQUIRES(
+      ctx, TensorShapeUtils::IsScalar(filename->shape()),
+      errors::InvalidArgument("filename should be a single string, but got ",
+                              filename->shape().DebugString()));
+  OP_REQUIRES(ctx, !filename->scalar<tstring>()().empty(),
+              errors::InvalidArgument("filename cannot be empty."));
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "key_dtype", &key_dtype_));
+  OP_REQUIRES_OK(ctx,
+                 GetNodeAttr(kernel->def(), "value_dtype", &value_dtype_));
+  OP_REQUIRES_OK(ctx, Open(ctx->env(), filename->scalar<tstring>()()));
+}
+
+Status MmappedLookupTable::Open(Env* env, const std::string& filename) {
+  TF_RETURN_IF_ERROR(MapFile(env, filename, &region_));
+  const uint64 length = region_->length();
+  if (length < sizeof(Header)) {
+    return errors::DataLoss("Mmapped lookup table file ", filename,
+                            " is too short");
+  }
+  header_ = static_cast<const Header*>(region_->data());
+  if (header_->magic != mmapped_lookup_table::kMagic) {
+    return errors::DataLoss(
+        filename,
+        " is not a mmapped lookup table file, or was built on a machine of "
+        "another byte order");
+  }
+  if (header_->key_dtype != key_dtype_ ||
+      header_->value_dtype != value_dtype_) {
+    return errors::InvalidArgument(
+        "Mmapped lookup table file ", filename, " has keys of type ",
+        DataTypeString(static_cast<DataType>(header_->key_dtype)),
+        " and values of type ",
+        DataTypeString(static_cast<DataType>(header_->value_dtype)),
+        ", expected ", DataTypeString(key_dtype_), " and ",
+        DataTypeString(value_dtype_));
+  }
+  const uint64 num_buckets = header_->num_buckets;
+  const uint64 buckets_size = num_buckets * sizeof(Bucket);
+  if (num_buckets == 0 || (num_buckets & (num_buckets - 1)) != 0 ||
+      header_->num_entries >= num_buckets ||
+      num_buckets > (length - sizeof(Header)) / sizeof(Bucket) ||
+      header_->strings_offset != sizeof(Header) + buckets_size ||
+      header_->strings_size > length - header_->strings_offset) {
+    return errors::DataLoss("Mmapped lookup table file ", filename,
+                            " is corrupted");
+  }
+  const char* data = static_cast<const char*>(region_->data());
+  buckets_ = reinterpret_cast<const Bucket*>(data + sizeof(Header));
+  strings_ = data + header_->strings_offset;
+  return OkStatus();
+}
+
+size_t MmappedLookupTable::size() const { return header_->num_entries; }
+
+Status MmappedLookupTable::GetString(uint64 offset, uint32 size,
+                                     StringPiece* s) const {
+  if (offset > header_->strings_size ||
+      size > header_->strings_size - offset) {
+    return errors::DataLoss("Mmapped lookup table file is corrupted");
+  }
+  *s = StringPiece(strings_ + offset, size);
+  return OkStatus();
+}
+
+Status MmappedLookupTable::FindBucket(const Tensor& keys, int64_t i,
+                                      const Bucket** bucket) const {
+  const bool string_keys = key_dtype_ == DT_STRING;
+  StringPiece key;
+  int64_t int_key = 0;
+  uint64 hash;
+  if (string_keys) {
+    key = keys.flat<tstring>()(i);
+    hash = Fingerprint64(key);
+  } else {
+    int_key = keys.flat<int64_t>()(i);
+    hash = HashInt64(int_key);
+  }
+
+  const uint64 bit_mask = header_->num_buckets - 1;
+  uint64 bucket_index = hash & bit_mask;
+  // Probing ends at an empty bucket, as the table is never full.
+  for (uint64 num_probes = 0; num_probes < header_->num_buckets;
+       ++num_probes) {
+    const Bucket& candidate = buckets_[bucket_index];
+    if (candidate.key_size == kEmptyBucket) break;
+    if (candidate.hash == hash) {
+      if (!string_keys) {
+        if (static_cast<int64_t>(candidate.key) == int_key) {
+          *bucket = &candidate;
+          return OkStatus();
+        }
+      } else if (candidate.key_size == key.size()) {
+        StringPiece candidate_key;
+        TF_RETURN_IF_ERROR(
+            GetString(candidate.key, candidate.key_size, &candidate_key));
+        if (candidate_key == key) {
+          *bucket = &candidate;
+          return OkStatus();
+        }
+      }
+    }
+    bucket_index = (bucket_index + 1) & bit_mask;
+  }
+  *bucket = nullptr;
+  return OkStatus();
+}
+
+Status MmappedLookupTable::DecodeValue(const Bucket& bucket, Tensor* values,
+                                       int64_t i) const {
+  if (value_dtype_ == DT_INT64) {
+    values->flat<int64_t>()(i) = static_cast<int64_t>(bucket.value);
+    return OkStatus();
+  }
+  StringPiece value;
+  TF_RETURN_IF_ERROR(GetString(bucket.value, bucket.value_size, &value));
+  values->flat<tstring>()(i).assign(value.data(), value.size());
+  return OkStatus();
+}
+
+Status MmappedLookupTable::Find(OpKernelContext* ctx, const Tensor& keys,
+                                Tensor* values, const Tensor& default_value) {
+  for (int64_t i = 0; i < keys.NumElements(); ++i) {
+    const Bucket* bucket;
+    TF_RETURN_IF_ERROR(FindBucket(keys, i, &bucket));
+    if (bucket != nullptr) {
+      TF_RETURN_IF_ERROR(DecodeValue(*bucket, values, i));
+    } else if (value_dtype_ == DT_INT64) {
+      values->flat<int64_t>()(i) = default_value.flat<int64_t>()(0);
+    } else {
+      values->flat<tstring>()(i) = default_value.flat<tstring>()(0);
+    }
+  }
+  return OkStatus();
+}
+
+Status MmappedLookupTable::Insert(OpKernelContext* ctx, const Tensor& keys,
+                                  const Tensor& values) {
+  return errors::Unimplemented("Insert not supported by MmappedLookupTable");
+}
+
+Status MmappedLookupTable::Remove(OpKernelContext* ctx, const Tensor& keys) {
+  return errors::Unimplemented("Remove not supported by MmappedLookupTable");
+}
+
+Status MmappedLookupTable::ImportValues(OpKernelContext* ctx,
+                                        const Tensor& keys,
+                                        const Tensor& values) {
+  return errors::Unimplemented(
+      "ImportValues not supported by MmappedLookupTable");
+}
+
+Status MmappedLookupTable::ExportValues(OpKernelContext* ctx) {
+  const int64_t size = header_->num_entries;
+  Tensor* keys;
+  Tensor* values;
+  TF_RETURN_IF_ERROR(ctx->allocate_output("keys", TensorShape({size}), &keys));
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output("values", TensorShape({size}), &values));
+  int64_t i = 0;
+  for (uint64 j = 0; j < header_->num_buckets && i < size; ++j) {
+    const Bucket& bucket = buckets_[j];
+    if (bucket.key_size == kEmptyBucket) continue;
+    if (key_dtype_ == DT_INT64) {
+      keys->flat<int64_t>()(i) = static_cast<int64_t>(bucket.key);
+    } else {
+      StringPiece key;
+      TF_RETURN_IF_ERROR(GetString(bucket.key, bucket.key_size, &key));
+      keys->flat<tstring>()(i).assign(key.data(), key.size());
+    }
+    TF_RETURN_IF_ERROR(DecodeValue(bucket, values, i));
+    ++i;
+  }
+  if (i != size) {
+    return errors::DataLoss("Mmapped lookup table file is corrupted");
+  }
+  return OkStatus();
+}
+
+}  // namespace lookup
+
+// Register the MmappedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                  \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("MmappedHashTable")                                   \
+          .Device(DEVICE_CPU)                                    \
+          .TypeConstraint<key_dtype>("key_dtype")                \
+          .TypeConstraint<value_dtype>("value_dtype"),           \
+      LookupTableOp<lookup::MmappedLookupTable, key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(int64_t, tstring);
+REGISTER_KERNEL(tstring, int64_t);
+REGISTER_KERNEL(tstring, tstring);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
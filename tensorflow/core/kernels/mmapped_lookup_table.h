@@ -0,0 +1,156 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MMAPPED_LOOKUP_TABLE_H_
+#define TENSORFLOW_CORE_KERNELS_MMAPPED_LOOKUP_TABLE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// The file format of a MmappedLookupTable: a header, followed by an open
+// addressing hash table of `num_buckets` buckets with linear probing, followed
+// by the bytes of the string keys and values. Integers are in the byte order
+// of the machine that built the file, which is checked through the magic
+// number.
+namespace mmapped_lookup_table {
+
+constexpr uint64 kMagic = 0x31304C424154484DULL;  // "MHTABL01"
+
+struct Header {
+  uint64 magic;
+  uint32 key_dtype;    // DataType of the keys.
+  uint32 value_dtype;  // DataType of the values.
+  uint64 num_entries;
+  uint64 num_buckets;     // A power of 2 greater than `num_entries`.
+  uint64 strings_offset;  // Offset of the string data in the file.
+  uint64 strings_size;
+};
+
+// Key sizes of empty buckets.
+constexpr uint32 kEmptyBucket = ~uint32{0};
+
+struct Bucket {
+  uint64 hash;  // Fingerprint64 of the key bytes.
+  // An int64 key or value, or the offset of a string key or value in the
+  // string data.
+  uint64 key;
+  uint64 value;
+  // Sizes of a string key or value.
+  uint32 key_size;
+  uint32 value_size;
+};
+
+}  // namespace mmapped_lookup_table
+
+// Builds the file of a MmappedLookupTable from keys and values of type int64
+// or string, e.g. offline from a vocabulary too large to be parsed at every
+// model load. The whole table is held in memory until Write().
+class MmappedLookupTableBuilder {
+ public:
+  MmappedLookupTableBuilder(DataType key_dtype, DataType value_dtype);
+
+  // Adds the entries of `keys` and `values`, which have the same shape.
+  Status Add(const Tensor& keys, const Tensor& values);
+
+  // Writes the table to `filename`. Fails if a key was added twice.
+  Status Write(Env* env, const std::string& filename);
+
+ private:
+  // Returns the encoding of element `i` of `t` in a bucket, appending the
+  // bytes of strings to `strings_`.
+  uint64 Encode(const Tensor& t, int64_t i, uint32* size, uint64* hash);
+
+  const DataType key_dtype_;
+  const DataType value_dtype_;
+  std::vector<mmapped_lookup_table::Bucket> entries_;
+  std::string strings_;
+};
+
+// An immutable lookup table served from a file built by
+// MmappedLookupTableBuilder, which is memory-mapped rather than loaded. Tables
+// of a process that use the same file share its mapping, and its pages are
+// only read when looked up. The file must not be modified while in use.
+class MmappedLookupTable : public LookupInterface {
+ public:
+  // Opens the file of the "filename" input of the op of `ctx`.
+  MmappedLookupTable(OpKernelContext* ctx, OpKernel* kernel);
+
+  size_t size() const override;
+
+  Status Find(OpKernelContext* ctx, const Tensor& keys, Tensor* values,
+              const Tensor& default_value) override;
+
+  // Returns errors::Unimplemented.
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override;
+
+  // Returns errors::Unimplemented.
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override;
+
+  Status ExportValues(OpKernelContext* ctx) override;
+
+  // Returns errors::Unimplemented.
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override;
+
+  DataType key_dtype() const override { return key_dtype_; }
+
+  DataType value_dtype() const override { return value_dtype_; }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  // The mapping of the file is not counted, as it is not allocated memory.
+  int64_t MemoryUsed() const override { return sizeof(MmappedLookupTable); }
+
+ private:
+  Status Open(Env* env, const std::string& filename);
+
+  // Sets `*bucket` to the bucket of element `i` of `keys`, or nullptr if it
+  // is not in the table.
+  Status FindBucket(const Tensor& keys, int64_t i,
+                    const mmapped_lookup_table::Bucket** bucket) const;
+
+  // Decodes the value of `bucket` into element `i` of `values`.
+  Status DecodeValue(const mmapped_lookup_table::Bucket& bucket,
+                     Tensor* values, int64_t i) const;
+
+  Status GetString(uint64 offset, uint32 size, StringPiece* s) const;
+
+  DataType key_dtype_;
+  DataType value_dtype_;
+  std::shared_ptr<const ReadOnlyMemoryRegion> region_;
+  const mmapped_lookup_table::Header* header_ = nullptr;
+  const mmapped_lookup_table::Bucket* buckets_ = nullptr;
+  const char* strings_ = nullptr;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MMAPPED_LOOKUP_TABLE_H_
@@ -0,0 +1,175 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mmapped_lookup_table.h"
+
+#include <string>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+class MmappedLookupTableTest : public OpsTestBase {
+ protected:
+  string TablePath(const string& name) {
+    return io::JoinPath(testing::TmpDir(), name);
+  }
+
+  // Opens the table of `filename` with a MmappedHashTable op.
+  Status OpenTable(const string& filename, DataType key_dtype,
+                   DataType value_dtype, LookupInterface** table) {
+    inputs_.clear();
+    TF_RETURN_IF_ERROR(NodeDefBuilder("table", "MmappedHashTable")
+                           .Input(FakeInput(DT_STRING))
+                           .Attr("key_dtype", key_dtype)
+                           .Attr("value_dtype", value_dtype)
+                           .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    AddInputFromArray<tstring>(TensorShape({}), {filename});
+    TF_RETURN_IF_ERROR(RunOpKernel());
+    return LookupResource(context_.get(),
+                          GetOutput(0)->scalar<ResourceHandle>()(), table);
+  }
+};
+
+TEST_F(MmappedLookupTableTest, StringKeys) {
+  const string filename = TablePath("string_keys");
+  MmappedLookupTableBuilder builder(DT_STRING, DT_INT64);
+  TF_ASSERT_OK(builder.Add(test::AsTensor<tstring>({"a", "b", "c"}),
+                           test::AsTensor<int64_t>({0, 1, 2})));
+  TF_ASSERT_OK(builder.Add(test::AsTensor<tstring>({"d"}),
+                           test::AsTensor<int64_t>({3})));
+  TF_ASSERT_OK(builder.Write(Env::Default(), filename));
+
+  LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_STRING, DT_INT64, &table));
+  core::ScopedUnref unref(table);
+  EXPECT_EQ(table->size(), 4);
+  Tensor values(DT_INT64, TensorShape({2, 2}));
+  TF_ASSERT_OK(table->Find(
+      context_.get(),
+      test::AsTensor<tstring>({"b", "z", "d", ""}, TensorShape({2, 2})),
+      &values, test::AsScalar<int64_t>(-1)));
+  test::ExpectTensorEqual<int64_t>(
+      values, test::AsTensor<int64_t>({1, -1, 3, -1}, TensorShape({2, 2})));
+
+  EXPECT_TRUE(errors::IsUnimplemented(
+      table->Insert(context_.get(), test::AsTensor<tstring>({"e"}),
+                    test::AsTensor<int64_t>({4}))));
+}
+
+TEST_F(MmappedLookupTableTest, StringValues) {
+  const string filename = TablePath("string_values");
+  MmappedLookupTableBuilder builder(DT_INT64, DT_STRING);
+  TF_ASSERT_OK(builder.Add(test::AsTensor<int64_t>({10, -20, 30}),
+                           test::AsTensor<tstring>({"x", "", "zz"})));
+  TF_ASSERT_OK(builder.Write(Env::Default(), filename));
+
+  LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_STRING, &table));
+  core::ScopedUnref unref(table);
+  Tensor values(DT_STRING, TensorShape({4}));
+  TF_ASSERT_OK(table->Find(context_.get(),
+                           test::AsTensor<int64_t>({30, 10, 0, -20}), &values,
+                           test::AsScalar<tstring>("?")));
+  test::ExpectTensorEqual<tstring>(
+      values, test::AsTensor<tstring>({"zz", "x", "?", ""}));
+}
+
+TEST_F(MmappedLookupTableTest, EmptyTable) {
+  const string filename = TablePath("empty");
+  MmappedLookupTableBuilder builder(DT_INT64, DT_INT64);
+  TF_ASSERT_OK(builder.Write(Env::Default(), filename));
+
+  LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_INT64, &table));
+  core::ScopedUnref unref(table);
+  EXPECT_EQ(table->size(), 0);
+  Tensor values(DT_INT64, TensorShape({1}));
+  TF_ASSERT_OK(table->Find(context_.get(), test::AsTensor<int64_t>({1}),
+                           &values, test::AsScalar<int64_t>(-1)));
+  test::ExpectTensorEqual<int64_t>(values, test::AsTensor<int64_t>({-1}));
+}
+
+TEST_F(MmappedLookupTableTest, DuplicateKeys) {
+  MmappedLookupTableBuilder builder(DT_STRING, DT_INT64);
+  TF_ASSERT_OK(builder.Add(test::AsTensor<tstring>({"a", "b", "a"}),
+                           test::AsTensor<int64_t>({0, 1, 2})));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      builder.Write(Env::Default(), TablePath("duplicate_keys"))));
+}
+
+TEST_F(MmappedLookupTableTest, RebuiltFile) {
+  const string filename = TablePath("rebuilt");
+  MmappedLookupTableBuilder builder(DT_INT64, DT_INT64);
+  TF_ASSERT_OK(builder.Add(test::AsTensor<int64_t>({1}),
+                           test::AsTensor<int64_t>({10})));
+  TF_ASSERT_OK(builder.Write(Env::Default(), filename));
+  LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_INT64, &table));
+  core::ScopedUnref unref(table);
+
+  // Replaces the file while `table` still maps the previous one.
+  MmappedLookupTableBuilder rebuilder(DT_INT64, DT_INT64);
+  TF_ASSERT_OK(rebuilder.Add(test::AsTensor<int64_t>({1, 2, 3}),
+                             test::AsTensor<int64_t>({11, 12, 13})));
+  TF_ASSERT_OK(rebuilder.Write(Env::Default(), filename + ".tmp"));
+  TF_ASSERT_OK(Env::Default()->RenameFile(filename + ".tmp", filename));
+  LookupInterface* rebuilt_table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_INT64, &rebuilt_table));
+  core::ScopedUnref unref_rebuilt(rebuilt_table);
+
+  EXPECT_EQ(table->size(), 1);
+  EXPECT_EQ(rebuilt_table->size(), 3);
+  Tensor values(DT_INT64, TensorShape({2}));
+  TF_ASSERT_OK(rebuilt_table->Find(context_.get(),
+                                   test::AsTensor<int64_t>({1, 3}), &values,
+                                   test::AsScalar<int64_t>(-1)));
+  test::ExpectTensorEqual<int64_t>(values, test::AsTensor<int64_t>({11, 13}));
+}
+
+TEST_F(MmappedLookupTableTest, InvalidFiles) {
+  const string filename = TablePath("int64_keys");
+  MmappedLookupTableBuilder builder(DT_INT64, DT_INT64);
+  TF_ASSERT_OK(builder.Add(test::AsTensor<int64_t>({1}),
+                           test::AsTensor<int64_t>({2})));
+  TF_ASSERT_OK(builder.Write(Env::Default(), filename));
+  LookupInterface* table;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      OpenTable(filename, DT_STRING, DT_INT64, &table)));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(OpenTable("", DT_INT64, DT_INT64, &table)));
+
+  const string garbage = TablePath("garbage");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), garbage,
+                                 string(sizeof(mmapped_lookup_table::Header),
+                                        'x')));
+  EXPECT_TRUE(errors::IsDataLoss(
+      OpenTable(garbage, DT_INT64, DT_INT64, &table)));
+}
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
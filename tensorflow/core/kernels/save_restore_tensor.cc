@@ -33,6 +33,9 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -250,6 +253,20 @@ namespace {
 // Tensors larger than this threshold will be restored from a thread-pool.
 const int64_t kLargeShapeThreshold = 16 << 20;  // 16M
 
+// Whether full tensors are restored as read-only memory mappings of the
+// checkpoint data files where possible, instead of being copied into new
+// buffers. See BundleReader::LookupMapped().
+bool RestoreMappedTensors() {
+  static const bool restore_mapped = []() {
+    bool value;
+    if (!ReadBoolFromEnvVar("TF_RESTORE_MAPPED_TENSORS", false, &value).ok()) {
+      return false;
+    }
+    return value;
+  }();
+  return restore_mapped;
+}
+
 // A restore operation for a single tensor.  Small tensors may be restored
 // directly from the op thread to improve read locality.  Large tensors can be
 // restored from a thread pool: this requires creating a separate BundleReader
@@ -257,13 +274,14 @@ const int64_t kLargeShapeThreshold = 16 << 20;  // 16M
 struct RestoreOp {
   RestoreOp(OpKernelContext* context, int idx, const string& tensor_name,
             const string& shape_and_slice, const string& reader_prefix,
-            DataType dtype)
+            DataType dtype, const string& checkpoint_fingerprint)
       : context(context),
         idx(idx),
         tensor_name(tensor_name),
         shape_and_slice(shape_and_slice),
         reader_prefix(reader_prefix),
-        dtype(dtype) {}
+        dtype(dtype),
+        checkpoint_fingerprint(checkpoint_fingerprint) {}
 
   // Move-only. It does not make sense to "run()" a copied RestoreOp.
   RestoreOp(const RestoreOp&) = delete;
@@ -272,6 +290,9 @@ struct RestoreOp {
   RestoreOp& operator=(RestoreOp&&) = default;
 
   bool should_run_in_pool(BundleReader* reader) const {
+    // Tensors shared with an earlier restore are not read at all.
+    if (has_shared_tensor()) return false;
+
     TensorShape restored_full_shape;
 
     // Ignore status here; we'll catch the error later.
@@ -293,15 +314,66 @@ struct RestoreOp {
     status = run(&reader);
   }
 
+  // Returns the key of this tensor in the SharedTensorStore, or the empty
+  // string if the checkpoint is not shared.
+  string shared_key() const {
+    if (checkpoint_fingerprint.empty()) return "";
+    return SharedTensorStore::MakeKey(checkpoint_fingerprint, tensor_name,
+                                      shape_and_slice);
+  }
+
+  bool has_shared_tensor() const {
+    return !checkpoint_fingerprint.empty() &&
+           SharedTensorStore::Global()->Contains(shared_key());
+  }
+
+  // Whether this tensor can be read along with others by
+  // BundleReader::LookupMany().
+  bool can_lookup_many() const {
+    return shape_and_slice.empty() && !RestoreMappedTensors();
+  }
+
+  // Sets the output to the tensor from the SharedTensorStore, if it holds it.
+  bool restore_shared() {
+    const string key = shared_key();
+    if (key.empty()) return false;
+    Tensor shared;
+    if (!SharedTensorStore::Global()->Lookup(key, &shared) ||
+        shared.dtype() != dtype) {
+      return false;
+    }
+    VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name
+            << " from the shared tensor store";
+    context->set_output(idx, shared);
+    return true;
+  }
+
+  // Allocates the output for the full tensor, to be read by
+  // BundleReader::LookupMany().
+  Status allocate_full_output(BundleReader* reader, Tensor** restored_tensor) {
+    TF_RETURN_IF_ERROR(
+        reader->LookupTensorShape(tensor_name, &restored_full_shape));
+    VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
+            << restored_full_shape.num_elements();
+    return context->allocate_output(idx, restored_full_shape, restored_tensor);
+  }
+
   Status run(BundleReader* reader) {
-    TensorShape restored_full_shape;
+    if (restore_shared()) return OkStatus();
+
     TF_RETURN_IF_ERROR(
         reader->LookupTensorShape(tensor_name, &restored_full_shape));
 
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    Tensor mapped_tensor;
+    if (shape_and_slice.empty() && RestoreMappedTensors()) {
+      // Lookup the full tensor, aliasing the data file where possible.
+      TF_RETURN_IF_ERROR(reader->LookupMapped(tensor_name, &mapped_tensor));
+      context->set_output(idx, mapped_tensor);
+      restored_tensor = &mapped_tensor;
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -328,6 +400,12 @@ struct RestoreOp {
       TF_RETURN_IF_ERROR(
           reader->LookupSlice(tensor_name, parsed_slice, restored_tensor));
     }
+    finish(restored_tensor);
+    return OkStatus();
+  }
+
+  // Completes the restore once "restored_tensor" has been read.
+  void finish(Tensor* restored_tensor) {
     if (VLOG_IS_ON(5)) {
       if (restored_tensor->dtype() == DT_FLOAT) {
         const float* t_data = restored_tensor->flat<float>().data();
@@ -344,9 +422,16 @@ struct RestoreOp {
                 << restored_tensor->NumElements();
       }
     }
+    const string key = shared_key();
+    if (!key.empty()) {
+      // Another restore may have stored the same tensor concurrently, in which
+      // case its copy is used instead.
+      Tensor shared = *restored_tensor;
+      SharedTensorStore::Global()->Insert(key, &shared);
+      context->set_output(idx, shared);
+    }
     VLOG(1) << "Done restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
-    return OkStatus();
   }
 
   OpKernelContext* context;
@@ -355,6 +440,11 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  // Content fingerprint registered for `reader_prefix` in the
+  // SharedTensorStore, if any.
+  string checkpoint_fingerprint;
+  // Set when the tensor is read.
+  TensorShape restored_full_shape;
 
   ::tensorflow::Status status;
 };
@@ -366,15 +456,21 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& shape_and_slices,
                         gtl::ArraySlice<DataType> dtypes) {
   const string& prefix_string = prefix.scalar<tstring>()();
+  // The checkpoint may still be being written by an asynchronous SaveV2.
+  TF_RETURN_IF_ERROR(AsyncCheckpointWriter::Global()->Wait(prefix_string));
 
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
+  const string checkpoint_fingerprint =
+      SharedTensorStore::Global()->GetCheckpointFingerprint(prefix_string);
+
   std::vector<RestoreOp> restore_ops;
   restore_ops.reserve(tensor_names_flat.size());
   for (int i = 0; i < tensor_names_flat.size(); ++i) {
     restore_ops.push_back({context, i, tensor_names_flat(i),
-                           shape_and_slices_flat(i), prefix_string, dtypes[i]});
+                           shape_and_slices_flat(i), prefix_string, dtypes[i],
+                           checkpoint_fingerprint});
   }
 
   BundleReader default_reader(Env::Default(), prefix_string);
@@ -424,9 +520,34 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
       }
     }
 
-    // Read small tensors from the op thread
+    // Read small tensors from the op thread, reading and checksumming full
+    // tensors concurrently on the worker threads.
+    thread::ThreadPool* workers =
+        context->device()->tensorflow_cpu_worker_threads() != nullptr
+            ? context->device()->tensorflow_cpu_worker_threads()->workers
+            : nullptr;
+    std::vector<RestoreOp*> lookup_many_ops;
+    std::vector<string> lookup_many_keys;
+    std::vector<Tensor*> lookup_many_tensors;
     for (auto* op : direct_restore_ops) {
-      TF_RETURN_IF_ERROR(op->run(&default_reader));
+      if (workers == nullptr || !op->can_lookup_many()) {
+        TF_RETURN_IF_ERROR(op->run(&default_reader));
+        continue;
+      }
+      if (op->restore_shared()) continue;
+      Tensor* restored_tensor;
+      TF_RETURN_IF_ERROR(
+          op->allocate_full_output(&default_reader, &restored_tensor));
+      lookup_many_ops.push_back(op);
+      lookup_many_keys.push_back(op->tensor_name);
+      lookup_many_tensors.push_back(restored_tensor);
+    }
+    if (!lookup_many_ops.empty()) {
+      TF_RETURN_IF_ERROR(default_reader.LookupMany(
+          lookup_many_keys, lookup_many_tensors, workers));
+      for (int i = 0; i < lookup_many_ops.size(); ++i) {
+        lookup_many_ops[i]->finish(lookup_many_tensors[i]);
+      }
     }
   }
 
@@ -15,8 +15,11 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
 #include <cstddef>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -28,12 +31,18 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/checkpoint_callback_manager.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"  // IWYU pragma: keep
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -90,12 +99,193 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// The tensors saved by one SaveV2 op.
+struct TensorsToSave {
+  std::vector<string> names;
+  std::vector<string> shape_and_slices;
+  std::vector<Tensor> tensors;
+};
+
+// Adds the tensor at "index" in "to_save" to "writer".
+Status AddTensor(const TensorsToSave& to_save, int index,
+                 BundleWriter* writer) {
+  const string& tensor_name = to_save.names[index];
+  const string& shape_spec = to_save.shape_and_slices[index];
+  const Tensor& tensor = to_save.tensors[index];
+  VLOG(2) << "Starting save of " << tensor_name;
+
+  if (!shape_spec.empty()) {
+    TensorShape shape;
+    TensorSlice slice(tensor.dims());
+    TensorShape slice_shape;
+
+    TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(shape_spec, &shape,
+                                                      &slice, &slice_shape));
+    if (!slice_shape.IsSameSize(tensor.shape())) {
+      return errors::InvalidArgument(
+          "Slice in shape_and_slice "
+          "specification does not match the "
+          "shape of the tensor to  save: ",
+          shape_spec, ", tensor: ", tensor.shape().DebugString());
+    }
+
+    TF_RETURN_IF_ERROR(writer->AddSlice(tensor_name, shape, slice, tensor));
+  } else {
+    TF_RETURN_IF_ERROR(writer->Add(tensor_name, tensor));
+  }
+
+  if (VLOG_IS_ON(5)) {
+    if (tensor.dtype() == DT_FLOAT) {
+      const float* t_data = tensor.flat<float>().data();
+      float min = std::numeric_limits<float>::infinity();
+      float max = -std::numeric_limits<float>::infinity();
+      double avg = 0.0;
+      for (int i = 0; i < tensor.NumElements(); ++i) {
+        if (t_data[i] < min) min = t_data[i];
+        if (t_data[i] > max) max = t_data[i];
+        avg += t_data[i];
+      }
+      VLOG(5) << " min " << min << " max " << max << " avg "
+              << avg / tensor.NumElements() << " total elts "
+              << tensor.NumElements();
+    }
+  }
+
+  VLOG(2) << "Done save of " << tensor_name;
+  return OkStatus();
+}
+
+// Returns the threads that run the BundleWriters of concurrent saves, shared
+// by all SaveV2 ops. The writers of saves with more writers than threads are
+// queued.
+thread::ThreadPool* SaveThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "save_tensors", std::max(port::MaxParallelism(), 2));
+  return pool;
+}
+
+// Saves "to_save" with "num_writers" BundleWriters, each writing and
+// checksumming its share of the tensors into a temporary bundle from its own
+// thread, and merges the temporary bundles into a single bundle at "prefix"
+// with one data file per writer. The temporary bundles are deleted if the
+// save fails.
+Status SaveConcurrently(const TensorsToSave& to_save, const string& prefix,
+                        const BundleWriter::Options& options,
+                        int num_writers) {
+  Env* env = Env::Default();
+  const int num_tensors = to_save.tensors.size();
+
+  // Balances the bytes written by each writer, largest tensors first.
+  std::vector<int> order(num_tensors);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&to_save](int a, int b) {
+    return to_save.tensors[a].TotalBytes() > to_save.tensors[b].TotalBytes();
+  });
+  std::vector<std::vector<int>> writer_tensors(num_writers);
+  std::vector<int64_t> writer_bytes(num_writers, 0);
+  for (int i : order) {
+    const int writer =
+        std::min_element(writer_bytes.begin(), writer_bytes.end()) -
+        writer_bytes.begin();
+    writer_tensors[writer].push_back(i);
+    writer_bytes[writer] += to_save.tensors[i].TotalBytes();
+  }
+
+  std::vector<tstring> writer_prefixes(num_writers);
+  std::vector<Status> statuses(num_writers);
+  BlockingCounter writers_done(num_writers);
+  for (int w = 0; w < num_writers; ++w) {
+    writer_prefixes[w] =
+        strings::StrCat(prefix, "_temp_part-", w, "-of-", num_writers);
+    SaveThreadPool()->Schedule([env, &to_save, &options, &writer_prefixes,
+                                &writer_tensors, &statuses, &writers_done,
+                                w]() {
+      BundleWriter writer(env, writer_prefixes[w], options);
+      Status status = writer.status();
+      for (int i : writer_tensors[w]) {
+        if (!status.ok()) break;
+        status = AddTensor(to_save, i, &writer);
+      }
+      // Finish() also deletes the data file of a failed writer.
+      status.Update(writer.Finish());
+      statuses[w] = status;
+      writers_done.DecrementCount();
+    });
+  }
+  writers_done.Wait();
+
+  Status status;
+  for (const Status& writer_status : statuses) {
+    status.Update(writer_status);
+  }
+  if (status.ok()) {
+    VLOG(1) << "Merging " << num_writers << " bundles into " << prefix;
+    status = MergeBundles(env, writer_prefixes, prefix);
+  }
+  if (!status.ok()) {
+    // Best effort: a failed merge may already have renamed some data files.
+    for (const tstring& writer_prefix : writer_prefixes) {
+      env->DeleteFile(MetaFilename(writer_prefix)).IgnoreError();
+      env->DeleteFile(DataFilename(writer_prefix, 0, 1)).IgnoreError();
+    }
+  }
+  return status;
+}
+
+// Saves "to_save" as a bundle at "prefix", with up to "save_threads"
+// concurrent BundleWriters.
+Status SaveTensors(const TensorsToSave& to_save, const string& prefix,
+                   const BundleWriter::Options& options, int save_threads) {
+  const int num_tensors = to_save.tensors.size();
+  const int num_writers = std::min(save_threads, num_tensors);
+  if (num_writers > 1) {
+    return SaveConcurrently(to_save, prefix, options, num_writers);
+  }
+
+  BundleWriter writer(Env::Default(), prefix, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (int i = 0; i < num_tensors; ++i) {
+    TF_RETURN_IF_ERROR(AddTensor(to_save, i, &writer));
+  }
+  TF_RETURN_IF_ERROR(writer.Finish());
+  VLOG(1) << "Done BundleWriter, prefix_string: " << prefix;
+  return OkStatus();
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    // Aligning tensor data lets restores map it instead of copying it.
+    int64_t data_alignment;
+    OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_CHECKPOINT_DATA_ALIGNMENT",
+                                                1, &data_alignment));
+    OP_REQUIRES(context, data_alignment >= 1,
+                errors::InvalidArgument(
+                    "TF_CHECKPOINT_DATA_ALIGNMENT must be positive, got ",
+                    data_alignment));
+    writer_options_.data_alignment = static_cast<int>(data_alignment);
+
+    // Splitting large saves over several writers, and thus data files,
+    // parallelizes writing and checksumming them.
+    int64_t save_threads;
+    OP_REQUIRES_OK(context, ReadInt64FromEnvVar("TF_CHECKPOINT_SAVE_THREADS",
+                                                1, &save_threads));
+    OP_REQUIRES(context, save_threads >= 1,
+                errors::InvalidArgument(
+                    "TF_CHECKPOINT_SAVE_THREADS must be positive, got ",
+                    save_threads));
+    save_threads_ = static_cast<int>(save_threads);
+
+    // In async mode the op only snapshots the tensors, and the checkpoint is
+    // written by the AsyncCheckpointWriter.
+    OP_REQUIRES_OK(context, ReadBoolFromEnvVar("TF_CHECKPOINT_ASYNC_SAVE",
+                                               false, &async_save_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -111,57 +301,35 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    auto to_save = std::make_shared<TensorsToSave>();
+    to_save->names.reserve(num_tensors);
+    to_save->shape_and_slices.reserve(num_tensors);
+    to_save->tensors.reserve(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-      VLOG(2) << "Starting save of " << tensor_name;
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
-
-      if (VLOG_IS_ON(5)) {
-        if (tensor.dtype() == DT_FLOAT) {
-          const float* t_data = tensor.flat<float>().data();
-          float min = std::numeric_limits<float>::infinity();
-          float max = -std::numeric_limits<float>::infinity();
-          double avg = 0.0;
-          for (int i = 0; i < tensor.NumElements(); ++i) {
-            if (t_data[i] < min) min = t_data[i];
-            if (t_data[i] > max) max = t_data[i];
-            avg += t_data[i];
-          }
-          VLOG(5) << " min " << min << " max " << max << " avg "
-                  << avg / tensor.NumElements() << " total elts "
-                  << tensor.NumElements();
-        }
-      }
+      to_save->names.push_back(tensor_names_flat(i));
+      to_save->shape_and_slices.push_back(shape_and_slices_flat(i));
+      to_save->tensors.push_back(context->input(i + kFixedInputs));
+    }
 
-      VLOG(2) << "Done save of " << tensor_name;
+    if (async_save_) {
+      // The inputs may alias variables that are updated in place by the next
+      // steps, so the checkpoint is written from a snapshot. It is a full
+      // copy, since reference variables are not copied on write, and costs up
+      // to the size of the checkpoint in host memory per pending save.
+      to_save->tensors = AsyncCheckpointWriter::Snapshot(to_save->tensors);
+      const BundleWriter::Options options = writer_options_;
+      const int save_threads = save_threads_;
+      OP_REQUIRES_OK(context,
+                     AsyncCheckpointWriter::Global()->Schedule(
+                         prefix_string,
+                         [to_save, prefix_string, options, save_threads]() {
+                           return SaveTensors(*to_save, prefix_string, options,
+                                              save_threads);
+                         }));
+    } else {
+      OP_REQUIRES_OK(context, SaveTensors(*to_save, prefix_string,
+                                          writer_options_, save_threads_));
     }
-    OP_REQUIRES_OK(context, writer.Finish());
-    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
 
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
@@ -182,6 +350,12 @@ class SaveV2 : public OpKernel {
       checkpoint_callback_manager->Unref();
     }
   }
+
+ private:
+  BundleWriter::Options writer_options_;
+  // Number of BundleWriters saving tensors concurrently.
+  int save_threads_;
+  bool async_save_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -205,6 +379,10 @@ class RestoreV2 : public OpKernel {
     if (!context->status().ok()) return;
 
     const string& prefix_string = prefix.scalar<tstring>()();
+    // Until an asynchronous SaveV2 has written the checkpoint, its metadata
+    // file is missing and the checkpoint would be mistaken for a V1 one.
+    OP_REQUIRES_OK(context,
+                   AsyncCheckpointWriter::Global()->Wait(prefix_string));
 
     VLOG(2) << "Started Restore at prefix: " << prefix_string;
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
@@ -285,13 +463,42 @@ class MergeV2Checkpoints : public OpKernel {
 
     const gtl::ArraySlice<tstring> input_prefixes =
         gtl::ArraySlice<tstring>(checkpoint_prefixes.flat<tstring>());
-    Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<tstring>()();
-    OP_REQUIRES_OK(context,
-                   tensorflow::MergeBundles(env, input_prefixes, merged_prefix,
-                                            allow_missing_files_));
 
-    if (delete_old_dirs_) {
+    // Merges checkpoints still being written asynchronously once they are
+    // written, without blocking.
+    AsyncCheckpointWriter* async_writer = AsyncCheckpointWriter::Global();
+    if (std::any_of(input_prefixes.begin(), input_prefixes.end(),
+                    [async_writer](const tstring& input_prefix) {
+                      return async_writer->IsPending(input_prefix);
+                    })) {
+      std::vector<tstring> prefixes(input_prefixes.begin(),
+                                    input_prefixes.end());
+      const bool allow_missing_files = allow_missing_files_;
+      const bool delete_old_dirs = delete_old_dirs_;
+      OP_REQUIRES_OK(
+          context,
+          async_writer->Schedule(merged_prefix, [prefixes, merged_prefix,
+                                                 allow_missing_files,
+                                                 delete_old_dirs]() {
+            return Merge(prefixes, merged_prefix, allow_missing_files,
+                         delete_old_dirs);
+          }));
+      return;
+    }
+    OP_REQUIRES_OK(context, Merge(input_prefixes, merged_prefix,
+                                  allow_missing_files_, delete_old_dirs_));
+  }
+
+ private:
+  static Status Merge(gtl::ArraySlice<tstring> input_prefixes,
+                      const string& merged_prefix, bool allow_missing_files,
+                      bool delete_old_dirs) {
+    Env* env = Env::Default();
+    TF_RETURN_IF_ERROR(tensorflow::MergeBundles(
+        env, input_prefixes, merged_prefix, allow_missing_files));
+
+    if (delete_old_dirs) {
       const string merged_dir(io::Dirname(merged_prefix));
       for (const string& input_prefix : input_prefixes) {
         const string dirname(io::Dirname(input_prefix));
@@ -302,9 +509,9 @@ class MergeV2Checkpoints : public OpKernel {
         if (!status.ok()) VLOG(1) << status;
       }
     }
+    return OkStatus();
   }
 
- private:
   // On merge, whether or not to delete the input (temporary) directories.
   bool delete_old_dirs_;
 
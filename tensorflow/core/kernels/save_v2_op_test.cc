@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <complex>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
@@ -26,9 +27,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -340,5 +343,74 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+// Saves with TF_CHECKPOINT_SAVE_THREADS > 1, i.e. with several BundleWriters.
+class ConcurrentSaveV2OpTest : public OpsTestBase {
+ protected:
+  void SetUp() override {
+    setenv("TF_CHECKPOINT_SAVE_THREADS", "3", 1 /* replace */);
+  }
+  void TearDown() override { unsetenv("TF_CHECKPOINT_SAVE_THREADS"); }
+
+  // Saves four float tensors "tensor_<i>" of shape {i + 1} at "prefix".
+  Status Save(const string& prefix,
+              const std::vector<tstring>& shape_and_slices) {
+    TF_CHECK_OK(NodeDefBuilder("myop", "SaveV2")
+                    .Input(FakeInput())             // prefix
+                    .Input(FakeInput())             // tensor_names
+                    .Input(FakeInput())             // shape_and_slices
+                    .Input(FakeInput(4, DT_FLOAT))  // tensors
+                    .Finalize(node_def()));
+    TF_CHECK_OK(InitOp());
+    AddInput<tstring>(TensorShape({}),
+                      [&prefix](int x) -> tstring { return prefix; });
+    AddInput<tstring>(TensorShape({4}), [](int x) -> tstring {
+      return strings::StrCat("tensor_", x);
+    });
+    AddInput<tstring>(TensorShape({4}), [&shape_and_slices](int x) {
+      return shape_and_slices[x];
+    });
+    for (int i = 0; i < 4; ++i) {
+      AddInput<float>(TensorShape({i + 1}),
+                      [i](int x) -> float { return i * 10 + x; });
+    }
+    return RunOpKernel();
+  }
+
+  // Returns the files whose name starts with "prefix".
+  std::vector<string> FilesWithPrefix(const string& prefix) {
+    std::vector<string> paths;
+    TF_CHECK_OK(
+        Env::Default()->GetMatchingPaths(strings::StrCat(prefix, "*"), &paths));
+    return paths;
+  }
+};
+
+TEST_F(ConcurrentSaveV2OpTest, WritesOneDataFilePerWriter) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "concurrent_save");
+  TF_ASSERT_OK(Save(prefix, {"", "", "", ""}));
+
+  TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, 2, 3)));
+  EXPECT_TRUE(FilesWithPrefix(strings::StrCat(prefix, "_temp_part")).empty());
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  for (int i = 0; i < 4; ++i) {
+    Tensor val;
+    TF_ASSERT_OK(reader.Lookup(strings::StrCat("tensor_", i), &val));
+    ASSERT_EQ(val.NumElements(), i + 1);
+    for (int x = 0; x <= i; ++x) {
+      EXPECT_EQ(val.flat<float>()(x), i * 10 + x);
+    }
+  }
+}
+
+TEST_F(ConcurrentSaveV2OpTest, FailedSaveLeavesNoFiles) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "failed_save");
+  // The slice of "tensor_1" does not match its shape.
+  const Status status = Save(prefix, {"", "5 0,3", "", ""});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+
+  EXPECT_TRUE(FilesWithPrefix(prefix).empty());
+}
+
 }  // namespace
 }  // namespace tensorflow
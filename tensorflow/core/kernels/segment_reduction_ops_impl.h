@@ -18,7 +18,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 #define TENSORFLOW_CORE_KERNELS_SEGMENT_REDUCTION_OPS_IMPL_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include "tensorflow/core/framework/op_requires.h"
 #include "tensorflow/core/platform/types.h"
@@ -41,8 +43,11 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -390,8 +395,29 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     // Nothing to reduce. All output values equal to `InitialValueF()`.
     if (num_reductions == 0) return;
 
-    // Parallelize by `num_segments`. It's simple, efficient and safe
-    // (no data dependency):
+    // Reduction functors includes Sum, Max, Min, etc. Simply consider it
+    // will cost 5 cycles per operation.
+    const Eigen::TensorOpCost row_cost(sizeof(T) * inner_dim,
+                                       sizeof(T) * inner_dim, 5 * inner_dim);
+    const int64_t num_threads = cpu_device.numThreads();
+
+    // With many rows per segment, e.g. the gradient of a small embedding
+    // table, reduce blocks of rows into partial outputs in parallel and merge
+    // them. The result then depends on the number of threads, so this is not
+    // done when determinism is required.
+    const int64_t num_partials =
+        std::min(num_threads, num_real_segment / kMinRowsPerPartial);
+    if (num_partials > 1 && num_segments * num_partials <= N / 2 &&
+        !OpDeterminismRequired()) {
+      ReduceIntoPartials(ctx, segment_ids, data, output, row_counter,
+                         num_partials, row_cost);
+      return;
+    }
+
+    // Otherwise parallelize by `num_segments`, which is simple, efficient and
+    // safe (no data dependency). The rows of each segment are grouped in
+    // their original order, and segments are split into blocks with about
+    // the same number of rows:
     //
     //   input   segment_ids                 num_segments  operation
     //   | a0 |  | 0 |            worker 1:  |0|           f(a0, a1)
@@ -399,27 +425,105 @@ struct UnsortedSegmentFunctor<CPUDevice, T, Index, InitialValueF, ReductionF> {
     // N | c0 |  | 2 |       -->  worker 3:  |2|           f(c0)
     //   | b1 |  | 1 |
     //   | a1 |  | 0 |
-    //
-    // TODO(intel-tf): Balance workload in `row_counter` to make parallelism
-    //                 more efficient.
-    auto reductionWorker = [&](int64_t begin, int64_t end) -> void {
-      for (int64_t i = 0; i < N; i++) {
+    std::vector<int64_t> offsets(num_segments + 1, 0);
+    for (int64_t j = 0; j < num_segments; ++j) {
+      offsets[j + 1] = offsets[j] + row_counter[j];
+    }
+    std::vector<int64_t> rows(num_real_segment);
+    {
+      std::vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+      for (int64_t i = 0; i < N; ++i) {
         Index j = internal::SubtleMustCopy(segment_ids(i));
-        // If `j` is in work scope of this worker, do the reduction.
-        if (j >= begin && j < end) {
-          reduction(data.template chip<0>(i), output.template chip<0>(j));
+        if (FastBoundsCheck(j, num_segments) && next[j] < offsets[j + 1]) {
+          rows[next[j]++] = i;
+        }
+      }
+    }
+
+    const int64_t num_blocks = std::min(num_segments, 4 * num_threads);
+    auto block_start = [&](int64_t block) -> int64_t {
+      if (block == num_blocks) return num_segments;
+      return std::lower_bound(offsets.begin(), offsets.end() - 1,
+                              block * num_real_segment / num_blocks) -
+             offsets.begin();
+    };
+    auto reductionWorker = [&](int64_t begin, int64_t end) -> void {
+      const int64_t segment_end = block_start(end);
+      for (int64_t j = block_start(begin); j < segment_end; ++j) {
+        for (int64_t k = offsets[j]; k < offsets[j + 1]; ++k) {
+          reduction(data.template chip<0>(rows[k]),
+                    output.template chip<0>(j));
         }
       }
     };
+    cpu_device.parallelFor(
+        num_blocks,
+        row_cost * (static_cast<double>(num_real_segment) / num_blocks),
+        reductionWorker);
+  }
 
-    // Reduction functors includes Sum, Max, Min, etc. Simply consider it
-    // will cost 5 cycles per operation.
-    const int64_t kAverTaskSize = num_real_segment / num_segments;
-    const int64_t compute_cycles = 5 * inner_dim * kAverTaskSize;
-    const int64_t input_bytes = sizeof(T) * inner_dim * kAverTaskSize;
-    const int64_t output_bytes = sizeof(T) * inner_dim * kAverTaskSize;
-    const Eigen::TensorOpCost cost(input_bytes, output_bytes, compute_cycles);
-    cpu_device.parallelFor(num_segments, cost, reductionWorker);
+ private:
+  // Minimum number of rows reduced into each partial output.
+  static constexpr int64_t kMinRowsPerPartial = 1024;
+
+  // Reduces `num_partials` blocks of rows in parallel, the first one into
+  // `output` and the others into temporary outputs, then merges the temporary
+  // outputs into `output` in order.
+  void ReduceIntoPartials(OpKernelContext* ctx,
+                          typename TTypes<Index>::ConstFlat segment_ids,
+                          typename TTypes<T, 2>::ConstTensor data,
+                          typename TTypes<T, 2>::Tensor output,
+                          const std::vector<Index>& row_counter,
+                          int64_t num_partials,
+                          const Eigen::TensorOpCost& row_cost) {
+    auto cpu_device = ctx->eigen_cpu_device();
+    const int64_t N = segment_ids.dimension(0);
+    const int64_t num_segments = output.dimension(0);
+    const int64_t inner_dim = data.dimension(1);
+    ReductionF reduction;
+
+    Tensor partials_t;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(
+                 DataTypeToEnum<T>::value,
+                 TensorShape({(num_partials - 1) * num_segments, inner_dim}),
+                 &partials_t));
+    auto partials = partials_t.tensor<T, 2>();
+    partials.device(cpu_device) = partials.constant(InitialValueF()());
+
+    auto partialWorker = [&](int64_t begin, int64_t end) -> void {
+      for (int64_t p = begin; p < end; ++p) {
+        const int64_t row_end = (p + 1) * N / num_partials;
+        for (int64_t i = p * N / num_partials; i < row_end; ++i) {
+          Index j = internal::SubtleMustCopy(segment_ids(i));
+          if (!FastBoundsCheck(j, num_segments)) continue;
+          if (p == 0) {
+            reduction(data.template chip<0>(i), output.template chip<0>(j));
+          } else {
+            reduction(data.template chip<0>(i),
+                      partials.template chip<0>((p - 1) * num_segments + j));
+          }
+        }
+      }
+    };
+    cpu_device.parallelFor(
+        num_partials, row_cost * (static_cast<double>(N) / num_partials),
+        partialWorker);
+
+    const Tensor& const_partials_t = partials_t;
+    auto merged_partials = const_partials_t.tensor<T, 2>();
+    auto mergeWorker = [&](int64_t begin, int64_t end) -> void {
+      for (int64_t j = begin; j < end; ++j) {
+        if (row_counter[j] == 0) continue;
+        for (int64_t p = 1; p < num_partials; ++p) {
+          reduction(
+              merged_partials.template chip<0>((p - 1) * num_segments + j),
+              output.template chip<0>(j));
+        }
+      }
+    };
+    cpu_device.parallelFor(num_segments, row_cost * (num_partials - 1),
+                           mergeWorker);
   }
 };
 
@@ -597,61 +701,78 @@ class SparseSegmentReductionOpBase : public OpKernel {
     }
     auto temp_flat = temp.flat_outer_dims<float>();
 
-    int64_t start = 0, end = 1;
-    // Index from which the output is not initialized.
-    SegmentId uninitialized_index = 0;
-    SegmentId out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    while (true) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      SegmentId next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
-        }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
+    // Split the indices into runs of equal segment ids, verifying that the
+    // segment ids are increasing and in range.
+    std::vector<int64_t> run_starts;
+    std::vector<SegmentId> run_segments;
+    for (int64_t i = 0; i < num_indices; ++i) {
+      const SegmentId segment = internal::SubtleMustCopy(segment_vec(i));
+      if (!run_segments.empty()) {
+        if (segment == run_segments.back()) continue;
+        OP_REQUIRES(context, run_segments.back() < segment,
                     errors::InvalidArgument("segment ids are not increasing"));
       }
-
       OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
+          context, FastBoundsCheck(segment, output_rows),
           errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
+              "Segment id ", segment, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
+      run_starts.push_back(i);
+      run_segments.push_back(segment);
+    }
+    const int64_t num_runs = run_starts.size();
+    run_starts.push_back(num_indices);
+
+    // Each run is reduced into its own output row, so runs are reduced in
+    // parallel. The position of the first out of range index is reported.
+    mutex mu;
+    int64_t bad_position = num_indices;
+    auto reduce_runs = [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; ++r) {
+        const int64_t start = run_starts[r];
+        const int64_t next_start = run_starts[r + 1];
+        // Fill the gap between the previous segment and this one with the
+        // default value.
+        const SegmentId gap_start = r == 0 ? 0 : run_segments[r - 1] + 1;
+        if (run_segments[r] > gap_start) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              run_segments[r] - gap_start, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(gap_start, 0), gap_slice_shape);
+          gap_slice.setConstant(default_value_);
+        }
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
+        // Start loading the first rows of the next segment, which are usually
+        // scattered over a large embedding table, while this one is reduced.
+        PrefetchRows<T, Index>(input_flat, indices_vec, next_start,
+                               std::min(next_start + kPrefetchRows,
+                                        num_indices));
+
+        auto out = output_flat.template chip<0>(run_segments[r]);
+        auto temp = temp_flat.template chip<0>(run_segments[r]);
+        const int64_t bad_offset = Reduce<T, Index>(
+            input_flat, indices_vec, start, next_start - start, out, temp);
+        if (bad_offset >= 0) {
+          mutex_lock l(mu);
+          bad_position = std::min(bad_position, start + bad_offset);
+          return;
+        }
       }
-
-      auto out = output_flat.template chip<0>(out_index);
-      auto temp = temp_flat.template chip<0>(out_index);
-      const int bad_offset = Reduce<T, Index>(input_flat, indices_vec, start,
-                                              end - start, out, temp);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset,
-                      "] == ", indices_vec(start + bad_offset),
-                      " out of range [0, ", input_flat.dimension(0), ")"));
-
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
-      if (end > num_indices) break;
-    }
+    };
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_runs,
+          std::max<int64_t>(num_indices / num_runs, 1) * num_col * 5,
+          reduce_runs);
+    OP_REQUIRES(context, bad_position == num_indices,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_position,
+                    "] == ", indices_vec(bad_position), " out of range [0, ",
+                    input_flat.dimension(0), ")"));
 
     // Fill the gap at the end with the default value.
+    const SegmentId uninitialized_index = run_segments.back() + 1;
     if (uninitialized_index < output_rows) {
       Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
           output_rows - uninitialized_index, num_col);
@@ -662,6 +783,28 @@ class SparseSegmentReductionOpBase : public OpKernel {
   }
 
  private:
+  // Number of rows read ahead of the ones being reduced.
+  static constexpr int64_t kPrefetchRows = 8;
+
+  // Prefetches the rows of `input_flat` at `indices_vec[begin:end]`, skipping
+  // the out of range indices, which are reported by Reduce().
+  template <typename Tin, typename Tindex>
+  EIGEN_ALWAYS_INLINE void PrefetchRows(
+      const typename TTypes<Tin>::ConstMatrix& input_flat,
+      const typename TTypes<Tindex>::ConstVec& indices_vec, int64_t begin,
+      int64_t end) {
+    constexpr int64_t kCacheLineSize = 64;
+    const int64_t row_bytes = input_flat.dimension(1) * sizeof(Tin);
+    for (int64_t i = begin; i < end; ++i) {
+      const Tindex index = indices_vec(i);
+      if (!FastBoundsCheck(index, input_flat.dimension(0))) continue;
+      const char* row = reinterpret_cast<const char*>(&input_flat(index, 0));
+      for (int64_t offset = 0; offset < row_bytes; offset += kCacheLineSize) {
+        port::prefetch<port::PREFETCH_HINT_T0>(row + offset);
+      }
+    }
+  }
+
   const DataType dtidx_;
   template <typename Tin>
   using EnableIfBfloat16OrHalf =
@@ -823,6 +966,8 @@ class SparseSegmentReductionOpBase : public OpKernel {
         }
       }
       for (; r < num; r += 8) {
+        PrefetchRows<Tin, Tindex>(input_flat, indices_vec, start + r + 8,
+                                  start + std::min(r + 16, num));
         INDEX(0, r);
         INDEX(1, r + 1);
         INDEX(2, r + 2);
@@ -16,6 +16,7 @@ limitations under the License.
 #include <functional>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session_options.h"
@@ -38,6 +40,105 @@ limitations under the License.
 
 namespace tensorflow {
 
+class SegmentReductionOpTest : public OpsTestBase {
+ protected:
+  // Data of `num_rows` rows of `num_cols` small integers, whose sums do not
+  // depend on the order of the additions.
+  static std::vector<float> Data(int num_rows, int num_cols) {
+    std::vector<float> data(num_rows * num_cols);
+    for (int i = 0; i < data.size(); ++i) data[i] = i % 7 - 3;
+    return data;
+  }
+
+  void RunUnsortedSegmentSum(int num_rows, int num_cols, int num_segments) {
+    TF_ASSERT_OK(NodeDefBuilder("sum", "UnsortedSegmentSum")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const std::vector<float> data = Data(num_rows, num_cols);
+    std::vector<int32> segment_ids(num_rows);
+    Tensor expected(DT_FLOAT, TensorShape({num_segments, num_cols}));
+    auto expected_matrix = expected.matrix<float>();
+    expected_matrix.setZero();
+    for (int i = 0; i < num_rows; ++i) {
+      // Skewed, with some dropped rows.
+      segment_ids[i] = (i * i) % (num_segments + 1) - 1;
+      for (int j = 0; j < num_cols && segment_ids[i] >= 0; ++j) {
+        expected_matrix(segment_ids[i], j) += data[i * num_cols + j];
+      }
+    }
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), data);
+    AddInputFromArray<int32>(TensorShape({num_rows}), segment_ids);
+    AddInputFromArray<int32>(TensorShape({}), {num_segments});
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorEqual<float>(*GetOutput(0), expected);
+  }
+
+  Status RunSparseSegmentSum(int num_rows, int num_cols,
+                             const std::vector<int32>& indices,
+                             const std::vector<int32>& segment_ids) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("sum", "SparseSegmentSum")
+                           .Input(FakeInput(DT_FLOAT))
+                           .Input(FakeInput(DT_INT32))
+                           .Input(FakeInput(DT_INT32))
+                           .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}),
+                             Data(num_rows, num_cols));
+    AddInputFromArray<int32>(TensorShape({static_cast<int>(indices.size())}),
+                             indices);
+    AddInputFromArray<int32>(
+        TensorShape({static_cast<int>(segment_ids.size())}), segment_ids);
+    return RunOpKernel();
+  }
+};
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumFewSegments) {
+  RunUnsortedSegmentSum(1 << 16, 4, 8);
+}
+
+TEST_F(SegmentReductionOpTest, UnsortedSegmentSumManySegments) {
+  RunUnsortedSegmentSum(1 << 16, 4, 10000);
+}
+
+TEST_F(SegmentReductionOpTest, SparseSegmentSum) {
+  constexpr int kNumRows = 1000;
+  constexpr int kNumCols = 16;
+  std::vector<int32> indices;
+  std::vector<int32> segment_ids;
+  for (int i = 0; i < 1 << 15; ++i) {
+    indices.push_back(i * 31 % kNumRows);
+    // Segments of 1 to 9 indices, with empty segments in between.
+    segment_ids.push_back(i / 5 * 2 + i % 5 / 4);
+  }
+  TF_ASSERT_OK(RunSparseSegmentSum(kNumRows, kNumCols, indices, segment_ids));
+
+  const int num_segments = segment_ids.back() + 1;
+  const std::vector<float> data = Data(kNumRows, kNumCols);
+  Tensor expected(DT_FLOAT, TensorShape({num_segments, kNumCols}));
+  auto expected_matrix = expected.matrix<float>();
+  expected_matrix.setZero();
+  for (int i = 0; i < indices.size(); ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      expected_matrix(segment_ids[i], j) += data[indices[i] * kNumCols + j];
+    }
+  }
+  test::ExpectTensorEqual<float>(*GetOutput(0), expected);
+}
+
+TEST_F(SegmentReductionOpTest, SparseSegmentSumBadIndex) {
+  std::vector<int32> indices(1 << 12, 0);
+  std::vector<int32> segment_ids(indices.size());
+  for (int i = 0; i < segment_ids.size(); ++i) segment_ids[i] = i / 3;
+  indices[2000] = 10;
+  indices[3000] = 10;
+  Status status = RunSparseSegmentSum(10, 4, indices, segment_ids);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "indices[2000] == 10"));
+}
+
 static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
                                         const string& reduction, int num_rows,
                                         int num_cols, int segment_size) {
@@ -105,6 +206,9 @@ static void BM_UnsortedSegmentReduction(::testing::benchmark::State& state,
 
 BM_UnsortedReduce_Arg(4096, 1024, 1);
 BM_UnsortedReduce_Arg(4096, 1024, 128);
+// Gradients of embedding lookups, into small and large tables.
+BM_UnsortedReduce_Arg(65536, 64, 64);
+BM_UnsortedReduce_Arg(65536, 64, 16384);
 
 template <typename Index>
 static void BM_SegmentReduction(::testing::benchmark::State& state,
@@ -181,6 +285,43 @@ BM_Reduce_Arg(64, 32, 2);
 BM_Reduce_Arg(4096, 32, 2);
 BM_Reduce_Arg(4096, 128, 2);
 
+// Embedding lookups of `num_indices` ids in a [100000, 64] table, combined
+// in segments of `segment_size`.
+static void BM_SparseSegmentSum(::testing::benchmark::State& state) {
+  const int num_indices = state.range(0);
+  const int segment_size = state.range(1);
+  constexpr int kNumRows = 100000;
+  constexpr int kNumCols = 64;
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({kNumRows, kNumCols}));
+  input.flat<float>().setRandom();
+  Tensor indices(DT_INT32, TensorShape({num_indices}));
+  test::FillFn<int32>(&indices,
+                      [](int i) -> int32 { return (i * 7919) % kNumRows; });
+  Tensor segment_ids(DT_INT32, TensorShape({num_indices}));
+  test::FillFn<int32>(&segment_ids, [segment_size](int i) -> int32 {
+    return i / segment_size;
+  });
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_indices * kNumCols * sizeof(float));
+}
+
+BENCHMARK(BM_SparseSegmentSum)
+    ->UseRealTime()
+    ->ArgPair(1 << 16, 1)
+    ->ArgPair(1 << 16, 16)
+    ->ArgPair(1 << 16, 256);
+
 template <DataType T>
 static void SparseSegmentMeanGradHelper(::testing::benchmark::State& state,
                                         float uniqueness, int size) {
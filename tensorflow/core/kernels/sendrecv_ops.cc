@@ -77,6 +77,9 @@ SendOp::SendOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
   if (!ctx->GetAttr("_hostmem_sendrecv", &hostmem_sendrecv_).ok()) {
     hostmem_sendrecv_ = false;
   }
+  if (!ctx->GetAttr("_rendezvous_slot", &rendezvous_slot_).ok()) {
+    rendezvous_slot_ = -1;
+  }
 }
 
 void SendOp::Compute(OpKernelContext* ctx) {
@@ -97,8 +100,14 @@ void SendOp::Compute(OpKernelContext* ctx) {
     // Use the cached rendezvous key.
     VLOG(2) << "Send " << parsed_key_.buf_ << " using "
             << reinterpret_cast<uintptr_t>(ctx->rendezvous());
-    ctx->SetStatus(ctx->rendezvous()->Send(parsed_key_, args, ctx->input(0),
-                                           ctx->is_input_dead()));
+    if (rendezvous_slot_ >= 0) {
+      ctx->SetStatus(ctx->rendezvous()->SendToSlot(
+          rendezvous_slot_, parsed_key_, args, ctx->input(0),
+          ctx->is_input_dead()));
+    } else {
+      ctx->SetStatus(ctx->rendezvous()->Send(parsed_key_, args, ctx->input(0),
+                                             ctx->is_input_dead()));
+    }
     return;
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
@@ -158,6 +167,9 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   if (!ctx->GetAttr("_hostmem_sendrecv", &hostmem_sendrecv_).ok()) {
     hostmem_sendrecv_ = false;
   }
+  if (!ctx->GetAttr("_rendezvous_slot", &rendezvous_slot_).ok()) {
+    rendezvous_slot_ = -1;
+  }
 }
 
 string RecvOp::TraceString(const OpKernelContext& ctx, bool verbose) const {
@@ -208,8 +220,14 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   if (frame_iter == FrameAndIter(0, 0)) {
     VLOG(2) << "Recv " << parsed_key_.buf_ << " using "
             << reinterpret_cast<uintptr_t>(ctx->rendezvous());
-    ctx->rendezvous()->RecvAsync(parsed_key_, args,
-                                 make_recv_callback(ctx, std::move(done)));
+    if (rendezvous_slot_ >= 0) {
+      ctx->rendezvous()->RecvFromSlotAsync(
+          rendezvous_slot_, parsed_key_, args,
+          make_recv_callback(ctx, std::move(done)));
+    } else {
+      ctx->rendezvous()->RecvAsync(parsed_key_, args,
+                                   make_recv_callback(ctx, std::move(done)));
+    }
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
     GetRendezvousKey(key_prefix_, frame_iter, &in_loop_parsed.buf_);
@@ -32,6 +32,8 @@ class SendOp : public OpKernel {
   string key_prefix_;
   Rendezvous::ParsedKey parsed_key_;
   bool hostmem_sendrecv_;
+  // Slot assigned at graph partition time, or -1 if none.
+  int64_t rendezvous_slot_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(SendOp);
 };
@@ -47,6 +49,8 @@ class RecvOp : public AsyncOpKernel {
   string key_prefix_;
   Rendezvous::ParsedKey parsed_key_;
   bool hostmem_sendrecv_;
+  // Slot assigned at graph partition time, or -1 if none.
+  int64_t rendezvous_slot_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
 };
@@ -19,17 +19,176 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+namespace {
+Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
+                         std::size_t lhs_right) {
+  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
+                                 "] out of bounds (>=", lhs_right, ")");
+}
+
+Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
+                         int64_t out_dim0) {
+  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
+                                 "] out of bounds (>=", out_dim0, ")");
+}
+}  // namespace
+
+// On CPU, products with at least this many multiply-adds (nnz times the
+// number of output columns) are computed from the CSR form of A on multiple
+// threads.
+constexpr int64_t kMinCsrWork = 1 << 16;
+
+// The indices of A in compressed sparse row form, where rows are those of the
+// output (the columns of A if adjoint_a). Kept by the kernel and reused as
+// long as the indices are the same, so that a fixed sparse matrix is only
+// validated and converted once.
+struct SparseTensorDenseMatMulCsr {
+  // The indices it was built from, and their fingerprint.
+  Tensor indices;
+  uint64 fingerprint;
+  int64_t num_rows;
+  int64_t num_cols;
+  std::vector<int64_t> row_ptrs;
+  std::vector<int64_t> col_indices;
+  // For each nonzero in CSR order, its position in a_values. Empty if the
+  // indices are already ordered by row.
+  std::vector<int64_t> value_indices;
+};
+
+// Validates `a_indices` and converts them to CSR form. Nonzeros of a row keep
+// their order in `a_indices`, so each output element sums its products in the
+// same order as the COO implementation.
+template <typename Tindices>
+Status BuildSparseTensorDenseMatMulCsr(
+    typename TTypes<Tindices>::ConstMatrix a_indices, bool adjoint_a,
+    int64_t num_rows, int64_t num_cols, SparseTensorDenseMatMulCsr* csr) {
+  const int64_t nnz = a_indices.dimension(0);
+  const int lhs_index_a = adjoint_a ? 1 : 0;
+  const int rhs_index_a = adjoint_a ? 0 : 1;
+  csr->num_rows = num_rows;
+  csr->num_cols = num_cols;
+  csr->row_ptrs.assign(num_rows + 1, 0);
+  csr->col_indices.resize(nnz);
+  std::vector<int64_t> rows(nnz);
+  bool sorted = true;
+  for (int64_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, num_cols)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, num_cols);
+    }
+    if (!FastBoundsCheck(m, num_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+    }
+    sorted = sorted && (i == 0 || m >= rows[i - 1]);
+    rows[i] = m;
+    csr->col_indices[i] = k;
+    ++csr->row_ptrs[m + 1];
+  }
+  std::partial_sum(csr->row_ptrs.begin(), csr->row_ptrs.end(),
+                   csr->row_ptrs.begin());
+  if (sorted) return OkStatus();
+
+  std::vector<int64_t> col_indices(nnz);
+  csr->value_indices.resize(nnz);
+  std::vector<int64_t> next(csr->row_ptrs.begin(), csr->row_ptrs.end() - 1);
+  for (int64_t i = 0; i < nnz; ++i) {
+    const int64_t j = next[rows[i]]++;
+    col_indices[j] = csr->col_indices[i];
+    csr->value_indices[j] = i;
+  }
+  csr->col_indices = std::move(col_indices);
+  return OkStatus();
+}
+
+// Computes `out` = A * B from the CSR form of A. The rows of the output are
+// split into blocks with about the same number of nonzeros, which are
+// processed in parallel; each row accumulates scaled rows of B, which are
+// contiguous and vectorize.
+template <typename T>
+Status SparseTensorDenseMatMulCsrImpl(OpKernelContext* ctx,
+                                      const SparseTensorDenseMatMulCsr& csr,
+                                      bool adjoint_a, bool adjoint_b,
+                                      typename TTypes<T>::ConstVec a_values,
+                                      const Tensor& b, Tensor* out) {
+  using Tsum = typename SumType<T>::type;
+  const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+  Tensor b_rows = b;
+  if (adjoint_b) {
+    // Conjugate-transpose B once so that its rows are contiguous.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({b.dim_size(1), b.dim_size(0)}),
+        &b_rows));
+    Eigen::array<int, 2> shuffle(1, 0);
+    b_rows.matrix<T>().device(d) = b.matrix<T>().shuffle(shuffle).conjugate();
+  }
+  Tensor sum = *out;
+  if (!std::is_same<T, Tsum>::value) {
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(DataTypeToEnum<Tsum>::value,
+                                          out->shape(), &sum));
+  }
+  sum.matrix<Tsum>().device(d) = sum.matrix<Tsum>().constant(Tsum(0));
+
+  const T* b_data = b_rows.flat<T>().data();
+  Tsum* sum_data = sum.flat<Tsum>().data();
+  const int64_t n = out->dim_size(1);
+  const int64_t nnz = csr.col_indices.size();
+  const auto& worker_threads = *ctx->device()->tensorflow_cpu_worker_threads();
+  const int64_t num_blocks = std::min<int64_t>(
+      csr.num_rows, 4 * static_cast<int64_t>(worker_threads.num_threads));
+  auto block_start = [&](int64_t block) -> int64_t {
+    if (block == num_blocks) return csr.num_rows;
+    return std::lower_bound(csr.row_ptrs.begin(), csr.row_ptrs.end() - 1,
+                            block * nnz / num_blocks) -
+           csr.row_ptrs.begin();
+  };
+  auto multiply_blocks = [&](int64_t start, int64_t limit) {
+    const int64_t row_limit = block_start(limit);
+    for (int64_t m = block_start(start); m < row_limit; ++m) {
+      Tsum* out_row = sum_data + m * n;
+      for (int64_t j = csr.row_ptrs[m]; j < csr.row_ptrs[m + 1]; ++j) {
+        const int64_t i = csr.value_indices.empty() ? j : csr.value_indices[j];
+        const Tsum a_value = static_cast<Tsum>(
+            adjoint_a ? MaybeConj(a_values(i)) : a_values(i));
+        const T* b_row = b_data + csr.col_indices[j] * n;
+        for (int64_t c = 0; c < n; ++c) {
+          out_row[c] += a_value * static_cast<Tsum>(b_row[c]);
+        }
+      }
+    }
+  };
+  Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+        std::max<int64_t>(nnz / num_blocks, 1) * n, multiply_blocks);
+
+  if (!std::is_same<T, Tsum>::value) {
+    out->matrix<T>().device(d) = sum.matrix<Tsum>().template cast<T>();
+  }
+  return OkStatus();
+}
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Tindices>
 class SparseTensorDenseMatMulOp : public OpKernel {
  public:
@@ -133,6 +292,20 @@ class SparseTensorDenseMatMulOp : public OpKernel {
       return;
     }
 
+    if constexpr (std::is_same<Device, CPUDevice>::value) {
+      const auto& worker_threads =
+          *ctx->device()->tensorflow_cpu_worker_threads();
+      if (worker_threads.num_threads > 1 &&
+          nnz * outer_right >= functor::kMinCsrWork) {
+        std::shared_ptr<const functor::SparseTensorDenseMatMulCsr> csr;
+        OP_REQUIRES_OK(ctx, GetCsr(*a_indices, outer_left, inner_left, &csr));
+        OP_REQUIRES_OK(ctx, functor::SparseTensorDenseMatMulCsrImpl<T>(
+                                ctx, *csr, adjoint_a_, adjoint_b_,
+                                a_values->vec<T>(), *b, out));
+        return;
+      }
+    }
+
 #define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                           \
   if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                           \
     Status functor_status = functor::SparseTensorDenseMatMulFunctor<          \
@@ -151,8 +324,52 @@ class SparseTensorDenseMatMulOp : public OpKernel {
   }
 
  private:
+  // Returns the CSR form of `a_indices`, reusing the one of the previous call
+  // if the indices are the same: they are in the same buffer, or have the same
+  // bytes. Fingerprints only spare comparing the bytes of different indices.
+  //
+  // Holding the previous indices keeps their buffer from being reused, and
+  // makes resource variables copy it before updating it.
+  Status GetCsr(
+      const Tensor& a_indices, int64_t num_rows, int64_t num_cols,
+      std::shared_ptr<const functor::SparseTensorDenseMatMulCsr>* csr) {
+    std::shared_ptr<const functor::SparseTensorDenseMatMulCsr> cached;
+    {
+      tf_shared_lock l(mu_);
+      cached = csr_;
+    }
+    const StringPiece data = a_indices.tensor_data();
+    const bool same_shape = cached != nullptr &&
+                            cached->num_rows == num_rows &&
+                            cached->num_cols == num_cols &&
+                            cached->indices.shape() == a_indices.shape();
+    if (same_shape && cached->indices.tensor_data().data() == data.data()) {
+      *csr = std::move(cached);
+      return OkStatus();
+    }
+    const uint64 fingerprint = Fingerprint64(data);
+    if (same_shape && cached->fingerprint == fingerprint &&
+        cached->indices.tensor_data() == data) {
+      *csr = std::move(cached);
+      return OkStatus();
+    }
+    auto new_csr = std::make_shared<functor::SparseTensorDenseMatMulCsr>();
+    TF_RETURN_IF_ERROR(functor::BuildSparseTensorDenseMatMulCsr<Tindices>(
+        a_indices.matrix<Tindices>(), adjoint_a_, num_rows, num_cols,
+        new_csr.get()));
+    new_csr->indices = a_indices;
+    new_csr->fingerprint = fingerprint;
+    mutex_lock l(mu_);
+    csr_ = new_csr;
+    *csr = std::move(new_csr);
+    return OkStatus();
+  }
+
   bool adjoint_a_;
   bool adjoint_b_;
+  mutex mu_;
+  std::shared_ptr<const functor::SparseTensorDenseMatMulCsr> csr_
+      TF_GUARDED_BY(mu_);
 };
 
 #define REGISTER_CPU(TypeT, TypeIndex)           \
@@ -238,18 +455,6 @@ REGISTER_KERNELS_GPU(complex128);
 namespace functor {
 
 namespace {
-Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
-                         std::size_t lhs_right) {
-  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
-                                 "] out of bounds (>=", lhs_right, ")");
-}
-
-Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
-                         int64_t out_dim0) {
-  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
-                                 "] out of bounds (>=", out_dim0, ")");
-}
-
 template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
 Status SparseTensorDenseMatMulImpl(
     typename TTypes<Tsum>::Matrix out,
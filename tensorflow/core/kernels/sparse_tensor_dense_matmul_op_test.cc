@@ -13,16 +13,150 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <random>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+// Products large enough for the multi-threaded CSR implementation.
+class SparseTensorDenseMatMulOpTest : public OpsTestBase {
+ protected:
+  static constexpr int kRows = 300;
+  static constexpr int kCols = 200;
+  static constexpr int kNnz = 3000;
+  static constexpr int kN = 64;
+
+  void MakeOp(bool adjoint_a, bool adjoint_b) {
+    adjoint_a_ = adjoint_a;
+    adjoint_b_ = adjoint_b;
+    TF_ASSERT_OK(NodeDefBuilder("matmul", "SparseTensorDenseMatMul")
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT64))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("adjoint_a", adjoint_a)
+                     .Attr("adjoint_b", adjoint_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Returns unordered indices of a [kRows, kCols] matrix, with duplicates.
+  static std::vector<int64_t> RandomIndices(int seed) {
+    std::mt19937 gen(seed);
+    std::vector<int64_t> indices(kNnz * 2);
+    for (int i = 0; i < kNnz; ++i) {
+      indices[2 * i] = gen() % kRows;
+      indices[2 * i + 1] = gen() % kCols;
+    }
+    return indices;
+  }
+
+  static std::vector<float> RandomValues(int seed, int size = kNnz) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::vector<float> values(size);
+    for (float& value : values) value = dist(gen);
+    return values;
+  }
+
+  // Runs the op on the [kRows, kCols] sparse matrix of `indices` and `values`
+  // (transposed if adjoint_a) and a random B, and checks it against a dense
+  // product.
+  void RunAndCheck(const std::vector<int64_t>& indices,
+                   const std::vector<float>& values) {
+    const int m = adjoint_a_ ? kCols : kRows;
+    const int k = adjoint_a_ ? kRows : kCols;
+    const std::vector<float> b_values = RandomValues(0, k * kN);
+    const Tensor b = test::AsTensor<float>(
+        b_values, adjoint_b_ ? TensorShape({kN, k}) : TensorShape({k, kN}));
+    auto b_matrix = b.matrix<float>();
+    Tensor expected(DT_FLOAT, TensorShape({m, kN}));
+    auto expected_matrix = expected.matrix<float>();
+    expected_matrix.setZero();
+    for (int i = 0; i < kNnz; ++i) {
+      const int row = indices[2 * i + (adjoint_a_ ? 1 : 0)];
+      const int col = indices[2 * i + (adjoint_a_ ? 0 : 1)];
+      for (int j = 0; j < kN; ++j) {
+        expected_matrix(row, j) +=
+            values[i] * (adjoint_b_ ? b_matrix(j, col) : b_matrix(col, j));
+      }
+    }
+
+    inputs_.clear();
+    AddInputFromArray<int64_t>(TensorShape({kNnz, 2}), indices);
+    AddInputFromArray<float>(TensorShape({kNnz}), values);
+    AddInputFromArray<int64_t>(TensorShape({2}), {kRows, kCols});
+    AddInputFromArray<float>(b.shape(), b_values);
+    TF_ASSERT_OK(RunOpKernel());
+    test::ExpectTensorNear<float>(*GetOutput(0), expected, 1e-4);
+  }
+
+  bool adjoint_a_;
+  bool adjoint_b_;
+};
+
+TEST_F(SparseTensorDenseMatMulOpTest, Unordered) {
+  MakeOp(false, false);
+  RunAndCheck(RandomIndices(1), RandomValues(2));
+}
+
+TEST_F(SparseTensorDenseMatMulOpTest, Ordered) {
+  MakeOp(false, false);
+  std::vector<int64_t> indices = RandomIndices(1);
+  std::vector<std::pair<int64_t, int64_t>> pairs(kNnz);
+  for (int i = 0; i < kNnz; ++i) {
+    pairs[i] = {indices[2 * i], indices[2 * i + 1]};
+  }
+  std::sort(pairs.begin(), pairs.end());
+  for (int i = 0; i < kNnz; ++i) {
+    indices[2 * i] = pairs[i].first;
+    indices[2 * i + 1] = pairs[i].second;
+  }
+  RunAndCheck(indices, RandomValues(2));
+}
+
+TEST_F(SparseTensorDenseMatMulOpTest, Adjoint) {
+  MakeOp(true, true);
+  RunAndCheck(RandomIndices(1), RandomValues(2));
+}
+
+TEST_F(SparseTensorDenseMatMulOpTest, RepeatedIndices) {
+  MakeOp(false, true);
+  const std::vector<int64_t> indices = RandomIndices(1);
+  RunAndCheck(indices, RandomValues(2));
+  // The cached conversion of the indices must pick up the new values.
+  RunAndCheck(indices, RandomValues(3));
+  RunAndCheck(RandomIndices(4), RandomValues(5));
+  // It must not be reused for indices that differ in a single entry.
+  std::vector<int64_t> other = indices;
+  RunAndCheck(other, RandomValues(2));
+  other[2 * 123 + 1] = (other[2 * 123 + 1] + 1) % kCols;
+  RunAndCheck(other, RandomValues(2));
+
+  std::vector<int64_t> invalid = indices;
+  invalid[2 * 123] = kRows;
+  inputs_.clear();
+  AddInputFromArray<int64_t>(TensorShape({kNnz, 2}), invalid);
+  AddInputFromArray<float>(TensorShape({kNnz}), RandomValues(2));
+  AddInputFromArray<int64_t>(TensorShape({2}), {kRows, kCols});
+  AddInputFromArray<float>(TensorShape({kN, kCols}),
+                           std::vector<float>(kN * kCols));
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
 Node* SparseTensorDenseMatMulNode(Graph* g, Node* a_indices, Node* a_values,
                                   Node* a_shape, Node* b, bool adjoint_a,
                                   bool adjoint_b) {
@@ -120,4 +254,7 @@ BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, false, true);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, false);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, true);
 
+BM_SparseTensorDenseMatmul(262144, 16384, 16384, 64, false, false);
+BM_SparseTensorDenseMatmul(262144, 16384, 16384, 64, true, false);
+
 }  // end namespace tensorflow
@@ -64,6 +64,29 @@ Tensor GetTestTensor(int batch) {
   return t;
 }
 
+class StringSplitOpTest : public OpsTestBase {};
+
+TEST_F(StringSplitOpTest, CharSetDelimiter) {
+  TF_ASSERT_OK(NodeDefBuilder("string_split_op", "StringSplit")
+                   .Input(FakeInput(DT_STRING))
+                   .Input(FakeInput(DT_STRING))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<tstring>(
+      TensorShape({3}), {"a,b  c", "", ",,a long enough token to be large,"});
+  AddInputFromArray<tstring>(TensorShape({}), {" ,"});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int64_t>(
+      *GetOutput(0),
+      test::AsTensor<int64_t>({0, 0, 0, 1, 0, 2, 2, 0}, TensorShape({4, 2})));
+  test::ExpectTensorEqual<tstring>(
+      *GetOutput(1), test::AsTensor<tstring>(
+                         {"a", "b", "c", "a long enough token to be large"}));
+  test::ExpectTensorEqual<int64_t>(*GetOutput(2),
+                                   test::AsTensor<int64_t>({3, 3}));
+}
+
 Graph* SetupStringSplitGraph(const Tensor& input) {
   Graph* g = new Graph(OpRegistry::Global());
   Tensor delim(DT_STRING, TensorShape({}));
@@ -93,7 +116,8 @@ BENCHMARK(BM_StringSplit)
     ->Arg(32)
     ->Arg(64)
     ->Arg(128)
-    ->Arg(256);
+    ->Arg(256)
+    ->Arg(16 * 1024);
 
 Graph* SetupStringSplitV2Graph(const Tensor& input) {
   Graph* g = new Graph(OpRegistry::Global());
@@ -124,6 +148,7 @@ BENCHMARK(BM_StringSplitV2)
     ->Arg(32)
     ->Arg(64)
     ->Arg(128)
-    ->Arg(256);
+    ->Arg(256)
+    ->Arg(16 * 1024);
 
 }  // end namespace tensorflow
@@ -15,11 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/string_to_hash_bucket_fast_op.h"
 
-#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/kernels/batch_fingerprint.h"
 
 namespace tensorflow {
 
 REGISTER_KERNEL_BUILDER(Name("StringToHashBucketFast").Device(DEVICE_CPU),
-                        StringToHashBucketOp<Fingerprint64>);
+                        StringToHashBucketOp<BatchFingerprint64>);
 
 }  // namespace tensorflow
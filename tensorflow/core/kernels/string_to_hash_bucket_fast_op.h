@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_FAST_OP_H_
 #define TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_FAST_OP_H_
 
+#include <algorithm>
 #include <string>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -23,10 +24,13 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
-template <uint64 hash(StringPiece)>
+// Hashes strings with `hash`, which sets `hashes[i]` to the hash of
+// `strings[i]` for `i` < `n`.
+template <void hash(const StringPiece* strings, int64_t n, uint64* hashes)>
 class StringToHashBucketOp : public OpKernel {
  public:
   explicit StringToHashBucketOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
@@ -44,18 +48,40 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64_t>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64_t>(bucket_id);
+    auto hash_elements = [&](int64_t start, int64_t limit) {
+      StringPiece input_strs[kBatchSize];
+      uint64 hashes[kBatchSize];
+      for (int64_t begin = start; begin < limit; begin += kBatchSize) {
+        const int64_t n = std::min(kBatchSize, limit - begin);
+        for (int64_t i = 0; i < n; ++i) input_strs[i] = input_flat(begin + i);
+        hash(input_strs, n, hashes);
+        for (int64_t i = 0; i < n; ++i) {
+          const uint64 bucket_id = hashes[i] % num_buckets_;
+          // The number of buckets is always in the positive range of int64 so
+          // is the resulting bucket_id. Casting the bucket_id from uint64 to
+          // int64 is safe.
+          output_flat(begin + i) = static_cast<int64_t>(bucket_id);
+        }
+      }
+    };
+    int64_t total_size = 0;
+    for (int64_t i = 0; i < input_flat.size(); ++i) {
+      total_size += input_flat(i).size();
     }
+    // Hashing takes about a cycle per byte, on top of the division by the
+    // number of buckets and the overhead of each element.
+    const int64_t cost_per_element =
+        kCostPerElement + total_size / std::max<int64_t>(input_flat.size(), 1);
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          input_flat.size(), cost_per_element, hash_elements);
   }
 
  private:
+  // The number of strings passed to `hash` at once.
+  static constexpr int64_t kBatchSize = 64;
+  static constexpr int64_t kCostPerElement = 50;
+
   int64_t num_buckets_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(StringToHashBucketOp);
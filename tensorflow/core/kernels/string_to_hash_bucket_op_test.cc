@@ -0,0 +1,138 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <random>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+constexpr int64_t kNumBuckets = 1000003;
+
+// Id strings as they appear in recommendation features: mostly short, with a
+// tail of longer ones, e.g. URLs.
+Tensor GetIdStrings(int batch) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> length_bucket(0, 9);
+  Tensor t(DT_STRING, {batch});
+  auto s = t.flat<tstring>();
+  for (int i = 0; i < batch; ++i) {
+    const int bucket = length_bucket(rng);
+    const int length = bucket < 6 ? 8 + bucket : bucket < 9 ? 24 : 80;
+    s(i) = absl::StrCat("id_", rng());
+    s(i).resize(length, 'x');
+  }
+  return t;
+}
+
+class StringToHashBucketOpTest : public OpsTestBase {};
+
+TEST_F(StringToHashBucketOpTest, StringToHashBucketFast) {
+  TF_ASSERT_OK(NodeDefBuilder("op", "StringToHashBucketFast")
+                   .Input(FakeInput(DT_STRING))
+                   .Attr("num_buckets", kNumBuckets)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const Tensor input = GetIdStrings(100000);
+  AddInput<tstring>(input.shape(),
+                    [&input](int i) { return input.flat<tstring>()(i); });
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_INT64, input.shape());
+  for (int i = 0; i < input.NumElements(); ++i) {
+    expected.flat<int64_t>()(i) =
+        Fingerprint64(input.flat<tstring>()(i)) % kNumBuckets;
+  }
+  test::ExpectTensorEqual<int64_t>(*GetOutput(0), expected);
+}
+
+TEST_F(StringToHashBucketOpTest, TensorToHashBucketFast) {
+  TF_ASSERT_OK(NodeDefBuilder("op", "_TensorToHashBucketFast")
+                   .Input(FakeInput(DT_INT64))
+                   .Attr("num_buckets", kNumBuckets)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  std::vector<int64_t> input(100000);
+  for (int i = 0; i < input.size(); ++i) {
+    input[i] = (i % 2 ? -1 : 1) * (int64_t{1} << (i % 63)) + i;
+  }
+  AddInputFromArray<int64_t>(TensorShape({100000}), input);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_INT64, TensorShape({100000}));
+  for (int i = 0; i < input.size(); ++i) {
+    expected.flat<int64_t>()(i) =
+        Fingerprint64(absl::StrCat(input[i])) % kNumBuckets;
+  }
+  test::ExpectTensorEqual<int64_t>(*GetOutput(0), expected);
+}
+
+static Graph* StringToHashBucket(const Tensor& input) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "StringToHashBucketFast")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("num_buckets", kNumBuckets)
+                  .Finalize(g, &node));
+  return g;
+}
+
+static void BM_StringToHashBucketFast(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  Graph* g = StringToHashBucket(GetIdStrings(batch));
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batch);
+}
+
+BENCHMARK(BM_StringToHashBucketFast)
+    ->UseRealTime()
+    ->Arg(256)
+    ->Arg(4096)
+    ->Arg(65536);
+
+static void BM_TensorToHashBucketFast(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  Tensor input(DT_INT64, TensorShape({batch}));
+  input.flat<int64_t>().setRandom();
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_TensorToHashBucketFast")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("num_buckets", kNumBuckets)
+                  .Finalize(g, &node));
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batch);
+}
+
+BENCHMARK(BM_TensorToHashBucketFast)
+    ->UseRealTime()
+    ->Arg(256)
+    ->Arg(4096)
+    ->Arg(65536);
+
+}  // namespace tensorflow
@@ -16,17 +16,19 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TENSOR_TO_HASH_BUCKET_OP_H_
 #define TENSORFLOW_CORE_KERNELS_TENSOR_TO_HASH_BUCKET_OP_H_
 
+#include <algorithm>
 #include <string>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/batch_fingerprint.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
-#include "tensorflow/core/lib/strings/stringprintf.h"
-#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -36,15 +38,11 @@ template <typename Device, typename T>
 struct LaunchTensorToHashBucket {
   void operator()(OpKernelContext* c, const int64_t num_buckets, const T* input,
                   const int num_elems, int64_t* output) {
-    string format = "%";
     switch (DataTypeToEnum<T>::value) {
       case DT_INT8:
       case DT_INT16:
       case DT_INT32:
-        strings::Appendf(&format, "d");
-        break;
       case DT_INT64:
-        strings::Appendf(&format, "lld");
         break;
       default:
         bool type_not_supported = true;
@@ -54,15 +52,36 @@ struct LaunchTensorToHashBucket {
                                     DataTypeString(DataTypeToEnum<T>::value)));
     }
 
-    for (int i = 0; i < num_elems; ++i) {
-      string input_str = strings::Printf(format.c_str(), input[i]);
-      const uint64 input_hash = Fingerprint64(input_str);
-      const uint64 bucket_id = input_hash % num_buckets;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output[i] = static_cast<int64_t>(bucket_id);
-    }
+    constexpr int64_t kBatchSize = 64;
+    auto hash_elements = [&](int64_t start, int64_t limit) {
+      char buffers[kBatchSize][strings::kFastToBufferSize];
+      StringPiece input_strs[kBatchSize];
+      uint64 hashes[kBatchSize];
+      for (int64_t begin = start; begin < limit; begin += kBatchSize) {
+        const int64_t n = std::min(kBatchSize, limit - begin);
+        for (int64_t i = 0; i < n; ++i) {
+          // Hashes the same decimal string as printf's "%d", without
+          // allocating it.
+          const size_t length = strings::FastInt64ToBufferLeft(
+              static_cast<int64_t>(input[begin + i]), buffers[i]);
+          input_strs[i] = StringPiece(buffers[i], length);
+        }
+        BatchFingerprint64(input_strs, n, hashes);
+        for (int64_t i = 0; i < n; ++i) {
+          const uint64 bucket_id = hashes[i] % num_buckets;
+          // The number of buckets is always in the positive range of int64 so
+          // is the resulting bucket_id. Casting the bucket_id from uint64 to
+          // int64 is safe.
+          output[begin + i] = static_cast<int64_t>(bucket_id);
+        }
+      }
+    };
+    // Formatting and hashing the at most 20 digits of an integer, and
+    // dividing by the number of buckets.
+    constexpr int64_t kCostPerElement = 100;
+    auto worker_threads = *(c->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, num_elems,
+          kCostPerElement, hash_elements);
   }
 };
 
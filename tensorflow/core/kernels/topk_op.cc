@@ -129,6 +129,143 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// Rows with at least twice this many columns are split into chunks of at
+// least this many columns, which are searched in parallel, when there are
+// fewer rows than threads.
+constexpr int64_t kParallelTopKMinChunkSize = 1 << 15;
+
+// Number of columns compared at once to the threshold of a chunk.
+constexpr int64_t kTopKFilterBlockSize = 64;
+
+// Orders the columns of a row by decreasing values, and then by increasing
+// indices.
+template <typename T, typename Tidx>
+struct TopKStableComp {
+  bool operator()(const Tidx a, const Tidx b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+
+  const T* input_data;
+};
+
+// Sets `top_k` to the indices of the top `k` values among the columns
+// [begin, end) of a row, in no particular order. Returns false, leaving
+// `top_k` unspecified, if one of the values is NaN.
+//
+// Columns are only kept when their value is greater than the k-th largest one
+// kept so far, since later columns lose ties. The threshold is first compared
+// to whole blocks of columns, which vectorizes, and almost all the blocks of
+// a long row fail it. NaNs, which compare neither greater nor smaller, pass
+// it, so that no block holding one is skipped.
+template <typename T, typename Tidx>
+bool SelectTopKColumns(const TopKStableComp<T, Tidx>& comp, int64_t begin,
+                       int64_t end, int k, std::vector<Tidx>* top_k) {
+  const T* input_data = comp.input_data;
+  top_k->clear();
+  top_k->reserve(2 * k + kTopKFilterBlockSize);
+  bool has_threshold = false;
+  T threshold = T();
+  auto select = [&]() {
+    std::nth_element(top_k->begin(), top_k->begin() + (k - 1), top_k->end(),
+                     comp);
+    top_k->resize(k);
+    threshold = input_data[top_k->back()];
+    has_threshold = true;
+  };
+  for (int64_t block = begin; block < end; block += kTopKFilterBlockSize) {
+    const int64_t block_end = std::min(end, block + kTopKFilterBlockSize);
+    if (has_threshold) {
+      bool any_greater_or_nan = false;
+      for (int64_t c = block; c < block_end; ++c) {
+        any_greater_or_nan |= !(input_data[c] <= threshold);
+      }
+      if (!any_greater_or_nan) continue;
+    }
+    for (int64_t c = block; c < block_end; ++c) {
+      if (Eigen::numext::isnan(input_data[c])) return false;
+      if (!has_threshold || input_data[c] > threshold) {
+        top_k->push_back(static_cast<Tidx>(c));
+      }
+    }
+    if (top_k->size() >= 2 * static_cast<size_t>(k)) select();
+  }
+  if (top_k->size() > static_cast<size_t>(k)) select();
+  return true;
+}
+
+// Computes the top `k` values of rows that are long enough to be split into
+// chunks. The top `k` values of each chunk are selected in parallel, and then
+// merged, as the top `k` values of a row are among those of its chunks.
+//
+// Rows holding NaNs, which TopKStableComp does not order strictly, are left to
+// the caller and flagged in `row_has_nan`.
+template <typename T, typename Tidx>
+void ParallelTopK(OpKernelContext* context, bool sorted, int k,
+                  const typename TTypes<T, 2>::ConstTensor& input,
+                  const int64_t num_rows, const int64_t num_cols,
+                  typename TTypes<T, 2>::Tensor values,
+                  typename TTypes<Tidx, 2>::Tensor indices,
+                  std::vector<char>* row_has_nan) {
+  const auto& worker_threads =
+      *(context->device()->tensorflow_cpu_worker_threads());
+  const int64_t min_chunk_size =
+      std::max<int64_t>(kParallelTopKMinChunkSize, 8 * int64_t{k});
+  const int64_t num_chunks =
+      std::max<int64_t>(1, std::min<int64_t>(worker_threads.num_threads,
+                                             num_cols / min_chunk_size));
+  const int64_t chunk_size = (num_cols + num_chunks - 1) / num_chunks;
+
+  std::vector<std::vector<Tidx>> chunk_top_k(num_rows * num_chunks);
+  std::vector<char> chunk_has_nan(num_rows * num_chunks);
+  const int64_t chunk_cost =
+      chunk_size * (Eigen::TensorOpCost::AddCost<T>() + 1);
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        num_rows * num_chunks, chunk_cost, [&](int64_t start, int64_t limit) {
+          for (int64_t i = start; i < limit; ++i) {
+            const int64_t b = i / num_chunks;
+            const int64_t begin = (i % num_chunks) * chunk_size;
+            const int64_t end = std::min(num_cols, begin + chunk_size);
+            chunk_has_nan[i] =
+                !SelectTopKColumns(TopKStableComp<T, Tidx>{&input(b, 0)},
+                                   begin, end, k, &chunk_top_k[i]);
+          }
+        });
+
+  row_has_nan->assign(num_rows, false);
+  const int64_t merge_cost =
+      num_chunks * k * (3 * Eigen::TensorOpCost::AddCost<Tidx>() + 1);
+  Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+        merge_cost, [&](int64_t start_batch, int64_t limit_batch) {
+          for (int64_t b = start_batch; b < limit_batch; ++b) {
+            if (std::any_of(chunk_has_nan.begin() + b * num_chunks,
+                            chunk_has_nan.begin() + (b + 1) * num_chunks,
+                            [](char has_nan) { return has_nan; })) {
+              (*row_has_nan)[b] = true;
+              continue;
+            }
+            const TopKStableComp<T, Tidx> comp{&input(b, 0)};
+            std::vector<Tidx> top_k;
+            for (int64_t i = b * num_chunks; i < (b + 1) * num_chunks; ++i) {
+              top_k.insert(top_k.end(), chunk_top_k[i].begin(),
+                           chunk_top_k[i].end());
+            }
+            std::nth_element(top_k.begin(), top_k.begin() + (k - 1),
+                             top_k.end(), comp);
+            if (sorted) std::sort(top_k.begin(), top_k.begin() + k, comp);
+            std::copy(top_k.begin(), top_k.begin() + k, &indices(b, 0));
+            std::transform(
+                &indices(b, 0), &indices(b, k), &values(b, 0),
+                [b, &input](const Tidx loc) { return input(b, loc); });
+          }
+        });
+}
+
 template <typename T, typename Tidx>
 struct TopKFunctor<CPUDevice, T, Tidx> {
   static EIGEN_ALWAYS_INLINE Status Compute(
@@ -161,6 +298,7 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
       return OkStatus();
     }
 
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
       for (int32_t b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
@@ -233,6 +371,19 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
       }  // for (Tidx b = ...
     };
 
+    // Few long rows would leave most threads idle if each row was sorted by
+    // a single thread.
+    if (num_rows < worker_threads.num_threads && k < num_cols &&
+        num_cols >= 2 * kParallelTopKMinChunkSize) {
+      std::vector<char> row_has_nan;
+      ParallelTopK<T, Tidx>(context, sorted, k, input, num_rows, num_cols,
+                            values, indices, &row_has_nan);
+      for (int64_t b = 0; b < num_rows; ++b) {
+        if (row_has_nan[b]) SortIndices(b, b + 1);
+      }
+      return OkStatus();
+    }
+
     // Guesstimate of cost; 4*N*log(K) where N == num_cols.
     // If K == N, assume the cost is N*log(K + 1).
     const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<Tidx>() +
@@ -247,7 +398,6 @@ struct TopKFunctor<CPUDevice, T, Tidx> {
     const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
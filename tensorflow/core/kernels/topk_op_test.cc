@@ -0,0 +1,153 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class TopKOpTest : public OpsTestBase {
+ protected:
+  // Checks TopKV2 against a stable sort of each row of a [num_rows, num_cols]
+  // input with many ties.
+  void RunTest(int num_rows, int num_cols, int k) {
+    TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    std::vector<float> input(num_rows * num_cols);
+    for (int64_t i = 0; i < num_rows * num_cols; ++i) {
+      input[i] = (i * 7919) % 1009;
+    }
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), input);
+    AddInputFromArray<int32>(TensorShape({}), {k});
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<float> values;
+    std::vector<int32> indices;
+    for (int b = 0; b < num_rows; ++b) {
+      const float* row = &input[b * num_cols];
+      std::vector<int32> order(num_cols);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(),
+                       [row](int32 a, int32 b) { return row[a] > row[b]; });
+      for (int i = 0; i < k; ++i) {
+        values.push_back(row[order[i]]);
+        indices.push_back(order[i]);
+      }
+    }
+    const TensorShape output_shape({num_rows, k});
+    test::ExpectTensorEqual<float>(*GetOutput(0),
+                                   test::AsTensor<float>(values, output_shape));
+    test::ExpectTensorEqual<int32>(
+        *GetOutput(1), test::AsTensor<int32>(indices, output_shape));
+  }
+};
+
+TEST_F(TopKOpTest, ShortRows) { RunTest(16, 1000, 10); }
+
+// Long enough for rows to be split across threads.
+TEST_F(TopKOpTest, LongRow) { RunTest(1, 1 << 18, 1000); }
+
+TEST_F(TopKOpTest, LongRows) { RunTest(2, 1 << 17, 10); }
+
+// NaNs in a row split across threads give the same top k as when the row is
+// not split, which it is not when there are as many rows as threads.
+TEST_F(TopKOpTest, LongRowWithNaNs) {
+  TF_ASSERT_OK(NodeDefBuilder("top_k", "TopKV2")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  const int num_cols = 1 << 16;
+  const int k = 10;
+  std::vector<float> row(num_cols);
+  for (int i = 0; i < num_cols; ++i) row[i] = (i * 7919) % 1009;
+  for (int i : {3, 200, num_cols - 1}) row[i] = NAN;
+
+  AddInputFromArray<float>(TensorShape({1, num_cols}), row);
+  AddInputFromArray<int32>(TensorShape({}), {k});
+  TF_ASSERT_OK(RunOpKernel());
+  const Tensor split_indices = *GetOutput(1);
+
+  const int num_rows = device_->tensorflow_cpu_worker_threads()->num_threads;
+  std::vector<float> rows;
+  for (int b = 0; b < num_rows; ++b) {
+    rows.insert(rows.end(), row.begin(), row.end());
+  }
+  inputs_.clear();
+  AddInputFromArray<float>(TensorShape({num_rows, num_cols}), rows);
+  AddInputFromArray<int32>(TensorShape({}), {k});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<int32>(split_indices, GetOutput(1)->Slice(0, 1));
+}
+
+static Graph* TopK(int num_rows, int num_cols, int k) {
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input_t(DT_FLOAT, TensorShape({num_rows, num_cols}));
+  input_t.flat<float>().setRandom();
+
+  Tensor k_t(DT_INT32, TensorShape({}));
+  k_t.scalar<int32>()() = k;
+
+  Node* top_k;
+  TF_CHECK_OK(NodeBuilder(g->NewName("top_k"), "TopKV2")
+                  .Input(test::graph::Constant(g, input_t, "input"))
+                  .Input(test::graph::Constant(g, k_t, "k"))
+                  .Finalize(g, &top_k));
+  return g;
+}
+
+#define BM_NAME(ROWS, COLS, K) BM_TopK##_##ROWS##_##COLS##_##K
+
+#define BM_TopK(ROWS, COLS, K)                                                \
+  static void BM_NAME(ROWS, COLS, K)(::testing::benchmark::State & state) { \
+    test::Benchmark("cpu", TopK(ROWS, COLS, K),                              \
+                    /*old_benchmark_api=*/false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *       \
+                            ROWS * COLS);                                    \
+  }                                                                          \
+  BENCHMARK(BM_NAME(ROWS, COLS, K))->UseRealTime();
+
+BM_TopK(256, 1000, 10);
+BM_TopK(256, 100000, 100);
+BM_TopK(1, 1000000, 10);
+BM_TopK(1, 1000000, 1000);
+BM_TopK(1, 10000000, 1000);
+BM_TopK(4, 10000000, 1000);
+BM_TopK(1, 10000000, 100000);
+
+}  // namespace
+}  // namespace tensorflow
@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -23,9 +26,11 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +73,156 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Integer inputs of at least this many elements are uniquified by
+// `ParallelUnique` when the op has several worker threads.
+constexpr int64_t kParallelUniqueMinSize = 1 << 16;
+
+// Number of elements per block of the input in `ParallelUnique`.
+constexpr int64_t kParallelUniqueMinBlockSize = 1 << 14;
+
+template <typename T>
+constexpr bool kHasParallelUnique =
+    std::is_integral<T>::value && !std::is_same<T, bool>::value;
+
+// `ParallelUnique` computes the unique elements of the integer vector `Tin`,
+// with the same outputs as the serial implementation of `UniqueOp`: the
+// unique elements are in the order of their first occurrences.
+//
+// The input is cut into contiguous blocks, whose elements are scattered into
+// partitions by hash, so that each partition holds all the occurrences of its
+// keys in input order. The partitions are uniquified by separate threads, and
+// the first occurrences of all the partitions are then numbered in input
+// order to merge them.
+template <typename T, typename TIndex>
+void ParallelUnique(OpKernelContext* context,
+                    typename TTypes<T>::ConstFlat Tin, TensorShape output_shape,
+                    int64_t axis, typename TTypes<TIndex>::Vec idx_vec) {
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *context->device()->tensorflow_cpu_worker_threads();
+  // `UniqueOp` checks that the input has fewer than 2^31 elements.
+  const int32 N = static_cast<int32>(Tin.size());
+  const int64_t num_blocks = std::max<int64_t>(
+      1, std::min<int64_t>(4 * worker_threads.num_threads,
+                           N / kParallelUniqueMinBlockSize));
+  const int64_t block_size = (N + num_blocks - 1) / num_blocks;
+  const int partition_bits = std::max(1, Log2Ceiling64(num_blocks));
+  const int64_t num_partitions = int64_t{1} << partition_bits;
+  auto partition_of = [partition_bits](T key) {
+    return static_cast<int64_t>((static_cast<uint64>(key) *
+                                 0x9E3779B97F4A7C15ULL) >>
+                                (64 - partition_bits));
+  };
+  auto parallel_for = [&worker_threads, block_size](
+                          int64_t n, const std::function<void(int64_t)>& fn) {
+    Shard(worker_threads.num_threads, worker_threads.workers, n,
+          /*cost_per_unit=*/10 * block_size, [&fn](int64_t start, int64_t end) {
+            for (int64_t i = start; i < end; ++i) fn(i);
+          });
+  };
+
+  // Count the elements of each partition in each block, and turn the counts
+  // into the offsets of the blocks in the partitions.
+  std::vector<int32> offsets(num_blocks * num_partitions);
+  parallel_for(num_blocks, [&](int64_t b) {
+    int32* block_offsets = &offsets[b * num_partitions];
+    const int32 end = std::min<int64_t>(N, (b + 1) * block_size);
+    for (int32 i = b * block_size; i < end; ++i) {
+      ++block_offsets[partition_of(Tin(i))];
+    }
+  });
+  std::vector<int32> partition_begin(num_partitions + 1);
+  int32 offset = 0;
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    partition_begin[p] = offset;
+    for (int64_t b = 0; b < num_blocks; ++b) {
+      const int32 count = offsets[b * num_partitions + p];
+      offsets[b * num_partitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_begin[num_partitions] = offset;
+
+  // Scatter the positions of the elements into their partitions.
+  std::vector<int32> positions(N);
+  parallel_for(num_blocks, [&](int64_t b) {
+    int32* block_offsets = &offsets[b * num_partitions];
+    const int32 end = std::min<int64_t>(N, (b + 1) * block_size);
+    for (int32 i = b * block_size; i < end; ++i) {
+      positions[block_offsets[partition_of(Tin(i))]++] = i;
+    }
+  });
+
+  // Uniquify each partition. `local_ids` holds the id of each element among
+  // the unique elements of its partition, and `idx_vec` is used to mark the
+  // first occurrences until they are numbered.
+  std::vector<int32> local_ids(N);
+  std::vector<std::vector<int32>> first_positions(num_partitions);
+  std::vector<std::vector<TIndex>> counts(num_partitions);
+  const bool with_counts = context->num_outputs() > 2;
+  parallel_for(num_partitions, [&](int64_t p) {
+    absl::flat_hash_map<T, int32> uniq;
+    uniq.reserve(partition_begin[p + 1] - partition_begin[p]);
+    for (int32 j = partition_begin[p]; j < partition_begin[p + 1]; ++j) {
+      const int32 i = positions[j];
+      auto it = uniq.emplace(Tin(i), static_cast<int32>(uniq.size()));
+      local_ids[j] = it.first->second;
+      idx_vec(i) = it.second;
+      if (it.second) {
+        first_positions[p].push_back(i);
+        if (with_counts) counts[p].push_back(0);
+      }
+      if (with_counts) ++counts[p][it.first->second];
+    }
+  });
+
+  // Number the first occurrences in input order.
+  std::vector<TIndex> block_begin(num_blocks + 1);
+  parallel_for(num_blocks, [&](int64_t b) {
+    const int32 end = std::min<int64_t>(N, (b + 1) * block_size);
+    for (int32 i = b * block_size; i < end; ++i) {
+      block_begin[b + 1] += idx_vec(i);
+    }
+  });
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    block_begin[b + 1] += block_begin[b];
+  }
+  parallel_for(num_blocks, [&](int64_t b) {
+    TIndex id = block_begin[b];
+    const int32 end = std::min<int64_t>(N, (b + 1) * block_size);
+    for (int32 i = b * block_size; i < end; ++i) {
+      if (idx_vec(i)) idx_vec(i) = id++;
+    }
+  });
+
+  const int64_t uniq_size = block_begin[num_blocks];
+  output_shape.set_dim(axis, uniq_size);
+  Tensor* output = nullptr;
+  OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+  auto Tout = output->flat<T>();
+  TIndex* count_data = nullptr;
+  if (with_counts) {
+    Tensor* count_output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(2, TensorShape({uniq_size}),
+                                            &count_output));
+    count_data = count_output->vec<TIndex>().data();
+  }
+
+  // Write the unique elements and the ids of all the elements.
+  parallel_for(num_partitions, [&](int64_t p) {
+    std::vector<TIndex> ids(first_positions[p].size());
+    for (size_t k = 0; k < ids.size(); ++k) {
+      const int32 i = first_positions[p][k];
+      ids[k] = idx_vec(i);
+      Tout(ids[k]) = Tin(i);
+      if (with_counts) count_data[ids[k]] = counts[p][k];
+    }
+    for (int32 j = partition_begin[p]; j < partition_begin[p + 1]; ++j) {
+      idx_vec(positions[j]) = ids[local_ids[j]];
+    }
+  });
+}
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -150,6 +305,16 @@ class UniqueOp : public OpKernel {
       auto Tin = input.flat<T>();
       const int64_t N = static_cast<int64_t>(Tin.size());
 
+      if constexpr (kHasParallelUnique<T>) {
+        if (N >= kParallelUniqueMinSize &&
+            context->device()->tensorflow_cpu_worker_threads()->num_threads >
+                1) {
+          ParallelUnique<T, TIndex>(context, Tin, input.shape(), axis,
+                                    idx_vec);
+          return;
+        }
+      }
+
       typename UniqueOpHashMap<T, TIndex>::map_type uniq;
       uniq.reserve(2 * N);
       for (Eigen::Index i = 0, j = 0; i < N; ++i) {
@@ -0,0 +1,252 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/shard_cost_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+ShardCostModelMode ModeFromEnvironment() {
+  string mode;
+  if (!ReadStringFromEnvVar("TF_WORK_SHARDER_COST_MODEL", "static", &mode)
+           .ok()) {
+    return ShardCostModelMode::kStatic;
+  }
+  if (mode == "calibrate") return ShardCostModelMode::kCalibrate;
+  if (mode == "calibrated") return ShardCostModelMode::kCalibrated;
+  if (mode != "static") {
+    LOG(WARNING) << "Ignoring unknown TF_WORK_SHARDER_COST_MODEL: " << mode;
+  }
+  return ShardCostModelMode::kStatic;
+}
+
+std::atomic<int>* Mode() {
+  static std::atomic<int>* mode =
+      new std::atomic<int>(static_cast<int>(ModeFromEnvironment()));
+  return mode;
+}
+
+int BlockSizeBucket(int64_t block_size) {
+  return Log2Floor64(std::max<int64_t>(block_size, 1));
+}
+
+}  // namespace
+
+void SetShardCostModelMode(ShardCostModelMode mode) {
+  Mode()->store(static_cast<int>(mode), std::memory_order_relaxed);
+}
+
+ShardCostModelMode GetShardCostModelMode() {
+  return static_cast<ShardCostModelMode>(
+      Mode()->load(std::memory_order_relaxed));
+}
+
+/* ABSL_CONST_INIT */ thread_local absl::string_view per_thread_shard_cost_key;
+/* ABSL_CONST_INIT */ thread_local absl::string_view per_thread_shard_cost_tag;
+/* ABSL_CONST_INIT */ thread_local int per_thread_shard_call_index = 0;
+
+void SetPerThreadShardCostKey(absl::string_view key) {
+  per_thread_shard_cost_key = key;
+}
+
+absl::string_view GetPerThreadShardCostKey() {
+  return per_thread_shard_cost_key;
+}
+
+ScopedPerThreadShardCostKey::ScopedPerThreadShardCostKey(
+    absl::string_view key)
+    : previous_key_(per_thread_shard_cost_key),
+      previous_call_index_(per_thread_shard_call_index) {
+  per_thread_shard_cost_key = key;
+  per_thread_shard_call_index = 0;
+}
+
+ScopedPerThreadShardCostKey::~ScopedPerThreadShardCostKey() {
+  per_thread_shard_cost_key = previous_key_;
+  per_thread_shard_call_index = previous_call_index_;
+}
+
+ScopedShardCostTag::ScopedShardCostTag(absl::string_view tag)
+    : previous_(per_thread_shard_cost_tag) {
+  per_thread_shard_cost_tag = tag;
+}
+
+ScopedShardCostTag::~ScopedShardCostTag() {
+  per_thread_shard_cost_tag = previous_;
+}
+
+string ShardCostKey(absl::string_view op_type,
+                    absl::Span<const TensorShape* const> input_shapes) {
+  string key(op_type);
+  for (const TensorShape* shape : input_shapes) {
+    key.push_back('[');
+    for (int d = 0; d < shape->dims(); ++d) {
+      const int64_t dim = shape->dim_size(d);
+      absl::StrAppend(&key, d > 0 ? "," : "",
+                      dim > 0 ? static_cast<int64_t>(NextPowerOfTwo64(dim))
+                              : dim);
+    }
+    key.push_back(']');
+  }
+  return key;
+}
+
+string NextShardCallCostKey() {
+  if (per_thread_shard_cost_key.empty()) return "";
+  const int call_index = per_thread_shard_call_index++;
+  if (!per_thread_shard_cost_tag.empty()) {
+    return absl::StrCat(per_thread_shard_cost_key, "#",
+                        per_thread_shard_cost_tag);
+  }
+  return absl::StrCat(per_thread_shard_cost_key, "#", call_index);
+}
+
+ShardCostTable* ShardCostTable::Global() {
+  static ShardCostTable* table = []() {
+    auto* table = new ShardCostTable;
+    string fname;
+    if (ReadStringFromEnvVar("TF_WORK_SHARDER_COST_TABLE", "", &fname).ok() &&
+        !fname.empty()) {
+      const Status s = table->MergeFromFile(Env::Default(), fname);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to load work sharder cost table from " << fname
+                     << ": " << s;
+      }
+    }
+    return table;
+  }();
+  return table;
+}
+
+void ShardCostTable::Record(absl::string_view key, int64_t units,
+                            int64_t nanos) {
+  if (units <= 0 || nanos < 0) return;
+  mutex_lock l(mu_);
+  Entry& entry = entries_[string(key)][BlockSizeBucket(units)];
+  entry.units += units;
+  entry.nanos += nanos;
+}
+
+int64_t ShardCostTable::CostPerUnit(absl::string_view key,
+                                    int64_t block_size) const {
+  tf_shared_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second.empty()) return -1;
+  const BlockSizeEntries& buckets = it->second;
+
+  // Pick the closest measured bucket, preferring the smaller block size on
+  // ties since it has the higher, more conservative per-unit cost.
+  const int bucket = BlockSizeBucket(block_size);
+  auto upper = buckets.lower_bound(bucket);
+  auto best = upper;
+  if (upper == buckets.end()) {
+    best = std::prev(upper);
+  } else if (upper->first != bucket && upper != buckets.begin()) {
+    auto lower = std::prev(upper);
+    if (bucket - lower->first <= upper->first - bucket) best = lower;
+  }
+  const Entry& entry = best->second;
+  return std::max<int64_t>(1, entry.nanos / entry.units);
+}
+
+bool ShardCostTable::empty() const {
+  tf_shared_lock l(mu_);
+  return entries_.empty();
+}
+
+void ShardCostTable::Clear() {
+  mutex_lock l(mu_);
+  entries_.clear();
+}
+
+string ShardCostTable::ToString() const {
+  tf_shared_lock l(mu_);
+  std::vector<string> keys;
+  keys.reserve(entries_.size());
+  for (const auto& it : entries_) keys.push_back(it.first);
+  std::sort(keys.begin(), keys.end());
+
+  string text;
+  for (const string& key : keys) {
+    for (const auto& bucket : entries_.at(key)) {
+      absl::StrAppend(&text, key, " ", bucket.first, " ",
+                      bucket.second.units, " ", bucket.second.nanos, "\n");
+    }
+  }
+  return text;
+}
+
+Status ShardCostTable::MergeFromString(absl::string_view text) {
+  struct Line {
+    string key;
+    int bucket;
+    Entry entry;
+  };
+  std::vector<Line> lines;
+  int line_number = 0;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    ++line_number;
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty() || line[0] == '#') continue;
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, ' ', absl::SkipEmpty());
+    Line parsed;
+    if (fields.size() != 4 || !absl::SimpleAtoi(fields[1], &parsed.bucket) ||
+        !absl::SimpleAtoi(fields[2], &parsed.entry.units) ||
+        !absl::SimpleAtoi(fields[3], &parsed.entry.nanos) ||
+        parsed.bucket < 0 || parsed.bucket >= 64 || parsed.entry.units <= 0 ||
+        parsed.entry.nanos < 0) {
+      return errors::InvalidArgument("Malformed shard cost table line ",
+                                     line_number, ": \"", line, "\"");
+    }
+    parsed.key = string(fields[0]);
+    lines.push_back(std::move(parsed));
+  }
+
+  mutex_lock l(mu_);
+  for (const Line& line : lines) {
+    Entry& entry = entries_[line.key][line.bucket];
+    entry.units += line.entry.units;
+    entry.nanos += line.entry.nanos;
+  }
+  return OkStatus();
+}
+
+Status ShardCostTable::WriteToFile(Env* env, const string& fname) const {
+  return WriteStringToFile(env, fname, ToString());
+}
+
+Status ShardCostTable::MergeFromFile(Env* env, const string& fname) {
+  string text;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, fname, &text));
+  return MergeFromString(text);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_SHARD_COST_TABLE_H_
+#define TENSORFLOW_CORE_UTIL_SHARD_COST_TABLE_H_
+
+#include <map>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// How Shard() obtains the cost of one unit of work.
+enum class ShardCostModelMode {
+  // Use the `cost_per_unit` passed by the caller.
+  kStatic = 0,
+  // Use the `cost_per_unit` passed by the caller, and record the measured
+  // duration of every shard in `ShardCostTable::Global()`.
+  kCalibrate = 1,
+  // Use the cost measured for the Shard() call in `ShardCostTable::Global()`
+  // if there is one, and the `cost_per_unit` passed by the caller otherwise.
+  kCalibrated = 2,
+};
+
+// The mode defaults to the value of the TF_WORK_SHARDER_COST_MODEL
+// environment variable ("static", "calibrate" or "calibrated"), or kStatic.
+void SetShardCostModelMode(ShardCostModelMode mode);
+ShardCostModelMode GetShardCostModelMode();
+
+// Each thread has an associated key that identifies the kernel invocation on
+// whose behalf Shard() is called, e.g. the op type and the shape buckets of
+// its inputs (see `ShardCostKey()`). Its default is empty, in which case
+// Shard() neither records nor looks up costs. `key` must outlive its use as
+// the per-thread key, and must not contain whitespace.
+void SetPerThreadShardCostKey(absl::string_view key);
+absl::string_view GetPerThreadShardCostKey();
+
+// Helper to set and unset the per-thread shard cost key. Shard() calls made
+// in its scope are numbered from 0, so that the call sites of a kernel are
+// measured separately.
+class ScopedPerThreadShardCostKey {
+ public:
+  explicit ScopedPerThreadShardCostKey(absl::string_view key);
+  ~ScopedPerThreadShardCostKey();
+
+ private:
+  absl::string_view previous_key_;
+  int previous_call_index_;
+};
+
+// Names the call site of the Shard() calls made in its scope, for kernels
+// whose sequence of Shard() calls depends on their inputs, which makes the
+// call index an unreliable identifier. `tag` must outlive the scope, and must
+// not contain whitespace.
+class ScopedShardCostTag {
+ public:
+  explicit ScopedShardCostTag(absl::string_view tag);
+  ~ScopedShardCostTag();
+
+ private:
+  absl::string_view previous_;
+};
+
+// Returns the per-thread key of an invocation of an `op_type` kernel on inputs
+// of the given shapes. Dimensions are rounded up to powers of two so that
+// similar shapes share their measurements, e.g. "MatMul[64,128][128,32]".
+string ShardCostKey(absl::string_view op_type,
+                    absl::Span<const TensorShape* const> input_shapes);
+
+// Returns the table key of the next Shard() call of this thread: the
+// per-thread key, followed by the tag of the enclosing `ScopedShardCostTag`,
+// or by the index of the call in the scope of the key. Returns an empty
+// string if the thread has no key.
+string NextShardCallCostKey();
+
+// Measured per-unit costs of Shard() work functions, keyed by Shard() call
+// (see `NextShardCallCostKey()`) and by block size, rounded down to a power of
+// two. The per-unit cost of a call usually decreases with the block size, as
+// fixed per-shard overheads are amortized, so costs are looked up for the
+// block size Shard() is about to use.
+//
+// The table is persisted as text, one "<key> <log2 block size> <units>
+// <nanos>" line per entry. Merging a file adds its measurements to those
+// already in the table.
+class ShardCostTable {
+ public:
+  ShardCostTable() = default;
+
+  // Returns the table used by Shard(). If TF_WORK_SHARDER_COST_TABLE is set,
+  // the table is initially loaded from that file.
+  static ShardCostTable* Global();
+
+  // Records that one shard of the Shard() call `key` took `nanos` to process
+  // `units`.
+  void Record(absl::string_view key, int64_t units, int64_t nanos);
+
+  // Returns the measured cost in nanoseconds of one unit of work of the
+  // Shard() call `key` when processed in blocks of `block_size` units, using
+  // the nearest block size measured. Returns -1 if `key` has not been
+  // measured.
+  int64_t CostPerUnit(absl::string_view key, int64_t block_size) const;
+
+  bool empty() const;
+  void Clear();
+
+  string ToString() const;
+  Status MergeFromString(absl::string_view text);
+
+  Status WriteToFile(Env* env, const string& fname) const;
+  Status MergeFromFile(Env* env, const string& fname);
+
+ private:
+  struct Entry {
+    int64_t units = 0;
+    int64_t nanos = 0;
+  };
+  // Indexed by log2 of the block size.
+  using BlockSizeEntries = std::map<int, Entry>;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<string, BlockSizeEntries> entries_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostTable);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_SHARD_COST_TABLE_H_
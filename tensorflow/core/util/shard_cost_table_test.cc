@@ -0,0 +1,168 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/shard_cost_table.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ShardCostTableTest, RecordAndLookup) {
+  ShardCostTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.CostPerUnit("Op", 100), -1);
+
+  // Block sizes 16..31 share a bucket.
+  table.Record("Op", 16, 1600);
+  table.Record("Op", 20, 2400);
+  EXPECT_EQ(table.CostPerUnit("Op", 16), 111);
+  EXPECT_EQ(table.CostPerUnit("Op", 31), 111);
+
+  table.Record("Op", 1024, 10240);
+  EXPECT_EQ(table.CostPerUnit("Op", 1024), 10);
+  // The nearest bucket wins, and the smaller one on ties.
+  EXPECT_EQ(table.CostPerUnit("Op", 2048), 10);
+  EXPECT_EQ(table.CostPerUnit("Op", 128), 111);
+  EXPECT_EQ(table.CostPerUnit("Op", 1), 111);
+  EXPECT_EQ(table.CostPerUnit("OtherOp", 16), -1);
+
+  table.Clear();
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(ShardCostTableTest, RoundTrip) {
+  ShardCostTable table;
+  table.Record("B", 8, 80);
+  table.Record("A", 1000, 500);
+  EXPECT_EQ(table.ToString(), "A 9 1000 500\nB 3 8 80\n");
+
+  const string fname = io::JoinPath(testing::TmpDir(), "shard_cost_table");
+  TF_ASSERT_OK(table.WriteToFile(Env::Default(), fname));
+  ShardCostTable loaded;
+  TF_ASSERT_OK(loaded.MergeFromFile(Env::Default(), fname));
+  EXPECT_EQ(loaded.ToString(), table.ToString());
+
+  // Merging adds to the existing measurements.
+  TF_ASSERT_OK(loaded.MergeFromString("# comment\n\nB 3 8 240\n"));
+  EXPECT_EQ(loaded.CostPerUnit("B", 8), 20);
+}
+
+TEST(ShardCostTableTest, Malformed) {
+  ShardCostTable table;
+  EXPECT_TRUE(errors::IsInvalidArgument(table.MergeFromString("A 1 2\n")));
+  EXPECT_TRUE(errors::IsInvalidArgument(table.MergeFromString("A x 2 3\n")));
+  EXPECT_TRUE(errors::IsInvalidArgument(table.MergeFromString("A 1 0 3\n")));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(table.MergeFromString("A 1 1 1\nA 1 -1 3\n")));
+  // Nothing is merged from a malformed input.
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(ShardCostTableTest, ShardCostKey) {
+  const TensorShape matrix({60, 128});
+  const TensorShape empty({100, 0});
+  const TensorShape scalar;
+  EXPECT_EQ(ShardCostKey("MatMul", {&matrix, &empty, &scalar}),
+            "MatMul[64,128][128,0][]");
+  // Similar shapes share their key.
+  const TensorShape similar({33, 100});
+  EXPECT_EQ(ShardCostKey("MatMul", {&similar}),
+            ShardCostKey("MatMul", {&matrix}));
+}
+
+class ShardCostModelModeTest : public ::testing::Test {
+ protected:
+  ShardCostModelModeTest() : previous_mode_(GetShardCostModelMode()) {
+    ShardCostTable::Global()->Clear();
+  }
+  ~ShardCostModelModeTest() override {
+    SetShardCostModelMode(previous_mode_);
+    ShardCostTable::Global()->Clear();
+  }
+
+ private:
+  const ShardCostModelMode previous_mode_;
+};
+
+int CountShards(thread::ThreadPool* threads, int64_t total,
+                int64_t cost_per_unit) {
+  std::atomic<int> num_shards(0);
+  Shard(threads->NumThreads(), threads, total, cost_per_unit,
+        [&num_shards](int64_t start, int64_t limit) { ++num_shards; });
+  return num_shards.load();
+}
+
+TEST_F(ShardCostModelModeTest, CalibrateRecordsShards) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  SetShardCostModelMode(ShardCostModelMode::kCalibrate);
+
+  // Nothing is recorded without a key.
+  CountShards(&threads, 1000, 1000);
+  EXPECT_TRUE(ShardCostTable::Global()->empty());
+
+  ScopedPerThreadShardCostKey key("TestOp");
+  CountShards(&threads, 1000, 1000);
+  EXPECT_GT(ShardCostTable::Global()->CostPerUnit("TestOp#0", 250), 0);
+}
+
+TEST_F(ShardCostModelModeTest, CallSitesAreMeasuredSeparately) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  SetShardCostModelMode(ShardCostModelMode::kCalibrate);
+  {
+    ScopedPerThreadShardCostKey key("TestOp");
+    CountShards(&threads, 1000, 1000);
+    CountShards(&threads, 1000, 1000);
+    ScopedShardCostTag tag("rows");
+    CountShards(&threads, 1000, 1000);
+  }
+  // Each invocation numbers its calls from 0.
+  ScopedPerThreadShardCostKey key("TestOp");
+  CountShards(&threads, 1000, 1000);
+
+  EXPECT_EQ(ShardCostTable::Global()->CostPerUnit("TestOp", 250), -1);
+  EXPECT_GT(ShardCostTable::Global()->CostPerUnit("TestOp#0", 250), 0);
+  EXPECT_GT(ShardCostTable::Global()->CostPerUnit("TestOp#1", 250), 0);
+  EXPECT_GT(ShardCostTable::Global()->CostPerUnit("TestOp#rows", 250), 0);
+  EXPECT_EQ(ShardCostTable::Global()->CostPerUnit("TestOp#2", 250), -1);
+}
+
+TEST_F(ShardCostModelModeTest, CalibratedAvoidsOverParallelizing) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  ScopedPerThreadShardCostKey key("TestOp");
+
+  // A stale cost makes 64 trivial units look worth splitting.
+  SetShardCostModelMode(ShardCostModelMode::kStatic);
+  EXPECT_GT(CountShards(&threads, 64, 100000), 1);
+
+  TF_ASSERT_OK(
+      ShardCostTable::Global()->MergeFromString("TestOp#0 4 16 16\n"));
+  SetShardCostModelMode(ShardCostModelMode::kCalibrated);
+  EXPECT_EQ(CountShards(&threads, 64, 100000), 1);
+
+  // Kernels without measurements keep their own cost.
+  ScopedPerThreadShardCostKey other_key("OtherOp");
+  EXPECT_GT(CountShards(&threads, 64, 100000), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
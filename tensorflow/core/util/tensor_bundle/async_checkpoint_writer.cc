@@ -0,0 +1,215 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace {
+
+// Alignment of the tensors in a staging buffer.
+constexpr int64_t kStagingAlignment = Allocator::kAllocatorAlignment;
+
+int64_t AlignStagingOffset(int64_t offset) {
+  return (offset + kStagingAlignment - 1) / kStagingAlignment *
+         kStagingAlignment;
+}
+
+// The writer whose jobs the current thread runs, if any.
+thread_local const AsyncCheckpointWriter* running_writer = nullptr;
+
+void WaitForGlobalWriterAtExit() {
+  const Status status = AsyncCheckpointWriter::Global()->WaitForAll();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to write checkpoints before exiting: " << status;
+  }
+}
+
+}  // namespace
+
+AsyncCheckpointWriter::AsyncCheckpointWriter(Env* env, int max_pending_jobs)
+    : env_(env), max_pending_jobs_(std::max(max_pending_jobs, 1)) {}
+
+AsyncCheckpointWriter::~AsyncCheckpointWriter() {
+  std::unique_ptr<Thread> thread;
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+    jobs_changed_.notify_all();
+    thread = std::move(thread_);
+  }
+  // Joins the thread once it has run all jobs.
+  thread.reset();
+}
+
+AsyncCheckpointWriter* AsyncCheckpointWriter::Global() {
+  static AsyncCheckpointWriter* writer = []() {
+    auto* writer = new AsyncCheckpointWriter(Env::Default());
+    std::atexit(WaitForGlobalWriterAtExit);
+    return writer;
+  }();
+  return writer;
+}
+
+std::vector<Tensor> AsyncCheckpointWriter::Snapshot(
+    gtl::ArraySlice<Tensor> tensors) {
+  int64_t staging_bytes = 0;
+  for (const Tensor& tensor : tensors) {
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      staging_bytes = AlignStagingOffset(staging_bytes) + tensor.TotalBytes();
+    }
+  }
+  Tensor staging(cpu_allocator(), DT_INT8, TensorShape({staging_bytes}));
+
+  std::vector<Tensor> snapshot;
+  snapshot.reserve(tensors.size());
+  int64_t offset = 0;
+  for (const Tensor& tensor : tensors) {
+    if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+      snapshot.push_back(tensor::DeepCopy(tensor));
+      continue;
+    }
+    offset = AlignStagingOffset(offset);
+    const int64_t size = tensor.TotalBytes();
+    Tensor staged;
+    TF_CHECK_OK(staged.BitcastFrom(staging.Slice(offset, offset + size),
+                                   tensor.dtype(), tensor.shape()));
+    if (size > 0) {
+      std::memcpy(const_cast<char*>(staged.tensor_data().data()),
+                  tensor.tensor_data().data(), size);
+    }
+    snapshot.push_back(std::move(staged));
+    offset += size;
+  }
+  return snapshot;
+}
+
+Status AsyncCheckpointWriter::Schedule(const string& prefix,
+                                       std::function<Status()> job) {
+  mutex_lock l(mu_);
+  while (num_pending_jobs_ >= max_pending_jobs_) jobs_changed_.wait(l);
+  if (thread_ == nullptr) {
+    thread_.reset(env_->StartThread(ThreadOptions(), "async_checkpoint_writer",
+                                    [this]() { RunJobs(); }));
+  }
+  jobs_.push_back({prefix, std::move(job)});
+  ++num_pending_jobs_;
+  ++num_pending_by_prefix_[prefix];
+  jobs_changed_.notify_all();
+  return OkStatus();
+}
+
+void AsyncCheckpointWriter::RunJobs() {
+  running_writer = this;
+  while (true) {
+    Job job;
+    {
+      mutex_lock l(mu_);
+      while (jobs_.empty() && !stopping_) jobs_changed_.wait(l);
+      if (jobs_.empty()) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    VLOG(1) << "Writing checkpoint " << job.prefix;
+    const Status status = job.run();
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to write checkpoint " << job.prefix << ": "
+                 << status;
+    }
+
+    mutex_lock l(mu_);
+    if (!status.ok()) errors_[job.prefix].Update(status);
+    --num_pending_jobs_;
+    if (--num_pending_by_prefix_[job.prefix] == 0) {
+      num_pending_by_prefix_.erase(job.prefix);
+    }
+    jobs_changed_.notify_all();
+  }
+}
+
+Status AsyncCheckpointWriter::ScheduleWriteFileAfter(const string& prefix,
+                                                     const string& filename,
+                                                     const string& contents,
+                                                     bool* scheduled) {
+  {
+    mutex_lock l(mu_);
+    *scheduled = num_pending_by_prefix_.contains(prefix) ||
+                 num_pending_by_prefix_.contains(filename);
+  }
+  if (!*scheduled) return OkStatus();
+  return Schedule(filename, [this, prefix, filename, contents]() {
+    const Status error = GetError(prefix);
+    if (!error.ok()) {
+      return errors::Aborted("Not writing ", filename, ": writing checkpoint ",
+                             prefix, " failed: ", error.message());
+    }
+    const string temp_filename =
+        strings::StrCat(filename, ".tmp", strings::Hex(random::New64()));
+    TF_RETURN_IF_ERROR(WriteStringToFile(env_, temp_filename, contents));
+    const Status status = env_->RenameFile(temp_filename, filename);
+    if (!status.ok()) env_->DeleteFile(temp_filename).IgnoreError();
+    return status;
+  });
+}
+
+bool AsyncCheckpointWriter::IsPending(const string& prefix) const {
+  mutex_lock l(mu_);
+  return num_pending_by_prefix_.contains(prefix);
+}
+
+Status AsyncCheckpointWriter::Wait(const string& prefix) {
+  mutex_lock l(mu_);
+  // Waiting from a job would wait for the job itself.
+  while (running_writer != this && num_pending_by_prefix_.contains(prefix)) {
+    jobs_changed_.wait(l);
+  }
+  auto it = errors_.find(prefix);
+  if (it == errors_.end()) return OkStatus();
+  const Status error = it->second;
+  errors_.erase(it);
+  return error;
+}
+
+Status AsyncCheckpointWriter::WaitForAll() {
+  mutex_lock l(mu_);
+  while (running_writer != this && num_pending_jobs_ > 0) {
+    jobs_changed_.wait(l);
+  }
+  Status status;
+  for (const auto& it : errors_) status.Update(it.second);
+  errors_.clear();
+  return status;
+}
+
+Status AsyncCheckpointWriter::GetError(const string& prefix) const {
+  mutex_lock l(mu_);
+  auto it = errors_.find(prefix);
+  return it == errors_.end() ? OkStatus() : it->second;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,140 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Writes checkpoints from a background thread, so that a save only blocks its
+// caller for as long as it takes to snapshot the tensors to save.
+//
+// Jobs run one at a time, in the order they were scheduled, so a job that
+// reads checkpoints written by earlier jobs (e.g. merging sharded saves) can be
+// scheduled right after them. Each job is associated with the prefix of the
+// checkpoint it produces, and readers of a checkpoint must call Wait() on its
+// prefix first: BundleReader, CheckpointReader and RestoreV2 do so for the
+// Global() writer. The Python checkpoint state file is written by a job too
+// (see ScheduleWriteFileAfter()), so that it only names written checkpoints.
+//
+// Jobs finalize a checkpoint by writing its index last, through a temporary
+// file and a rename on file systems with atomic moves (see
+// BundleWriter::Finish() and MergeBundles()). On other file systems a partially
+// written checkpoint can be observed by readers that do not wait.
+//
+// The Global() writer waits for its pending jobs when the process exits
+// normally; jobs of other writers are waited for by their destructor.
+class AsyncCheckpointWriter {
+ public:
+  // At most "max_pending_jobs" jobs are pending at any time, including the
+  // running one, which bounds the memory held by snapshots.
+  explicit AsyncCheckpointWriter(Env* env, int max_pending_jobs = 2);
+
+  // Waits for all jobs to finish.
+  ~AsyncCheckpointWriter();
+
+  // The writer used by the SaveV2 and MergeV2Checkpoints ops.
+  static AsyncCheckpointWriter* Global();
+
+  // Returns copies of "tensors" that remain unchanged when the originals are
+  // updated in place. The copies of tensors of memcpy-able dtypes share a
+  // single staging buffer.
+  //
+  // The tensors are copied in full rather than copy-on-write: a kernel cannot
+  // tell whether its inputs alias a reference variable, which is updated in
+  // place without copying. Each pending job thus holds a copy of the tensors
+  // it saves in host memory, i.e. up to "max_pending_jobs" times the size of
+  // the checkpoint on top of the variables.
+  static std::vector<Tensor> Snapshot(gtl::ArraySlice<Tensor> tensors);
+
+  // Runs "job", which writes the checkpoint at "prefix", from the background
+  // thread after all previously scheduled jobs. Blocks while too many jobs are
+  // pending. The error of the job is reported by Wait("prefix") or
+  // WaitForAll() only.
+  Status Schedule(const string& prefix, std::function<Status()> job);
+
+  // Writes "contents" to "filename", e.g. the checkpoint state naming the
+  // checkpoint at "prefix", from a job that runs once the pending jobs writing
+  // "prefix" have finished, so that the caller does not wait for them. The
+  // file is not written if they failed, and is replaced through a temporary
+  // file and a rename.
+  //
+  // Sets "*scheduled" to false, without scheduling anything, if no job writing
+  // "prefix" or "filename" is pending: the file can then be written directly.
+  Status ScheduleWriteFileAfter(const string& prefix, const string& filename,
+                                const string& contents, bool* scheduled);
+
+  // Returns whether a job writing the checkpoint at "prefix" is pending.
+  bool IsPending(const string& prefix) const;
+
+  // Waits for the jobs writing the checkpoint at "prefix" to finish, and
+  // returns their unreported errors. When called from a job, e.g. by the
+  // BundleReader of a merge, returns without waiting: the jobs scheduled
+  // before it have finished already.
+  Status Wait(const string& prefix);
+
+  // Waits for all jobs to finish, and returns their unreported errors. Like
+  // Wait(), does not wait when called from a job.
+  Status WaitForAll();
+
+  // Returns the unreported errors of the finished jobs writing "prefix",
+  // without reporting them.
+  Status GetError(const string& prefix) const;
+
+ private:
+  struct Job {
+    string prefix;
+    std::function<Status()> run;
+  };
+
+  void RunJobs();
+
+  Env* const env_;
+  const int max_pending_jobs_;
+
+  mutable mutex mu_;
+  condition_variable jobs_changed_;
+  std::deque<Job> jobs_ TF_GUARDED_BY(mu_);
+  // Number of pending jobs, including the running one.
+  int num_pending_jobs_ TF_GUARDED_BY(mu_) = 0;
+  // Number of pending jobs writing each prefix.
+  absl::flat_hash_map<string, int> num_pending_by_prefix_ TF_GUARDED_BY(mu_);
+  // Errors of finished jobs not reported yet, by prefix.
+  absl::flat_hash_map<string, Status> errors_ TF_GUARDED_BY(mu_);
+  bool stopping_ TF_GUARDED_BY(mu_) = false;
+  // Started by the first call to Schedule().
+  std::unique_ptr<Thread> thread_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncCheckpointWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_ASYNC_CHECKPOINT_WRITER_H_
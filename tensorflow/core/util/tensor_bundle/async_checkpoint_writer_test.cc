@@ -0,0 +1,163 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(AsyncCheckpointWriterTest, Snapshot) {
+  std::vector<Tensor> tensors = {
+      test::AsTensor<float>({1, 2, 3}), test::AsTensor<int64_t>({4, 5}),
+      test::AsTensor<tstring>({"a", "b"}), test::AsTensor<bool>({true}),
+      Tensor(DT_FLOAT, TensorShape({0}))};
+  std::vector<Tensor> snapshot = AsyncCheckpointWriter::Snapshot(tensors);
+  ASSERT_EQ(snapshot.size(), tensors.size());
+
+  // Updating the originals in place leaves the snapshot unchanged.
+  tensors[0].flat<float>()(0) = 10;
+  tensors[1].flat<int64_t>()(1) = 50;
+  tensors[2].flat<tstring>()(0) = "c";
+  test::ExpectTensorEqual<float>(snapshot[0], test::AsTensor<float>({1, 2, 3}));
+  test::ExpectTensorEqual<int64_t>(snapshot[1],
+                                   test::AsTensor<int64_t>({4, 5}));
+  test::ExpectTensorEqual<tstring>(snapshot[2],
+                                   test::AsTensor<tstring>({"a", "b"}));
+  test::ExpectTensorEqual<bool>(snapshot[3], test::AsTensor<bool>({true}));
+  EXPECT_EQ(snapshot[4].NumElements(), 0);
+  for (const Tensor& t : snapshot) EXPECT_TRUE(t.IsAligned());
+}
+
+TEST(AsyncCheckpointWriterTest, RunsJobsInOrder) {
+  AsyncCheckpointWriter writer(Env::Default(), /*max_pending_jobs=*/4);
+  Notification start;
+  std::vector<int> order;
+  TF_ASSERT_OK(writer.Schedule("a", [&]() {
+    start.WaitForNotification();
+    order.push_back(0);
+    return OkStatus();
+  }));
+  TF_ASSERT_OK(writer.Schedule("b", [&]() {
+    order.push_back(1);
+    return OkStatus();
+  }));
+  EXPECT_TRUE(writer.IsPending("a"));
+  EXPECT_TRUE(writer.IsPending("b"));
+  EXPECT_FALSE(writer.IsPending("c"));
+
+  start.Notify();
+  TF_EXPECT_OK(writer.Wait("b"));
+  EXPECT_FALSE(writer.IsPending("a"));
+  EXPECT_EQ(order, std::vector<int>({0, 1}));
+  TF_EXPECT_OK(writer.WaitForAll());
+}
+
+TEST(AsyncCheckpointWriterTest, ReportsErrors) {
+  AsyncCheckpointWriter writer(Env::Default());
+  TF_ASSERT_OK(
+      writer.Schedule("a", []() { return errors::Internal("write failed"); }));
+  EXPECT_TRUE(errors::IsInternal(writer.Wait("a")));
+  // Errors are only reported once.
+  TF_EXPECT_OK(writer.Wait("a"));
+
+  TF_ASSERT_OK(
+      writer.Schedule("b", []() { return errors::Internal("write failed"); }));
+  while (writer.IsPending("b")) Env::Default()->SleepForMicroseconds(100);
+  // The error of "b" is only reported for "b".
+  bool ran = false;
+  TF_ASSERT_OK(writer.Schedule("c", [&ran]() {
+    ran = true;
+    return OkStatus();
+  }));
+  TF_EXPECT_OK(writer.Wait("c"));
+  EXPECT_TRUE(ran);
+  EXPECT_TRUE(errors::IsInternal(writer.GetError("b")));
+  EXPECT_TRUE(errors::IsInternal(writer.WaitForAll()));
+  TF_EXPECT_OK(writer.Wait("b"));
+}
+
+TEST(AsyncCheckpointWriterTest, WritesFileAfterCheckpoint) {
+  Env* env = Env::Default();
+  const string filename = io::JoinPath(testing::TmpDir(), "checkpoint_state");
+  AsyncCheckpointWriter writer(env);
+
+  // Nothing is scheduled when the checkpoint has been written.
+  bool scheduled = true;
+  TF_ASSERT_OK(writer.ScheduleWriteFileAfter("a", filename, "a", &scheduled));
+  EXPECT_FALSE(scheduled);
+
+  Notification start;
+  TF_ASSERT_OK(writer.Schedule("b", [&start]() {
+    start.WaitForNotification();
+    return OkStatus();
+  }));
+  TF_ASSERT_OK(writer.ScheduleWriteFileAfter("b", filename, "b", &scheduled));
+  EXPECT_TRUE(scheduled);
+  EXPECT_TRUE(errors::IsNotFound(env->FileExists(filename)));
+  start.Notify();
+  TF_ASSERT_OK(writer.Wait(filename));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, filename, &contents));
+  EXPECT_EQ(contents, "b");
+
+  // The file is not written when the checkpoint is not.
+  TF_ASSERT_OK(
+      writer.Schedule("c", []() { return errors::Internal("write failed"); }));
+  TF_ASSERT_OK(writer.ScheduleWriteFileAfter("c", filename, "c", &scheduled));
+  EXPECT_TRUE(scheduled);
+  EXPECT_TRUE(errors::IsAborted(writer.Wait(filename)));
+  EXPECT_TRUE(errors::IsInternal(writer.Wait("c")));
+  TF_ASSERT_OK(ReadFileToString(env, filename, &contents));
+  EXPECT_EQ(contents, "b");
+}
+
+TEST(AsyncCheckpointWriterTest, JobsDoNotWaitForThemselves) {
+  AsyncCheckpointWriter writer(Env::Default());
+  TF_ASSERT_OK(writer.Schedule("a", []() { return OkStatus(); }));
+  TF_ASSERT_OK(writer.Schedule("b", [&writer]() {
+    // "a" has finished already.
+    EXPECT_FALSE(writer.IsPending("a"));
+    TF_RETURN_IF_ERROR(writer.Wait("a"));
+    TF_RETURN_IF_ERROR(writer.Wait("b"));
+    return writer.WaitForAll();
+  }));
+  TF_EXPECT_OK(writer.Wait("b"));
+}
+
+TEST(AsyncCheckpointWriterTest, DestructorWaitsForJobs) {
+  bool ran = false;
+  {
+    AsyncCheckpointWriter writer(Env::Default());
+    TF_ASSERT_OK(writer.Schedule("a", [&ran]() {
+      Env::Default()->SleepForMicroseconds(1000);
+      ran = true;
+      return OkStatus();
+    }));
+  }
+  EXPECT_TRUE(ran);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,136 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+SharedTensorStore* SharedTensorStore::Global() {
+  static SharedTensorStore* store = new SharedTensorStore;
+  return store;
+}
+
+SharedTensorStore::Registration::~Registration() {
+  store_->Unregister(prefix_);
+}
+
+std::unique_ptr<SharedTensorStore::Registration>
+SharedTensorStore::RegisterCheckpoint(const string& prefix,
+                                      const string& fingerprint) {
+  mutex_lock l(mu_);
+  CheckpointInfo& info = checkpoints_[prefix];
+  if (info.num_registrations == 0) {
+    info.fingerprint = fingerprint;
+  } else if (info.fingerprint != fingerprint) {
+    LOG(WARNING) << "Checkpoint " << prefix
+                 << " registered with conflicting fingerprints " << fingerprint
+                 << " and " << info.fingerprint
+                 << "; not sharing its tensors.";
+    info.conflicting = true;
+  }
+  ++info.num_registrations;
+  return std::unique_ptr<Registration>(new Registration(this, prefix));
+}
+
+void SharedTensorStore::Unregister(const string& prefix) {
+  mutex_lock l(mu_);
+  auto it = checkpoints_.find(prefix);
+  DCHECK(it != checkpoints_.end());
+  if (--it->second.num_registrations == 0) {
+    checkpoints_.erase(it);
+  }
+  // Sessions that finished restoring no longer need entries they did not
+  // keep, e.g. because restore failed or variables were copied.
+  PruneLocked();
+}
+
+string SharedTensorStore::GetCheckpointFingerprint(const string& prefix) const {
+  tf_shared_lock l(mu_);
+  auto it = checkpoints_.find(prefix);
+  if (it == checkpoints_.end() || it->second.conflicting) return "";
+  return it->second.fingerprint;
+}
+
+string SharedTensorStore::MakeKey(const string& fingerprint,
+                                  const string& tensor_name,
+                                  const string& shape_and_slice) {
+  // Tensor names and slice specs may contain any character but '\0'.
+  return absl::StrCat(fingerprint, absl::string_view("\0", 1), tensor_name,
+                      absl::string_view("\0", 1), shape_and_slice);
+}
+
+bool SharedTensorStore::Contains(const string& key) const {
+  tf_shared_lock l(mu_);
+  return tensors_.contains(key);
+}
+
+bool SharedTensorStore::Lookup(const string& key, Tensor* tensor) {
+  mutex_lock l(mu_);
+  auto it = tensors_.find(key);
+  if (it == tensors_.end()) return false;
+  *tensor = it->second;
+  ++num_hits_;
+  return true;
+}
+
+void SharedTensorStore::Insert(const string& key, Tensor* tensor) {
+  mutex_lock l(mu_);
+  auto it = tensors_.emplace(key, *tensor);
+  if (!it.second) {
+    *tensor = it.first->second;
+    return;
+  }
+  // Amortize pruning over insertions.
+  if (++num_inserts_since_prune_ > static_cast<int64_t>(tensors_.size())) {
+    PruneLocked();
+  }
+}
+
+void SharedTensorStore::Prune() {
+  mutex_lock l(mu_);
+  PruneLocked();
+}
+
+void SharedTensorStore::PruneLocked() {
+  num_inserts_since_prune_ = 0;
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    const Tensor& tensor = it->second;
+    // RefCountIsOne() is false for buffers that do not own their memory, such
+    // as mapped checkpoint data, so their reference count is checked directly.
+    if (tensor.NumElements() == 0 || tensor.RefCountIsOne() ||
+        tensor.RefCount() == 1) {
+      tensors_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int64_t SharedTensorStore::num_entries() const {
+  tf_shared_lock l(mu_);
+  return tensors_.size();
+}
+
+int64_t SharedTensorStore::num_hits() const {
+  tf_shared_lock l(mu_);
+  return num_hits_;
+}
+
+}  // namespace tensorflow
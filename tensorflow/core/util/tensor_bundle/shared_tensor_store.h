@@ -0,0 +1,122 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A process-wide store of tensors restored from checkpoints, addressed by the
+// content fingerprint of the checkpoint and the key and slice of the tensor,
+// so that sessions restoring the same checkpoint (e.g. replicas or versions
+// of a SavedModel with identical variables) share one buffer per tensor.
+//
+// Sharing relies on the copy-on-write semantics of the runtime: resource
+// variables copy their tensor before mutating it if its buffer is shared, and
+// no kernel forwards an input buffer to an output unless it holds the only
+// reference. Tensors handed out by the store must therefore never be written
+// to in place by other means.
+//
+// Restores only consult the store for checkpoint prefixes that have been
+// registered with `RegisterCheckpoint()`, e.g. by the SavedModel loader.
+//
+// Entries are dropped once the store holds the only reference to their
+// buffer, i.e. all sessions using them have released them.
+class SharedTensorStore {
+ public:
+  SharedTensorStore() = default;
+
+  static SharedTensorStore* Global();
+
+  // Keeps a checkpoint prefix registered while alive.
+  class Registration {
+   public:
+    ~Registration();
+
+   private:
+    friend class SharedTensorStore;
+    Registration(SharedTensorStore* store, string prefix)
+        : store_(store), prefix_(std::move(prefix)) {}
+
+    SharedTensorStore* const store_;
+    const string prefix_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Registration);
+  };
+
+  // Declares that the checkpoint at `prefix` has content `fingerprint` until
+  // the returned registration is destroyed. Registering a prefix that is
+  // already registered with a different fingerprint disables sharing for it
+  // until all its registrations are gone.
+  std::unique_ptr<Registration> RegisterCheckpoint(const string& prefix,
+                                                   const string& fingerprint);
+
+  // Returns the fingerprint registered for `prefix`, or the empty string.
+  string GetCheckpointFingerprint(const string& prefix) const;
+
+  // Returns the key of the tensor `tensor_name`, restored with
+  // `shape_and_slice`, from a checkpoint with content `fingerprint`.
+  static string MakeKey(const string& fingerprint, const string& tensor_name,
+                        const string& shape_and_slice);
+
+  bool Contains(const string& key) const;
+
+  // Sets `*tensor` to the tensor stored under `key` and returns true, or
+  // returns false if there is none.
+  bool Lookup(const string& key, Tensor* tensor);
+
+  // Stores `*tensor` under `key`, unless another tensor has already been
+  // stored under it, in which case `*tensor` is replaced with that one.
+  void Insert(const string& key, Tensor* tensor);
+
+  // Drops the entries whose buffer is referenced only by the store.
+  void Prune();
+
+  int64_t num_entries() const;
+  int64_t num_hits() const;
+
+ private:
+  struct CheckpointInfo {
+    string fingerprint;
+    int num_registrations = 0;
+    bool conflicting = false;
+  };
+
+  void Unregister(const string& prefix);
+  void PruneLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  absl::flat_hash_map<string, CheckpointInfo> checkpoints_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<string, Tensor> tensors_ TF_GUARDED_BY(mu_);
+  // Number of insertions since the last pruning.
+  int64_t num_inserts_since_prune_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_hits_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedTensorStore);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
@@ -0,0 +1,94 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(SharedTensorStoreTest, Registration) {
+  SharedTensorStore store;
+  EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "");
+  {
+    auto r1 = store.RegisterCheckpoint("/ckpt", "123");
+    EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "123");
+    {
+      auto r2 = store.RegisterCheckpoint("/ckpt", "123");
+    }
+    EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "123");
+  }
+  EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "");
+}
+
+TEST(SharedTensorStoreTest, ConflictingRegistration) {
+  SharedTensorStore store;
+  auto r1 = store.RegisterCheckpoint("/ckpt", "123");
+  {
+    auto r2 = store.RegisterCheckpoint("/ckpt", "456");
+    EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "");
+  }
+  // Still conflicting as long as the first registration lives.
+  EXPECT_EQ(store.GetCheckpointFingerprint("/ckpt"), "");
+}
+
+TEST(SharedTensorStoreTest, InsertAndLookup) {
+  SharedTensorStore store;
+  const string key = SharedTensorStore::MakeKey("123", "w", "");
+  EXPECT_NE(key, SharedTensorStore::MakeKey("123", "w", "4 0,2"));
+  EXPECT_NE(key, SharedTensorStore::MakeKey("12", "3w", ""));
+
+  Tensor t;
+  EXPECT_FALSE(store.Lookup(key, &t));
+
+  Tensor first = test::AsTensor<float>({1, 2, 3});
+  store.Insert(key, &first);
+  EXPECT_TRUE(store.Lookup(key, &t));
+  EXPECT_TRUE(t.SharesBufferWith(first));
+  EXPECT_EQ(store.num_hits(), 1);
+
+  // A racing insertion of the same key gets the stored tensor back.
+  Tensor second = test::AsTensor<float>({1, 2, 3});
+  store.Insert(key, &second);
+  EXPECT_TRUE(second.SharesBufferWith(first));
+  EXPECT_EQ(store.num_entries(), 1);
+}
+
+TEST(SharedTensorStoreTest, PruneDropsUnreferencedTensors) {
+  SharedTensorStore store;
+  const string key_a = SharedTensorStore::MakeKey("123", "a", "");
+  const string key_b = SharedTensorStore::MakeKey("123", "b", "");
+  Tensor a = test::AsTensor<float>({1, 2, 3});
+  {
+    Tensor b = test::AsTensor<float>({4, 5, 6});
+    store.Insert(key_a, &a);
+    store.Insert(key_b, &b);
+  }
+  store.Prune();
+  EXPECT_EQ(store.num_entries(), 1);
+  Tensor t;
+  EXPECT_TRUE(store.Lookup(key_a, &t));
+  EXPECT_FALSE(store.Lookup(key_b, &t));
+
+  a = Tensor();
+  t = Tensor();
+  store.Prune();
+  EXPECT_EQ(store.num_entries(), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
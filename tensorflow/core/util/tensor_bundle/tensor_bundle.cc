@@ -15,11 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -30,12 +32,14 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/table_builder.h"
+#include "tensorflow/core/lib/math/math_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/bfloat16.h"
 #include "tensorflow/core/platform/cord.h"
@@ -48,6 +52,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap_tensor.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_slice_util.h"
@@ -79,6 +84,11 @@ const int64_t kLargeTensorThreshold = static_cast<int64_t>(1) << 32;
 const int kMaxFileReadThreads = 8;
 // Minimum size of a file section handled by each thread.
 const int64_t kMinSectionSize = static_cast<int64_t>(1) << 31;
+// Maximum size of a tensor section read by one task in LookupMany().
+const int64_t kMaxConcurrentSectionSize = static_cast<int64_t>(1) << 26;
+// Minimum number of bytes read by one task in LookupMany(), to amortize the
+// scheduling of small tensors.
+const int64_t kMinConcurrentTaskSize = static_cast<int64_t>(1) << 20;
 
 namespace {
 
@@ -362,6 +372,75 @@ Status WriteVariantTensor(const Tensor& val, tsl::BufferedWritableFile* out,
   return OkStatus();
 }
 
+// A TensorBuffer aliasing part of a read-only memory mapping, which it keeps
+// alive. It does not own its memory, so that no kernel forwards it as an
+// output buffer or otherwise updates it in place.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const void* data, size_t size)
+      : TensorBuffer(const_cast<void*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("BundleReaderMapped");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// Returns the product of the 32x32 GF(2) matrix "mat" and the vector "vec".
+uint32 Gf2MatrixTimes(const uint32* mat, uint32 vec) {
+  uint32 sum = 0;
+  for (; vec != 0; vec >>= 1, ++mat) {
+    if (vec & 1) sum ^= *mat;
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32* square, const uint32* mat) {
+  for (int n = 0; n < 32; ++n) square[n] = Gf2MatrixTimes(mat, mat[n]);
+}
+
+// Returns the crc32c of the concatenation of two byte sequences, given the
+// crc32c "crc1" of the first one, and the crc32c "crc2" and length "len2" of
+// the second one. This lets sections of a tensor be checksummed concurrently.
+// Follows crc32_combine() of zlib, with the Castagnoli polynomial.
+uint32 Crc32cCombine(uint32 crc1, uint32 crc2, int64_t len2) {
+  if (len2 <= 0) return crc1;
+
+  uint32 even[32];  // Operator for an even power of two zero bits.
+  uint32 odd[32];   // Operator for an odd power of two zero bits.
+  odd[0] = 0x82f63b78u;  // The reflected Castagnoli polynomial.
+  uint32 row = 1;
+  for (int n = 1; n < 32; ++n) {
+    odd[n] = row;
+    row <<= 1;
+  }
+  Gf2MatrixSquare(even, odd);  // One zero byte is two squarings away.
+  Gf2MatrixSquare(odd, even);
+
+  // Applies len2 zero bytes to crc1.
+  do {
+    Gf2MatrixSquare(even, odd);
+    if (len2 & 1) crc1 = Gf2MatrixTimes(even, crc1);
+    len2 >>= 1;
+    if (len2 == 0) break;
+    Gf2MatrixSquare(odd, even);
+    if (len2 & 1) crc1 = Gf2MatrixTimes(odd, crc1);
+    len2 >>= 1;
+  } while (len2 != 0);
+  return crc1 ^ crc2;
+}
+
 // Returns whether "slice_spec" is a full slice, with respect to the full shape.
 //
 // This can happen say, when "slice_spec" is
@@ -736,10 +815,19 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
         DataFilename(merged_prefix, p.second, merge.shard_ids.size())));
   }
 
-  // Writes the final metadata table under the merged prefix.
+  // Writes the final metadata table under the merged prefix. Like
+  // BundleWriter::Finish(), writes it to a temporary file first where the
+  // filesystem can rename atomically, so that readers never see a partially
+  // written index.
+  const string metadata_path = MetaFilename(merged_prefix);
+  bool use_temp_file = false;
+  TF_RETURN_IF_ERROR(env->HasAtomicMove(metadata_path, &use_temp_file));
+  const string write_path =
+      use_temp_file
+          ? strings::StrCat(metadata_path, ".tempstate", random::New64())
+          : metadata_path;
   std::unique_ptr<WritableFile> merged_metadata;
-  TF_RETURN_IF_ERROR(
-      env->NewWritableFile(MetaFilename(merged_prefix), &merged_metadata));
+  TF_RETURN_IF_ERROR(env->NewWritableFile(write_path, &merged_metadata));
   {
     table::TableBuilder builder(TableBuilderOptions(), merged_metadata.get());
     // Header entry.
@@ -755,7 +843,13 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
     status = builder.Finish();
   }
   status.Update(merged_metadata->Close());
-  if (!status.ok()) return status;
+  if (status.ok() && use_temp_file) {
+    status = env->RenameFile(write_path, metadata_path);
+  }
+  if (!status.ok()) {
+    if (use_temp_file) env->DeleteFile(write_path).IgnoreError();
+    return status;
+  }
   VLOG(1) << "Merged bundles to:" << merged_prefix;
 
   // Cleanup: best effort based and ignores errors.
@@ -778,6 +872,10 @@ BundleReader::BundleReader(
       iter_(nullptr),
       need_to_swap_bytes_(false),
       enable_multi_threading_for_testing_(enable_multi_threading_for_testing) {
+  // The checkpoint may still be being written by an asynchronous save.
+  status_ = AsyncCheckpointWriter::Global()->Wait(prefix_);
+  if (!status_.ok()) return;
+
   const string filename = MetaFilename(prefix_);
   uint64 file_size;
   status_ = env_->GetFileSize(filename, &file_size);
@@ -869,6 +967,21 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return OkStatus();
 }
 
+Status BundleReader::GetDataFile(int32_t shard_id,
+                                 io::InputBuffer** buffered_file) {
+  // Open the data file if it has not been opened.
+  io::InputBuffer*& file_buffer = data_[shard_id];
+  if (file_buffer == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    file_buffer = new io::InputBuffer(file.release(), kBufferSize);
+  }
+  *buffered_file = file_buffer;
+  return OkStatus();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
@@ -898,17 +1011,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -1024,6 +1128,220 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMany(gtl::ArraySlice<string> keys,
+                                gtl::ArraySlice<Tensor*> vals,
+                                thread::ThreadPool* pool) {
+  CHECK_EQ(keys.size(), vals.size());
+  if (pool == nullptr || pool->NumThreads() <= 1) {
+    for (int i = 0; i < keys.size(); ++i) {
+      TF_RETURN_IF_ERROR(Lookup(keys[i], vals[i]));
+    }
+    return OkStatus();
+  }
+
+  // A section of a tensor that is read and checksummed by one task.
+  struct Section {
+    int tensor_index;
+    RandomAccessFile* file;
+    uint64 file_offset;
+    char* buffer;
+    int64_t size;
+    uint32 crc32c = 0;
+    Status status;
+  };
+  std::vector<BundleEntryProto> entries(keys.size());
+  std::vector<Section> sections;
+  std::vector<int> serial_reads;
+  for (int i = 0; i < keys.size(); ++i) {
+    BundleEntryProto& entry = entries[i];
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype())) {
+      serial_reads.push_back(i);
+      continue;
+    }
+
+    Tensor* val = vals[i];
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+    }
+    if (entry.size() != val->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", val->TotalBytes());
+    }
+    io::InputBuffer* buffered_file;
+    TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+
+    const int64_t size = entry.size();
+    int64_t num_sections =
+        std::max<int64_t>(1, MathUtil::CeilOfRatio(size,
+                                                   kMaxConcurrentSectionSize));
+    if (enable_multi_threading_for_testing_) {
+      num_sections = std::max<int64_t>(1, std::min<int64_t>(
+                                              size, kMaxFileReadThreads));
+    }
+    const int64_t section_size =
+        std::max<int64_t>(1, MathUtil::CeilOfRatio(size, num_sections));
+    char* backing_buffer = const_cast<char*>(val->tensor_data().data());
+    int64_t offset = 0;
+    do {
+      Section section;
+      section.tensor_index = i;
+      section.file = buffered_file->file();
+      section.file_offset = entry.offset() + offset;
+      section.buffer = backing_buffer + offset;
+      section.size = std::min(section_size, size - offset);
+      sections.push_back(std::move(section));
+      offset += section_size;
+    } while (offset < size);
+  }
+
+  // Groups consecutive sections into tasks of at least
+  // kMinConcurrentTaskSize bytes.
+  std::vector<std::pair<size_t, size_t>> tasks;
+  for (size_t begin = 0; begin < sections.size();) {
+    size_t end = begin;
+    int64_t task_size = 0;
+    while (end < sections.size() && task_size < kMinConcurrentTaskSize) {
+      task_size += sections[end++].size;
+    }
+    tasks.emplace_back(begin, end);
+    begin = end;
+  }
+
+  BlockingCounter counter(tasks.size());
+  for (const auto& task : tasks) {
+    pool->Schedule([&sections, &counter, task]() {
+      for (size_t j = task.first; j < task.second; ++j) {
+        Section& section = sections[j];
+        if (section.size == 0) continue;
+        StringPiece sp;
+        section.status = section.file->Read(section.file_offset, section.size,
+                                            &sp, section.buffer);
+        if (!section.status.ok()) continue;
+        if (sp.data() != section.buffer) {
+          memmove(section.buffer, sp.data(), section.size);
+        }
+        section.crc32c = crc32c::Value(section.buffer, section.size);
+      }
+      counter.DecrementCount();
+    });
+  }
+
+  // Reads the other tensors from this thread meanwhile. Only the sections'
+  // RandomAccessFiles are shared with the tasks, which are thread-safe.
+  Status status;
+  for (int i : serial_reads) {
+    const BundleEntryProto& entry = entries[i];
+    if (entry.slices().empty()) {
+      status = GetValue(entry, vals[i]);
+    } else {
+      status = GetSliceValue(
+          keys[i], entry,
+          /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()),
+          vals[i]);
+    }
+    if (!status.ok()) break;
+  }
+  counter.Wait();
+  TF_RETURN_IF_ERROR(status);
+
+  // Combines the checksums of the sections of each tensor, in order.
+  for (size_t j = 0; j < sections.size();) {
+    const int i = sections[j].tensor_index;
+    uint32 actual_crc32c = 0;
+    for (; j < sections.size() && sections[j].tensor_index == i; ++j) {
+      TF_RETURN_IF_ERROR(sections[j].status);
+      actual_crc32c =
+          Crc32cCombine(actual_crc32c, sections[j].crc32c, sections[j].size);
+    }
+    const BundleEntryProto& entry = entries[i];
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+    if (need_to_swap_bytes_) {
+      TF_RETURN_IF_ERROR(ByteSwapTensor(vals[i]));
+    }
+  }
+  return OkStatus();
+}
+
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+
+  if (entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && entry.size() > 0 &&
+      entry.offset() % std::max(EIGEN_MAX_ALIGN_BYTES, 1) == 0) {
+    std::shared_ptr<ReadOnlyMemoryRegion> region;
+    GetMappedDataFile(entry.shard_id(), &region);
+    if (region != nullptr) return GetMappedValue(entry, region, val);
+  }
+
+  *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+  if (entry.slices().empty()) {
+    return GetValue(entry, val);
+  } else {
+    return GetSliceValue(
+        key, entry,
+        /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()), val);
+  }
+}
+
+void BundleReader::GetMappedDataFile(
+    int32_t shard_id, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  auto it = mapped_data_.find(shard_id);
+  if (it == mapped_data_.end()) {
+    const string filename = DataFilename(prefix_, shard_id, num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &mapped);
+    if (!s.ok()) {
+      VLOG(1) << "Reading " << filename << " instead of mapping it: " << s;
+    }
+    it = mapped_data_.emplace(shard_id, std::move(mapped)).first;
+  }
+  *region = it->second;
+}
+
+Status BundleReader::GetMappedValue(
+    const BundleEntryProto& entry,
+    const std::shared_ptr<ReadOnlyMemoryRegion>& region, Tensor* val) {
+  const TensorShape stored_shape(entry.shape());
+  const uint64 expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        region->length(), " bytes) is too short for a tensor of ", entry.size(),
+        " bytes at offset ", entry.offset());
+  }
+
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the mapped bytes ", actual_crc32c);
+  }
+
+  auto* buffer = new MappedTensorBuffer(region, data, entry.size());
+  *val = Tensor(entry.dtype(), stored_shape, buffer);
+  buffer->Unref();
+  return OkStatus();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
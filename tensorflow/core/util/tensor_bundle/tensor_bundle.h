@@ -75,6 +75,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
@@ -117,7 +118,10 @@ class BundleWriter {
   struct Options {
     Options() {}
     // Alignment, in bytes, for tensor data.
-    // Must be >= 1. The default size of 1 densely packs tensors.
+    // Must be >= 1. The default size of 1 densely packs tensors. Tensors
+    // aligned to at least EIGEN_MAX_ALIGN_BYTES can be restored without a copy
+    // by BundleReader::LookupMapped(); aligning to the page size additionally
+    // keeps each tensor on pages of its own.
     int data_alignment{1};
   };
   BundleWriter(Env* env, absl::string_view prefix,
@@ -178,6 +182,9 @@ class BundleWriter {
 // query information about a tensor.  In particular, this function does not
 // guarantee not to re-order the input data files.
 //
+// The merged metadata file is written last, and atomically renamed into place
+// on filesystems that support atomic moves.
+//
 // Once merged, makes a best effort to delete the old metadata files.
 // Returns OK iff all bundles are successfully merged.
 //
@@ -250,6 +257,37 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys" into "vals" like "Lookup()", with
+  // the same requirements on "vals". The non-partitioned tensors of
+  // memcpy-able dtypes are read and checksummed concurrently on "pool", large
+  // ones in several sections, while the others are read from the calling
+  // thread. If "pool" is null, all tensors are read from the calling thread.
+  //
+  // Validates the stored crc32c checksums against the restored bytes.
+  // REQUIRES: status().ok() && keys.size() == vals.size()
+  Status LookupMany(gtl::ArraySlice<std::string> keys,
+                    gtl::ArraySlice<Tensor*> vals,
+                    thread::ThreadPool* pool) TF_MUST_USE_RESULT;
+
+  // Looks up the tensor keyed by "key" like "Lookup()", but allocates "val"
+  // itself and, where possible, makes it alias a read-only memory mapping of
+  // the data file instead of reading its contents into a new buffer.
+  //
+  // This is possible for non-partitioned tensors of memcpy-able dtypes that
+  // were written with the endianness of this machine at an offset aligned to
+  // EIGEN_MAX_ALIGN_BYTES (see BundleWriter::Options::data_alignment), in a
+  // file system that supports Env::NewReadOnlyMemoryRegionFromFile(). Other
+  // tensors are read as by "Lookup()".
+  //
+  // A mapped tensor does not own its memory, so kernels never modify it in
+  // place; e.g. resource variables copy it before their first update. The
+  // mapping is kept alive by the tensors referencing it and may outlive the
+  // reader.
+  //
+  // Validates the stored crc32c checksum against the mapped bytes.
+  // REQUIRES: status().ok()
+  Status LookupMapped(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -303,11 +341,27 @@ class BundleReader {
   Status GetBundleEntryProto(absl::string_view key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Sets "buffered_file" to the buffered data file "shard_id", opening it if
+  // needed.
+  Status GetDataFile(int32_t shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Sets "val" to a tensor aliasing the mapped contents of the tensor described
+  // by "entry" in "region".
+  Status GetMappedValue(const BundleEntryProto& entry,
+                        const std::shared_ptr<ReadOnlyMemoryRegion>& region,
+                        Tensor* val) TF_MUST_USE_RESULT;
+
+  // Sets "region" to the memory mapping of data file "shard_id", or to null if
+  // the file cannot be mapped.
+  void GetMappedDataFile(int32_t shard_id,
+                         std::shared_ptr<ReadOnlyMemoryRegion>* region);
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -326,6 +380,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32_t, io::InputBuffer*> data_;
+  // Memory mappings of the data files used by LookupMapped(), or null for
+  // files that could not be mapped.
+  std::unordered_map<int32_t, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -23,6 +23,8 @@ limitations under the License.
 #include <windows.h>
 #endif  // _WIN32
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -38,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap_tensor.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 
@@ -1201,6 +1205,134 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+string MappedAllocatorName(const Tensor& t) {
+  TensorDescription description;
+  t.FillDescription(&description);
+  return description.allocation_description().allocator_name();
+}
+
+TEST(TensorBundleTest, LookupMapped) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 4096;
+    BundleWriter writer(Env::Default(), Prefix("mapped"), opts);
+    TF_EXPECT_OK(writer.Add("float", Constant_100x100<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("int", Constant_2x3<int32>(7)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor float_val;
+  {
+    BundleReader reader(Env::Default(), Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.LookupMapped("float", &float_val));
+    EXPECT_EQ(MappedAllocatorName(float_val), "BundleReaderMapped");
+    EXPECT_TRUE(float_val.IsAligned());
+    // Mapped tensors are never updated in place.
+    EXPECT_FALSE(float_val.RefCountIsOne());
+
+    Tensor int_val;
+    TF_ASSERT_OK(reader.LookupMapped("int", &int_val));
+    EXPECT_EQ(MappedAllocatorName(int_val), "BundleReaderMapped");
+    test::ExpectTensorEqual<int32>(int_val, Constant_2x3<int32>(7));
+
+    // Strings are read into a new buffer.
+    Tensor string_val;
+    TF_ASSERT_OK(reader.LookupMapped("string", &string_val));
+    EXPECT_NE(MappedAllocatorName(string_val), "BundleReaderMapped");
+    test::ExpectTensorEqual<tstring>(string_val, Constant_2x3<tstring>("foo"));
+
+    Tensor missing;
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMapped("missing", &missing)));
+  }
+  // The mapping outlives the reader.
+  test::ExpectTensorEqual<float>(float_val, Constant_100x100<float>(1.5));
+}
+
+TEST(TensorBundleTest, LookupMappedUnaligned) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("unaligned"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.LookupMapped("b", &val));
+  EXPECT_NE(MappedAllocatorName(val), "BundleReaderMapped");
+  EXPECT_TRUE(val.IsAligned());
+  test::ExpectTensorEqual<float>(val, Constant_2x3<float>(2));
+}
+
+TEST(TensorBundleTest, LookupMany) {
+  const TensorShape kFullShape({5, 10});
+  Tensor random_val(DT_FLOAT, TensorShape({1000}));
+  test::FillFn<float>(&random_val, [](int i) -> float { return i * 0.37f; });
+  {
+    BundleWriter writer(Env::Default(), Prefix("many"));
+    TF_ASSERT_OK(writer.Add("random", random_val));
+    TF_ASSERT_OK(writer.Add("int", Constant_2x3<int32>(7)));
+    TF_ASSERT_OK(writer.Add("empty", Constant<float>(1., TensorShape({0}))));
+    TF_ASSERT_OK(writer.Add("string", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.AddSlice("sliced", kFullShape,
+                                 TensorSlice::ParseOrDie("-:0,1"),
+                                 Constant<float>(2., TensorShape({5, 1}))));
+    TF_ASSERT_OK(writer.AddSlice("sliced", kFullShape,
+                                 TensorSlice::ParseOrDie("-:1,9"),
+                                 Constant<float>(2., TensorShape({5, 9}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  thread::ThreadPool* no_pool = nullptr;
+  for (thread::ThreadPool* lookup_pool : {&pool, no_pool}) {
+    // Splits each tensor into several sections read concurrently.
+    BundleReader reader(Env::Default(), Prefix("many"),
+                        /*enable_multi_threading_for_testing=*/true);
+    TF_ASSERT_OK(reader.status());
+    Tensor random(DT_FLOAT, TensorShape({1000}));
+    Tensor int_val(DT_INT32, TensorShape({2, 3}));
+    Tensor empty;
+    Tensor string_val(DT_STRING, TensorShape({2, 3}));
+    Tensor sliced(DT_FLOAT, kFullShape);
+    TF_ASSERT_OK(reader.LookupMany(
+        {"random", "int", "empty", "string", "sliced"},
+        {&random, &int_val, &empty, &string_val, &sliced}, lookup_pool));
+    test::ExpectTensorEqual<float>(random, random_val);
+    test::ExpectTensorEqual<int32>(int_val, Constant_2x3<int32>(7));
+    EXPECT_EQ(empty.NumElements(), 0);
+    test::ExpectTensorEqual<tstring>(string_val, Constant_2x3<tstring>("foo"));
+    test::ExpectTensorEqual<float>(sliced, Constant<float>(2., kFullShape));
+
+    Tensor missing;
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMany(
+        {"int", "missing"}, {&int_val, &missing}, lookup_pool)));
+  }
+}
+
+TEST(TensorBundleTest, ReaderWaitsForAsyncWrite) {
+  const string prefix = Prefix("async");
+  TF_ASSERT_OK(AsyncCheckpointWriter::Global()->Schedule(prefix, [prefix]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    BundleWriter writer(Env::Default(), prefix);
+    TF_RETURN_IF_ERROR(writer.Add("int", Constant_2x3<int32>(7)));
+    return writer.Finish();
+  }));
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("int", &val));
+  test::ExpectTensorEqual<int32>(val, Constant_2x3<int32>(7));
+
+  // Errors of the write are reported by the reader.
+  const string failed_prefix = Prefix("async_failed");
+  TF_ASSERT_OK(AsyncCheckpointWriter::Global()->Schedule(
+      failed_prefix, []() { return errors::Internal("write failed"); }));
+  EXPECT_TRUE(
+      errors::IsInternal(BundleReader(Env::Default(), failed_prefix).status()));
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
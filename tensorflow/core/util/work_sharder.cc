@@ -16,10 +16,15 @@ limitations under the License.
 #include "tensorflow/core/util/work_sharder.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <optional>
+#include <utility>
 
 #include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/shard_cost_table.h"
 #include "tsl/profiler/lib/traceme.h"
 #include "tsl/util/env_var.h"
 
@@ -54,6 +59,59 @@ void SetPerThreadMaxParallelism(int max_parallelism) {
 
 int GetPerThreadMaxParallelism() { return per_thread_max_parallelism; }
 
+/* ABSL_CONST_INIT */ thread_local ShardStatsRecorder*
+    per_thread_shard_stats_recorder = nullptr;
+
+void SetPerThreadShardStatsRecorder(ShardStatsRecorder* recorder) {
+  per_thread_shard_stats_recorder = recorder;
+}
+
+ShardStatsRecorder* GetPerThreadShardStatsRecorder() {
+  return per_thread_shard_stats_recorder;
+}
+
+namespace {
+
+// Wraps `work` so that the number of shards and the time spent in them are
+// accumulated, and reports them to `recorder` on destruction.
+class TimedShardWork {
+ public:
+  TimedShardWork(ShardStatsRecorder* recorder,
+                 std::function<void(int64_t, int64_t)> work)
+      : recorder_(recorder),
+        work_(std::move(work)),
+        start_nanos_(Env::Default()->NowNanos()) {}
+
+  ~TimedShardWork() {
+    const int num_shards = num_shards_.load(std::memory_order_relaxed);
+    // Calls that ran inline are not interesting for parallel efficiency.
+    if (num_shards > 1) {
+      recorder_->RecordShard(num_shards,
+                             Env::Default()->NowNanos() - start_nanos_,
+                             busy_nanos_.load(std::memory_order_relaxed));
+    }
+  }
+
+  std::function<void(int64_t, int64_t)> AsFunction() {
+    return [this](int64_t start, int64_t limit) {
+      const uint64 shard_start = Env::Default()->NowNanos();
+      work_(start, limit);
+      busy_nanos_.fetch_add(Env::Default()->NowNanos() - shard_start,
+                            std::memory_order_relaxed);
+      num_shards_.fetch_add(1, std::memory_order_relaxed);
+    };
+  }
+
+ private:
+  ShardStatsRecorder* const recorder_;
+  const std::function<void(int64_t, int64_t)> work_;
+  const uint64 start_nanos_;
+  std::atomic<int> num_shards_{0};
+  std::atomic<int64_t> busy_nanos_{0};
+};
+
+}  // namespace
+
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
            int64_t cost_per_unit, std::function<void(int64_t, int64_t)> work) {
   CHECK_GE(total, 0);
@@ -61,11 +119,47 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
     return;
   }
   max_parallelism = std::min(max_parallelism, GetPerThreadMaxParallelism());
+  const ShardCostModelMode cost_model_mode = GetShardCostModelMode();
+  const string cost_key = cost_model_mode == ShardCostModelMode::kStatic
+                              ? string()
+                              : NextShardCallCostKey();
+  if (!cost_key.empty()) {
+    switch (cost_model_mode) {
+      case ShardCostModelMode::kStatic:
+        break;
+      case ShardCostModelMode::kCalibrate:
+        work = [work = std::move(work), cost_key](int64_t start,
+                                                  int64_t limit) {
+          const uint64 start_nanos = Env::Default()->NowNanos();
+          work(start, limit);
+          ShardCostTable::Global()->Record(
+              cost_key, limit - start,
+              Env::Default()->NowNanos() - start_nanos);
+        };
+        break;
+      case ShardCostModelMode::kCalibrated: {
+        // Look up the cost for the block size used at full parallelism.
+        const int64_t parallelism =
+            std::max(1, std::min(max_parallelism, workers->NumThreads() + 1));
+        const int64_t measured_cost = ShardCostTable::Global()->CostPerUnit(
+            cost_key, (total + parallelism - 1) / parallelism);
+        if (measured_cost > 0) {
+          cost_per_unit = measured_cost;
+        }
+        break;
+      }
+    }
+  }
   if (max_parallelism <= 1) {
     // Just inline the whole work since we only have 1 thread (core).
     work(0, total);
     return;
   }
+  std::optional<TimedShardWork> timed_work;
+  if (ShardStatsRecorder* recorder = GetPerThreadShardStatsRecorder()) {
+    timed_work.emplace(recorder, std::move(work));
+    work = timed_work->AsFunction();
+  }
   if (UseEigenParallelFor() && max_parallelism >= workers->NumThreads()) {
     tsl::profiler::TraceMe trace_me([=, num_threads = workers->NumThreads()]() {
       return tsl::profiler::TraceMeEncode("ParallelFor",
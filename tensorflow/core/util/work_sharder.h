@@ -42,6 +42,9 @@ namespace tensorflow {
 // Context creation. Underestimating may not fully make use of the specified
 // parallelism.
 //
+// If the calling thread has a shard cost key (see shard_cost_table.h),
+// "cost_per_unit" may be replaced by a measured cost.
+//
 // "work" should be a callable taking (int64, int64) arguments.
 // work(start, limit) computes the work units from [start,
 // limit), i.e., [start, limit) is a shard.
@@ -84,6 +87,39 @@ class ScopedPerThreadMaxParallelism {
   int previous_ = -1;
 };
 
+// Receives timing of the Shard() calls made by a thread, e.g. to measure how
+// efficiently intra-op parallelism is being used. `wall_nanos` is the elapsed
+// time of one Shard() call, and `busy_nanos` the sum over its `num_shards`
+// shards of the time spent in `work`. Implementations must be thread-safe.
+class ShardStatsRecorder {
+ public:
+  virtual ~ShardStatsRecorder() = default;
+  virtual void RecordShard(int num_shards, int64_t wall_nanos,
+                           int64_t busy_nanos) = 0;
+};
+
+// Each thread has an associated, optional recorder that is notified of every
+// Shard() call that actually ran in parallel. Its default is nullptr, in which
+// case Shard() does no timing.
+void SetPerThreadShardStatsRecorder(ShardStatsRecorder* recorder);
+ShardStatsRecorder* GetPerThreadShardStatsRecorder();
+
+// Helper to set and unset the per-thread shard stats recorder.
+class ScopedPerThreadShardStatsRecorder {
+ public:
+  explicit ScopedPerThreadShardStatsRecorder(ShardStatsRecorder* recorder)
+      : previous_(GetPerThreadShardStatsRecorder()) {
+    SetPerThreadShardStatsRecorder(recorder);
+  }
+
+  ~ScopedPerThreadShardStatsRecorder() {
+    SetPerThreadShardStatsRecorder(previous_);
+  }
+
+ private:
+  ShardStatsRecorder* previous_ = nullptr;
+};
+
 // Implementation details for Shard().
 class Sharder {
  public:
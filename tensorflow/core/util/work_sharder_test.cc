@@ -93,6 +93,41 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+class CountingShardStatsRecorder : public ShardStatsRecorder {
+ public:
+  void RecordShard(int num_shards, int64_t wall_nanos,
+                   int64_t busy_nanos) override {
+    ++num_calls;
+    total_shards += num_shards;
+    EXPECT_GE(wall_nanos, 0);
+    EXPECT_GE(busy_nanos, 0);
+  }
+
+  int num_calls = 0;
+  int64_t total_shards = 0;
+};
+
+TEST(Shard, StatsRecorder) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  CountingShardStatsRecorder recorder;
+  {
+    ScopedPerThreadShardStatsRecorder scope(&recorder);
+    EXPECT_EQ(GetPerThreadShardStatsRecorder(), &recorder);
+    // Large enough to be split into several shards.
+    std::atomic<int64_t> num_elements(0);
+    Shard(4, &threads, 1 << 20, 1000,
+          [&num_elements](int64_t start, int64_t limit) {
+            num_elements += limit - start;
+          });
+    EXPECT_EQ(num_elements.load(), 1 << 20);
+    // Runs inline, and is not reported.
+    Shard(1, &threads, 100, 1, [](int64_t start, int64_t limit) {});
+  }
+  EXPECT_EQ(GetPerThreadShardStatsRecorder(), nullptr);
+  EXPECT_EQ(recorder.num_calls, 1);
+  EXPECT_GT(recorder.total_shards, 1);
+}
+
 void BM_Sharding(::testing::benchmark::State& state) {
   const int arg = state.range(0);
 
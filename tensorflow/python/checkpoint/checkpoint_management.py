@@ -33,6 +33,7 @@ from tensorflow.python.ops import variable_scope
 from tensorflow.python.platform import tf_logging as logging
 from tensorflow.python.training import training_util
 from tensorflow.python.training.checkpoint_state_pb2 import CheckpointState
+from tensorflow.python.util import _pywrap_checkpoint_reader
 from tensorflow.python.util import compat
 from tensorflow.python.util import deprecation
 from tensorflow.python.util.tf_export import tf_export
@@ -241,6 +242,15 @@ def update_checkpoint_state_internal(save_dir,
                        "checkpoint state.  Please use a different save path." %
                        model_checkpoint_path)
 
+  # With asynchronous saves (TF_CHECKPOINT_ASYNC_SAVE), the save op returns
+  # before the checkpoint is written; the state naming it is written, also
+  # atomically, once it has been.
+  if _pywrap_checkpoint_reader.ScheduleWriteFileAfterCheckpointWrite(
+      compat.as_str(model_checkpoint_path),
+      compat.as_str(coord_checkpoint_filename),
+      text_format.MessageToString(ckpt)):
+    return
+
   # Preventing potential read/write race condition by *atomically* writing to a
   # file.
   file_io.atomic_write_string_to_file(coord_checkpoint_filename,
@@ -271,6 +281,13 @@ def get_checkpoint_state(checkpoint_dir, latest_filename=None):
   ckpt = None
   coord_checkpoint_filename = _GetCheckpointFilename(checkpoint_dir,
                                                      latest_filename)
+  # Wait for the state written after an asynchronous save, if any. If that save
+  # failed, the state still names the previous checkpoints.
+  try:
+    _pywrap_checkpoint_reader.WaitForCheckpointWrite(
+        compat.as_str(coord_checkpoint_filename))
+  except errors.OpError as e:
+    logging.warning("%s: %s", type(e).__name__, e)
   f = None
   try:
     # Check that the file exists before opening it to avoid
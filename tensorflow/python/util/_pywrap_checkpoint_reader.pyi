@@ -22,3 +22,6 @@ class CheckpointReader:
     def _HasTensor(self, arg0: str) -> bool: ...
     def debug_string(self) -> bytes: ...
     def get_variable_to_shape_map(self, *args, **kwargs) -> Any: ...
+
+def ScheduleWriteFileAfterCheckpointWrite(arg0: str, arg1: str, arg2: str) -> bool: ...
+def WaitForCheckpointWrite(arg0: str) -> None: ...
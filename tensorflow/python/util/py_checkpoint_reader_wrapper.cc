@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/c/tf_status.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/util/tensor_bundle/async_checkpoint_writer.h"
 #include "tensorflow/python/lib/core/ndarray_tensor.h"
 #include "tensorflow/python/lib/core/py_exception_registry.h"
 #include "tensorflow/python/lib/core/pybind11_lib.h"
@@ -148,4 +149,34 @@ PYBIND11_MODULE(_pywrap_checkpoint_reader, m) {
       .def("_HasTensor", &tensorflow::checkpoint::CheckpointReader::HasTensor)
       .def_static("CheckpointReader_GetTensor",
                   &tensorflow::CheckpointReader_GetTensor);
+
+  // Waits for the asynchronous write of "prefix", a checkpoint or a file
+  // written after one, if any.
+  m.def("WaitForCheckpointWrite", [](const std::string& prefix) {
+    tensorflow::Status status;
+    {
+      py::gil_scoped_release release;
+      status = tensorflow::AsyncCheckpointWriter::Global()->Wait(prefix);
+    }
+    tensorflow::MaybeRaiseFromStatus(status);
+  });
+
+  // Writes "contents" to "filename" once the asynchronous save of the
+  // checkpoint at "prefix" has succeeded, without waiting for it. Returns
+  // false, without writing, if that checkpoint is not being saved.
+  m.def("ScheduleWriteFileAfterCheckpointWrite",
+        [](const std::string& prefix, const std::string& filename,
+           const std::string& contents) {
+          tensorflow::Status status;
+          bool scheduled = false;
+          {
+            py::gil_scoped_release release;
+            status =
+                tensorflow::AsyncCheckpointWriter::Global()
+                    ->ScheduleWriteFileAfter(prefix, filename, contents,
+                                             &scheduled);
+          }
+          tensorflow::MaybeRaiseFromStatus(status);
+          return scheduled;
+        });
 };